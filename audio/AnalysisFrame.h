@@ -0,0 +1,40 @@
+#ifndef ANALYSIS_FRAME_H
+#define ANALYSIS_FRAME_H
+
+#include "ChromaProcessor.h"
+#include "LoudnessMeter.h"
+#include "MultiResolutionAnalyzer.h"
+#include "SampleRing.h"
+#include "SpectralDescriptors.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Everything the analysis thread publishes for one hop. Published through a
+// TripleBuffer, so readers get a stable snapshot without copying.
+struct AnalysisFrame {
+    vector<float> magnitudes;
+    vector<float> bands;                         // SPECTRUM_BANDS, multi-resolution
+    AnalyzerCost spectrumCost;
+    LoudnessReading loudness;
+    array<float, PITCH_CLASSES> chroma;          // strongest pitch class = 1
+    array<float, CHROMA_OCTAVES> octaveEnergy;   // C1..B8
+    float percussiveRatio;                       // 0 unless separation is on
+    SpectralFeatures descriptors;                // of magnitudes
+    bool beat;                                   // onset in this hop
+    float beatStrength;
+    float tempo;                                 // BPM, 0 until locked
+    size_t samplePosition;  // source sample at the end of the analysed window
+    const SampleRing* samples;  // raw stereo feed for time-domain scenes
+    uint64_t samplesEnd;        // samples->written() as of this frame
+    uint64_t sequence;      // increments with every published frame
+    bool silent;            // window all below SILENCE_LEVEL; magnitudes and bands are zero
+};
+
+// -80 dBFS, about three 16-bit steps: dither and hiss count as silence.
+const float SILENCE_LEVEL = 1e-4f;
+
+#endif // ANALYSIS_FRAME_H
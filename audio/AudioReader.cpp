@@ -1,13 +1,22 @@
 #include "AudioReader.h"
+#include "ParallelMP3Decoder.h"
 #include <mpg123.h>
 #include <iostream>
 #include <cstring>
 #include <vector>
 #include <sndfile.h>
+#include <thread>
 
 using namespace std;
 
-AudioFileReader::AudioFileReader() : sampleRate(0) {
+// Appended to the audio file's path for a cached overview pyramid.
+static const char* OVERVIEW_SUFFIX = ".mpvw";
+
+// Frames per sf_readf_float call while loading a WAV.
+static const size_t WAV_CHUNK_FRAMES = 16384;
+
+AudioFileReader::AudioFileReader()
+    : pcmFormat(PcmFormat::Float32), overviewMode(OverviewMode::Off), sampleRate(0), decodeThreads(thread::hardware_concurrency()) {
     if (mpg123_init() != MPG123_OK) {
         cerr << "Failed to initialize mpg123 library." << endl;
     }
@@ -17,13 +26,38 @@ AudioFileReader::~AudioFileReader() {
     mpg123_exit();
 }
 
+void AudioFileReader::setDecodeThreads(size_t threads) {
+    decodeThreads = threads;
+}
+
+void AudioFileReader::setPcmFormat(PcmFormat format) {
+    pcmFormat = format;
+}
+
+void AudioFileReader::setOverviewMode(OverviewMode mode) {
+    overviewMode = mode;
+}
+
 bool AudioFileReader::loadMP3(const string& filePath) {
+    if (decodeThreads > 1) {
+        ParallelMP3Decoder decoder(decodeThreads);
+        pcm.reset(pcmFormat, 2);
+        if (decoder.decode(filePath, pcm, sampleRate)) {
+            return true;
+        }
+        cerr << "WARNING: Parallel MP3 decode failed; decoding on one thread." << endl;
+    }
+
     mpg123_handle* mh = mpg123_new(nullptr, nullptr);
     if (!mh) {
         cerr << "Failed to create mpg123 handle." << endl;
         return false;
     }
 
+    // Trim encoder delay and padding so sample offsets match the source
+    // exactly; seeking relies on this.
+    mpg123_param(mh, MPG123_ADD_FLAGS, MPG123_GAPLESS, 0.0);
+
     if (mpg123_open(mh, filePath.c_str()) != MPG123_OK) {
         cerr << "Failed to open file: " << filePath << endl;
         mpg123_delete(mh);
@@ -40,33 +74,23 @@ bool AudioFileReader::loadMP3(const string& filePath) {
     }
 
     sampleRate = static_cast<int>(rate);
+    if (channels != 1 && channels != 2) {
+        cerr << "Unsupported channel count: " << channels << endl;
+        mpg123_close(mh);
+        mpg123_delete(mh);
+        return false;
+    }
 
     size_t bufferSize = mpg123_outblock(mh);
-    unsigned char* buffer = new unsigned char[bufferSize];
+    // 16-bit output, so an Int16 store takes the samples as they are.
+    vector<int16_t> buffer(bufferSize / sizeof(int16_t));
     size_t done;
-    vector<float> interleavedData;
-
-    while (mpg123_read(mh, buffer, bufferSize, &done) == MPG123_OK) {
-        for (size_t i = 0; i < done; i += sizeof(short)) {
-            short sample = *reinterpret_cast<short*>(buffer + i);
-            interleavedData.push_back(sample / 32768.0f);
-        }
-    }
-
-    delete[] buffer;
+    pcm.reset(pcmFormat, channels);
 
-    leftChannel.clear();
-    rightChannel.clear();
-
-    if (channels == 2) {
-        for (size_t i = 0; i < interleavedData.size(); i += 2) {
-            leftChannel.push_back(interleavedData[i]);
-            rightChannel.push_back(interleavedData[i + 1]);
-        }
-    } else if (channels == 1) {
-        leftChannel = interleavedData;
-        rightChannel = interleavedData;
+    while (mpg123_read(mh, reinterpret_cast<unsigned char*>(buffer.data()), bufferSize, &done) == MPG123_OK) {
+        pcm.append(buffer.data(), done / (sizeof(int16_t) * channels));
     }
+    pcm.shrink();
 
     mpg123_close(mh);
     mpg123_delete(mh);
@@ -83,22 +107,24 @@ bool AudioFileReader::loadWAV(const string& filePath) {
     }
 
     sampleRate = sfInfo.samplerate;
-    vector<float> interleavedData(sfInfo.frames * sfInfo.channels);
-    sf_readf_float(file, interleavedData.data(), sfInfo.frames);
-    sf_close(file);
-
-    leftChannel.clear();
-    rightChannel.clear();
+    if (sfInfo.channels != 1 && sfInfo.channels != 2) {
+        cerr << "Unsupported channel count: " << sfInfo.channels << endl;
+        sf_close(file);
+        return false;
+    }
 
-    if (sfInfo.channels == 2) {
-        for (size_t i = 0; i < interleavedData.size(); i += 2) {
-            leftChannel.push_back(interleavedData[i]);
-            rightChannel.push_back(interleavedData[i + 1]);
-        }
-    } else if (sfInfo.channels == 1) {
-        leftChannel = interleavedData;
-        rightChannel = interleavedData;
+    // Read in chunks so the whole file never sits in memory as float.
+    pcm.reset(pcmFormat, sfInfo.channels);
+    pcm.resize(static_cast<size_t>(sfInfo.frames));
+    vector<float> chunk(WAV_CHUNK_FRAMES * sfInfo.channels);
+    size_t position = 0;
+    while (position < pcm.size()) {
+        sf_count_t read = sf_readf_float(file, chunk.data(), WAV_CHUNK_FRAMES);
+        if (read <= 0) break;
+        pcm.write(position, chunk.data(), static_cast<size_t>(read));
+        position += static_cast<size_t>(read);
     }
+    sf_close(file);
 
     return true;
 }
@@ -106,23 +132,52 @@ bool AudioFileReader::loadWAV(const string& filePath) {
 bool AudioFileReader::loadFile(const string& filePath) {
     string extension = filePath.substr(filePath.find_last_of('.') + 1);
 
+    bool loaded = false;
     if (extension == "mp3") {
-        return loadMP3(filePath);
+        loaded = loadMP3(filePath);
     }
     else if (extension == "wav") {
-        return loadWAV(filePath);
+        loaded = loadWAV(filePath);
+    }
+    else {
+        cerr << "Unsupported file format." << endl;
+        return false;
     }
 
-    cerr << "Unsupported file format." << endl;
-    return false;
+    if (loaded) {
+        buildOverview(filePath);
+    }
+    return loaded;
+}
+
+void AudioFileReader::buildOverview(const string& filePath) {
+    overview.clear();
+    if (overviewMode == OverviewMode::Off) {
+        return;
+    }
+
+    string cachePath = filePath + OVERVIEW_SUFFIX;
+    if (overviewMode == OverviewMode::Cached && overview.load(cachePath, filePath) &&
+        overview.getFrameCount() == pcm.size() && overview.getSampleRate() == sampleRate) {
+        return;
+    }
+
+    overview.build(pcm, sampleRate, decodeThreads);
+    if (overviewMode == OverviewMode::Cached) {
+        overview.save(cachePath, filePath);
+    }
+}
+
+const PcmStore& AudioFileReader::getPcm() const {
+    return pcm;
 }
 
-const vector<float>& AudioFileReader::getLeftChannel() const {
-    return leftChannel;
+const WaveformPyramid& AudioFileReader::getOverview() const {
+    return overview;
 }
 
-const vector<float>& AudioFileReader::getRightChannel() const {
-    return rightChannel;
+size_t AudioFileReader::getFrameCount() const {
+    return pcm.size();
 }
 
 int AudioFileReader::getSampleRate() const {
@@ -1,6 +1,8 @@
 #ifndef AUDIO_READER_H
 #define AUDIO_READER_H
 
+#include "PcmStore.h"
+#include "WaveformPyramid.h"
 #include <string>
 #include <vector>
 
@@ -12,17 +14,29 @@ public:
     ~AudioFileReader();
 
     bool loadFile(const string& filePath); 
-    const vector<float>& getLeftChannel() const; 
-    const vector<float>& getRightChannel() const;
+    // MP3s are decoded on this many threads; 1 keeps the serial decoder.
+    void setDecodeThreads(size_t threads);
+    // Storage format for the next loadFile(); Float32 by default.
+    void setPcmFormat(PcmFormat format);
+    // Whether the next loadFile() summarizes the track for the overview
+    // strip; Off by default.
+    void setOverviewMode(OverviewMode mode);
+    const PcmStore& getPcm() const;
+    const WaveformPyramid& getOverview() const;
+    size_t getFrameCount() const;
     int getSampleRate() const;
 
 private:
     bool loadMP3(const string& filePath);  
     bool loadWAV(const string& filePath);  
+    void buildOverview(const string& filePath);
 
-    vector<float> leftChannel;  
-    vector<float> rightChannel; 
+    PcmStore pcm;
+    PcmFormat pcmFormat;
+    WaveformPyramid overview;
+    OverviewMode overviewMode;
     int sampleRate;             
+    size_t decodeThreads;
 };
 
 #endif 
@@ -0,0 +1,94 @@
+#include "BeatDetector.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+static const double HISTORY_SECONDS = 1.5;
+static const double MIN_BEAT_INTERVAL = 0.3;   // 200 BPM
+static const double MAX_BEAT_INTERVAL = 2.0;   // intervals longer than this restart the tempo estimate
+static const size_t TEMPO_INTERVALS = 8;
+static const float THRESHOLD_DEVIATIONS = 1.5f;
+
+BeatDetector::BeatDetector(int sampleRate) : sampleRate(sampleRate) {
+    reset();
+}
+
+void BeatDetector::reset() {
+    previousBands.clear();
+    fluxHistory.clear();
+    beatIntervals.clear();
+    sinceLastBeat = 0.0;
+    lastFlux = 0.0f;
+    beat = false;
+    strength = 0.0f;
+    tempo = 0.0f;
+}
+
+void BeatDetector::process(const vector<float>& bands, size_t hopSamples) {
+    double hopSeconds = static_cast<double>(hopSamples) / sampleRate;
+    sinceLastBeat += hopSeconds;
+    beat = false;
+    strength = 0.0f;
+
+    if (previousBands.size() != bands.size()) {
+        previousBands.assign(bands.size(), 0.0f);
+    }
+
+    // Log compression keeps loud sustained notes from swamping the flux.
+    float flux = 0.0f;
+    for (size_t i = 0; i < bands.size(); ++i) {
+        float level = log1p(bands[i]);
+        flux += max(0.0f, level - previousBands[i]);
+        previousBands[i] = level;
+    }
+
+    size_t historyLength = max<size_t>(4, static_cast<size_t>(HISTORY_SECONDS / hopSeconds));
+    if (fluxHistory.size() >= historyLength / 2) {
+        float mean = 0.0f;
+        for (float value : fluxHistory) mean += value;
+        mean /= fluxHistory.size();
+        float variance = 0.0f;
+        for (float value : fluxHistory) variance += (value - mean) * (value - mean);
+        float deviation = sqrt(variance / fluxHistory.size());
+
+        float threshold = mean + THRESHOLD_DEVIATIONS * deviation;
+        if (flux > threshold && flux >= lastFlux && sinceLastBeat >= MIN_BEAT_INTERVAL) {
+            beat = true;
+            strength = (flux - mean) / max(deviation, 1e-6f);
+
+            if (sinceLastBeat <= MAX_BEAT_INTERVAL) {
+                beatIntervals.push_back(sinceLastBeat);
+                if (beatIntervals.size() > TEMPO_INTERVALS) beatIntervals.pop_front();
+            } else {
+                beatIntervals.clear();
+            }
+            sinceLastBeat = 0.0;
+
+            if (beatIntervals.size() >= 3) {
+                vector<double> sorted(beatIntervals.begin(), beatIntervals.end());
+                nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+                double bpm = 60.0 / sorted[sorted.size() / 2];
+                while (bpm < 70.0) bpm *= 2.0;
+                while (bpm > 180.0) bpm /= 2.0;
+                tempo = static_cast<float>(bpm);
+            }
+        }
+    }
+
+    fluxHistory.push_back(flux);
+    while (fluxHistory.size() > historyLength) fluxHistory.pop_front();
+    lastFlux = flux;
+}
+
+bool BeatDetector::isBeat() const {
+    return beat;
+}
+
+float BeatDetector::getStrength() const {
+    return strength;
+}
+
+float BeatDetector::getTempo() const {
+    return tempo;
+}
@@ -0,0 +1,39 @@
+#ifndef BEAT_DETECTOR_H
+#define BEAT_DETECTOR_H
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+using namespace std;
+
+// Onset-based beat tracker fed once per analysis hop.
+//
+// Onsets come from log spectral flux over the band vector, compared against
+// an adaptive threshold (mean plus 1.5 standard deviations of the last
+// 1.5 s of flux). Tempo is the median of recent beat intervals, folded into
+// 70..180 BPM.
+class BeatDetector {
+public:
+    BeatDetector(int sampleRate);
+
+    void process(const vector<float>& bands, size_t hopSamples);
+    void reset();
+
+    bool isBeat() const;          // an onset was detected in the last hop
+    float getStrength() const;    // flux above the threshold, in standard deviations
+    float getTempo() const;       // BPM, 0 until a few beats have been seen
+
+private:
+    int sampleRate;
+    vector<float> previousBands;
+    deque<float> fluxHistory;
+    deque<double> beatIntervals;
+    double sinceLastBeat;         // seconds
+    float lastFlux;
+    bool beat;
+    float strength;
+    float tempo;
+};
+
+#endif // BEAT_DETECTOR_H
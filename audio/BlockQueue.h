@@ -0,0 +1,66 @@
+#ifndef BLOCK_QUEUE_H
+#define BLOCK_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+struct AudioBlock {
+    size_t sourceOffset;  // source sample of left[0]
+    size_t frames;
+    int channels;         // of the source; mono fills left and right alike
+    vector<float> left;
+    vector<float> right;
+};
+
+// Single-producer/single-consumer queue of stereo sample blocks. All slots
+// are allocated up front, so the audio callback never allocates or locks.
+class BlockQueue {
+public:
+    BlockQueue() : writeIndex(0), readIndex(0) {}
+
+    void allocate(size_t slotCount, size_t blockFrames) {
+        slots.assign(slotCount, AudioBlock{0, 0, 2, vector<float>(blockFrames), vector<float>(blockFrames)});
+        writeIndex = 0;
+        readIndex = 0;
+    }
+
+    // Producer side. Returns null when the consumer has fallen behind.
+    AudioBlock* beginWrite() {
+        size_t write = writeIndex.load(memory_order_relaxed);
+        if (write - readIndex.load(memory_order_acquire) == slots.size()) {
+            return nullptr;
+        }
+        return &slots[write % slots.size()];
+    }
+
+    void commitWrite() {
+        writeIndex.store(writeIndex.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+
+    // Consumer side. Returns null when empty.
+    AudioBlock* front() {
+        size_t read = readIndex.load(memory_order_relaxed);
+        if (read == writeIndex.load(memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots[read % slots.size()];
+    }
+
+    void pop() {
+        readIndex.store(readIndex.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+
+    bool empty() const {
+        return readIndex.load(memory_order_acquire) == writeIndex.load(memory_order_acquire);
+    }
+
+private:
+    vector<AudioBlock> slots;
+    atomic<size_t> writeIndex;
+    atomic<size_t> readIndex;
+};
+
+#endif // BLOCK_QUEUE_H
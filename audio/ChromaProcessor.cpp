@@ -0,0 +1,267 @@
+#include "ChromaProcessor.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+using namespace std;
+
+// Musical range covered: C1 (MIDI 24) up to just below C9 (MIDI 120).
+static const int LOWEST_PITCH = 24;
+static const int HIGHEST_PITCH = 120;
+
+// Median filter lengths for harmonic-percussive separation. Nine hops is
+// about 200 ms at 1024 samples / 44.1 kHz, enough to outlast a drum hit.
+static const size_t HPSS_FRAMES = 9;
+static const size_t HPSS_BINS = 9;
+
+// Peaks more than 40 dB below the loudest one in the frame are ignored.
+static const float PEAK_FLOOR = 1e-4f;
+
+// Resolution of the sub-bin peak table.
+static const float PEAK_STEPS_PER_SEMITONE = 16.0f;
+
+static float frequencyToPitch(float frequency) {
+    return 69.0f + 12.0f * log2(frequency / 440.0f);
+}
+
+static float pitchToFrequency(float pitch) {
+    return 440.0f * pow(2.0f, (pitch - 69.0f) / 12.0f);
+}
+
+static int octaveIndex(int pitch) {
+    return pitch / 12 - LOWEST_PITCH / 12;
+}
+
+ChromaProcessor::ChromaProcessor(size_t fftSize, int sampleRate)
+    : peakInterpolation(true), harmonicSeparation(false), historyPos(0), percussiveRatio(0.0f) {
+    chroma.fill(0.0f);
+    octaveEnergy.fill(0.0f);
+    configure(fftSize, sampleRate);
+}
+
+void ChromaProcessor::configure(size_t fftSize, int sampleRate) {
+    pitchMap = pitchMapFor(fftSize, sampleRate);
+    reset();
+}
+
+void ChromaProcessor::setPeakInterpolation(bool enabled) {
+    peakInterpolation = enabled;
+}
+
+void ChromaProcessor::setHarmonicSeparation(bool enabled) {
+    if (enabled && !harmonicSeparation) {
+        reset();
+    }
+    harmonicSeparation = enabled;
+}
+
+void ChromaProcessor::reset() {
+    history.clear();
+    historyPos = 0;
+    percussiveRatio = 0.0f;
+}
+
+shared_ptr<const ChromaProcessor::PitchMap> ChromaProcessor::pitchMapFor(size_t fftSize, int sampleRate) {
+    // Tables depend only on the FFT size and sample rate, so every processor
+    // and every quality level switch shares one copy per combination.
+    static mutex cacheMutex;
+    static map<pair<size_t, int>, shared_ptr<const PitchMap>> cache;
+
+    lock_guard<mutex> lock(cacheMutex);
+    auto& entry = cache[make_pair(fftSize, sampleRate)];
+    if (!entry) {
+        entry = buildPitchMap(fftSize, sampleRate);
+    }
+    return entry;
+}
+
+shared_ptr<const ChromaProcessor::PitchMap> ChromaProcessor::buildPitchMap(size_t fftSize, int sampleRate) {
+    auto pitchMap = make_shared<PitchMap>();
+    size_t bins = fftSize / 2;
+    pitchMap->binWidth = static_cast<float>(sampleRate) / fftSize;
+
+    // Bin 0 is DC and the last bin has no upper neighbour for peak picking.
+    float lowest = pitchToFrequency(LOWEST_PITCH - 0.5f) / pitchMap->binWidth;
+    float highest = pitchToFrequency(HIGHEST_PITCH - 0.5f) / pitchMap->binWidth;
+    pitchMap->firstBin = max<size_t>(1, static_cast<size_t>(ceil(lowest)));
+    pitchMap->lastBin = min(bins >= 2 ? bins - 2 : 0, static_cast<size_t>(highest));
+
+    // Each bin centre is split between the two semitones either side of it.
+    // Low bins can span several semitones; that blur is what peak
+    // interpolation avoids.
+    for (size_t bin = pitchMap->firstBin; bin <= pitchMap->lastBin && bin < bins; ++bin) {
+        float pitch = frequencyToPitch(bin * pitchMap->binWidth);
+        int below = static_cast<int>(floor(pitch));
+        float fraction = pitch - below;
+
+        int pitches[2] = {below, below + 1};
+        float weights[2] = {1.0f - fraction, fraction};
+        for (int i = 0; i < 2; ++i) {
+            if (weights[i] <= 0.0f || pitches[i] < LOWEST_PITCH || pitches[i] >= HIGHEST_PITCH) continue;
+            PitchWeight weight;
+            weight.bin = static_cast<uint32_t>(bin);
+            weight.pitchClass = static_cast<uint8_t>(pitches[i] % PITCH_CLASSES);
+            weight.octave = static_cast<uint8_t>(octaveIndex(pitches[i]));
+            weight.weight = weights[i];
+            pitchMap->weights.push_back(weight);
+        }
+    }
+
+    // Peaks interpolate to anywhere within half a bin of their centre; each
+    // bin is cut into enough steps that one spans a sixteenth of a semitone.
+    for (size_t bin = pitchMap->firstBin; bin <= pitchMap->lastBin && bin < bins; ++bin) {
+        float span = 12.0f * log2((bin + 0.5f) / (bin - 0.5f));
+        BinSteps steps;
+        steps.first = static_cast<uint32_t>(pitchMap->peakWeights.size());
+        steps.count = static_cast<uint32_t>(max(1.0f, ceil(span * PEAK_STEPS_PER_SEMITONE)));
+        for (uint32_t step = 0; step < steps.count; ++step) {
+            float position = bin - 0.5f + (step + 0.5f) / steps.count;
+            float pitch = frequencyToPitch(position * pitchMap->binWidth);
+            int below = static_cast<int>(floor(pitch));
+            int nearest = static_cast<int>(floor(pitch + 0.5f));
+
+            PeakWeight weight;
+            weight.pitchClass[0] = static_cast<uint8_t>(below % PITCH_CLASSES);
+            weight.pitchClass[1] = static_cast<uint8_t>((below + 1) % PITCH_CLASSES);
+            weight.fraction = pitch - below;
+            bool inRange = pitch >= LOWEST_PITCH - 0.5f && pitch < HIGHEST_PITCH - 0.5f;
+            weight.octave = inRange ? static_cast<uint8_t>(octaveIndex(nearest)) : NO_OCTAVE;
+            pitchMap->peakWeights.push_back(weight);
+        }
+        pitchMap->peakSteps.push_back(steps);
+    }
+    return pitchMap;
+}
+
+void ChromaProcessor::process(const vector<float>& magnitudes) {
+    chroma.fill(0.0f);
+    octaveEnergy.fill(0.0f);
+
+    power.resize(magnitudes.size());
+    for (size_t i = 0; i < magnitudes.size(); ++i) {
+        power[i] = magnitudes[i] * magnitudes[i];
+    }
+
+    if (harmonicSeparation) {
+        separateHarmonic();
+    }
+
+    if (peakInterpolation) {
+        accumulatePeaks();
+    } else {
+        accumulateBins();
+    }
+
+    float strongest = *max_element(chroma.begin(), chroma.end());
+    if (strongest > 0.0f) {
+        for (float& value : chroma) {
+            value /= strongest;
+        }
+    }
+}
+
+void ChromaProcessor::separateHarmonic() {
+    size_t bins = power.size();
+    if (!history.empty() && history[0].size() != bins) {
+        reset();
+    }
+
+    // Ring of the most recent frames; it grows to HPSS_FRAMES and is then
+    // overwritten in place.
+    size_t newest;
+    if (history.size() < HPSS_FRAMES) {
+        history.push_back(power);
+        newest = history.size() - 1;
+    } else {
+        newest = historyPos;
+        history[historyPos] = power;
+        historyPos = (historyPos + 1) % HPSS_FRAMES;
+    }
+    const vector<float>& current = history[newest];
+
+    // Sustained partials are steady across time, transients are flat across
+    // frequency; compare the two medians and soft-mask the current frame.
+    float percussiveEnergy = 0.0f;
+    float totalEnergy = 0.0f;
+    size_t halfWidth = HPSS_BINS / 2;
+    for (size_t bin = 0; bin < bins; ++bin) {
+        medianScratch.clear();
+        for (const auto& frame : history) {
+            medianScratch.push_back(frame[bin]);
+        }
+        auto middle = medianScratch.begin() + medianScratch.size() / 2;
+        nth_element(medianScratch.begin(), middle, medianScratch.end());
+        float harmonic = *middle;
+
+        size_t start = bin > halfWidth ? bin - halfWidth : 0;
+        size_t end = min(bins, bin + halfWidth + 1);
+        medianScratch.assign(current.begin() + start, current.begin() + end);
+        middle = medianScratch.begin() + medianScratch.size() / 2;
+        nth_element(medianScratch.begin(), middle, medianScratch.end());
+        float percussive = *middle;
+
+        float h2 = harmonic * harmonic;
+        float p2 = percussive * percussive;
+        float mask = h2 + p2 > 0.0f ? h2 / (h2 + p2) : 1.0f;
+
+        totalEnergy += current[bin];
+        percussiveEnergy += current[bin] * (1.0f - mask);
+        power[bin] = current[bin] * mask;
+    }
+    percussiveRatio = totalEnergy > 0.0f ? percussiveEnergy / totalEnergy : 0.0f;
+}
+
+void ChromaProcessor::accumulatePeaks() {
+    size_t last = min(pitchMap->lastBin, power.size() >= 2 ? power.size() - 2 : 0);
+    if (pitchMap->firstBin > last) return;
+
+    float loudest = *max_element(power.begin() + pitchMap->firstBin, power.begin() + last + 1);
+    float threshold = loudest * PEAK_FLOOR;
+
+    for (size_t bin = pitchMap->firstBin; bin <= last; ++bin) {
+        float center = power[bin];
+        if (center <= threshold || center <= power[bin - 1] || center < power[bin + 1]) continue;
+
+        // Parabola through the log power of the peak and its neighbours gives
+        // the sub-bin offset and the true peak height.
+        float below = log(power[bin - 1] + 1e-20f);
+        float peak = log(center);
+        float above = log(power[bin + 1] + 1e-20f);
+        float curvature = below - 2.0f * peak + above;
+        float offset = curvature < 0.0f ? 0.5f * (below - above) / curvature : 0.0f;
+        offset = max(-0.5f, min(0.5f, offset));
+        float height = peak - 0.25f * (below - above) * offset;
+
+        const BinSteps& steps = pitchMap->peakSteps[bin - pitchMap->firstBin];
+        size_t step = min<size_t>(steps.count - 1, static_cast<size_t>((offset + 0.5f) * steps.count));
+        const PeakWeight& weight = pitchMap->peakWeights[steps.first + step];
+        if (weight.octave == NO_OCTAVE) continue;
+
+        float energy = exp(height);
+        octaveEnergy[weight.octave] += energy;
+        chroma[weight.pitchClass[0]] += energy * (1.0f - weight.fraction);
+        chroma[weight.pitchClass[1]] += energy * weight.fraction;
+    }
+}
+
+void ChromaProcessor::accumulateBins() {
+    for (const PitchWeight& weight : pitchMap->weights) {
+        if (weight.bin >= power.size()) break;
+        float energy = power[weight.bin] * weight.weight;
+        chroma[weight.pitchClass] += energy;
+        octaveEnergy[weight.octave] += energy;
+    }
+}
+
+const array<float, PITCH_CLASSES>& ChromaProcessor::getChroma() const {
+    return chroma;
+}
+
+const array<float, CHROMA_OCTAVES>& ChromaProcessor::getOctaveEnergy() const {
+    return octaveEnergy;
+}
+
+float ChromaProcessor::getPercussiveRatio() const {
+    return percussiveRatio;
+}
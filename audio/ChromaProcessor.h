@@ -0,0 +1,101 @@
+#ifndef CHROMA_PROCESSOR_H
+#define CHROMA_PROCESSOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+const size_t PITCH_CLASSES = 12;   // C, C#, ..., B
+const size_t CHROMA_OCTAVES = 8;   // MIDI octaves 1..8 (C1 = 32.7 Hz)
+
+// Maps an FFT magnitude spectrum onto 12 pitch classes and per-octave energy.
+//
+// All frequency-to-pitch math lives in a PitchMap built once per
+// (FFT size, sample rate) and shared between instances, so changing the
+// analysis size just swaps tables. By default only spectral peaks are used,
+// refined with parabolic interpolation on log magnitude, which keeps low
+// notes in tune even when a bin spans more than a semitone; the refined
+// position is looked up in the map's sub-bin steps. Without peak picking
+// every bin is folded in through the map's per-bin weights.
+//
+// Optional harmonic-percussive separation median-filters a short power
+// history across time (harmonic) and the current frame across frequency
+// (percussive) and keeps only the harmonic part for chroma.
+class ChromaProcessor {
+public:
+    ChromaProcessor(size_t fftSize, int sampleRate);
+
+    void configure(size_t fftSize, int sampleRate);
+    void setPeakInterpolation(bool enabled);
+    void setHarmonicSeparation(bool enabled);
+    // Forgets the spectrogram history, e.g. after a seek.
+    void reset();
+
+    // magnitudes has fftSize / 2 bins.
+    void process(const vector<float>& magnitudes);
+
+    // Normalized so the strongest pitch class is 1.
+    const array<float, PITCH_CLASSES>& getChroma() const;
+    const array<float, CHROMA_OCTAVES>& getOctaveEnergy() const;
+    // Share of the frame's power classed as percussive; 0 without separation.
+    float getPercussiveRatio() const;
+
+    struct PitchWeight {
+        uint32_t bin;
+        uint8_t pitchClass;
+        uint8_t octave;
+        float weight;
+    };
+
+    // Where an interpolated peak lands: its energy is split between two
+    // neighbouring pitch classes and counted whole in the nearest octave.
+    struct PeakWeight {
+        uint8_t pitchClass[2];
+        uint8_t octave;              // NO_OCTAVE outside the musical range
+        float fraction;              // share of pitchClass[1]
+    };
+
+    struct BinSteps {
+        uint32_t first;              // into peakWeights
+        uint32_t count;              // equal steps across the bin, from -0.5 to +0.5
+    };
+
+    struct PitchMap {
+        size_t firstBin, lastBin;    // bins inside the musical range, inclusive
+        float binWidth;              // Hz per bin
+        vector<PitchWeight> weights; // at most two entries per bin, sorted by bin
+        // Indexed by bin - firstBin. Low bins span several semitones and get
+        // many steps, high bins one.
+        vector<BinSteps> peakSteps;
+        vector<PeakWeight> peakWeights;
+    };
+
+    static const uint8_t NO_OCTAVE = 0xFF;
+
+private:
+    static shared_ptr<const PitchMap> pitchMapFor(size_t fftSize, int sampleRate);
+    static shared_ptr<const PitchMap> buildPitchMap(size_t fftSize, int sampleRate);
+
+    void separateHarmonic();
+    void accumulatePeaks();
+    void accumulateBins();
+
+    shared_ptr<const PitchMap> pitchMap;
+    bool peakInterpolation;
+    bool harmonicSeparation;
+
+    vector<float> power;
+    vector<vector<float>> history;   // recent power frames for the time median
+    size_t historyPos;
+    vector<float> medianScratch;
+
+    array<float, PITCH_CLASSES> chroma;
+    array<float, CHROMA_OCTAVES> octaveEnergy;
+    float percussiveRatio;
+};
+
+#endif // CHROMA_PROCESSOR_H
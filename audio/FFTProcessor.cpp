@@ -1,26 +1,56 @@
+#define _USE_MATH_DEFINES
 #include "FFTProcessor.h"
+#ifndef MPV_NO_FFTW
 #include <fftw3.h>
+#endif
 #include <cmath>
 #include <iostream>
 
 using namespace std;
 
-FFTProcessor::FFTProcessor(size_t bufferSize)
-    : bufferSize(bufferSize), magnitudes(bufferSize / 2, 0.0f) {
+FFTProcessor::FFTProcessor(size_t bufferSize, FFTBackend requested)
+    : bufferSize(bufferSize), magnitudes(bufferSize / 2, 0.0f), fftPlan(nullptr), backend(requested) {
     // Allocate FFT input/output arrays
     fftInput = new float[bufferSize];
     fftOutput = new float[bufferSize];
 
+#ifdef MPV_NO_FFTW
+    if (backend == FFTBackend::FFTW) {
+        cerr << "WARNING: built without FFTW, using the fixed-size FFT." << endl;
+        backend = FFTBackend::Fixed;
+    }
+#endif
+
+    if (backend == FFTBackend::Fixed) {
+        fixedFFT = makeFixedFFT(bufferSize);
+        if (fixedFFT) {
+            return;
+        }
+#ifdef MPV_NO_FFTW
+        cerr << "ERROR: no fixed-size FFT for " << bufferSize << " points." << endl;
+        return;
+#else
+        cerr << "WARNING: no fixed-size FFT for " << bufferSize << " points, using FFTW." << endl;
+        backend = FFTBackend::FFTW;
+#endif
+    }
+
+#ifndef MPV_NO_FFTW
     // Create FFTW plan
     fftPlan = fftwf_plan_r2r_1d(bufferSize, fftInput, fftOutput, FFTW_R2HC, FFTW_MEASURE);
     if (!fftPlan) {
         cerr << "Failed to create FFTW plan." << endl;
     }
+#endif
 }
 
 FFTProcessor::~FFTProcessor() {
     // Destroy FFTW plan and free memory
-    fftwf_destroy_plan(static_cast<fftwf_plan>(fftPlan));
+#ifndef MPV_NO_FFTW
+    if (fftPlan) {
+        fftwf_destroy_plan(static_cast<fftwf_plan>(fftPlan));
+    }
+#endif
     delete[] fftInput;
     delete[] fftOutput;
 }
@@ -32,10 +62,23 @@ void FFTProcessor::computeFFT(const vector<float>& audioData) {
     }
 
     // Copy audio data to fftInput
-    for (size_t i = 0; i < bufferSize; ++i) {
-        fftInput[i] = audioData[i];
+    if (window.empty()) {
+        for (size_t i = 0; i < bufferSize; ++i) {
+            fftInput[i] = audioData[i];
+        }
+    } else {
+        for (size_t i = 0; i < bufferSize; ++i) {
+            fftInput[i] = audioData[i] * window[i];
+        }
     }
 
+    if (fixedFFT) {
+        fixedFFT->magnitudes(fftInput, magnitudes.data());
+        return;
+    }
+#ifndef MPV_NO_FFTW
+    if (!fftPlan) return;
+
     // Execute FFT
     fftwf_execute(static_cast<fftwf_plan>(fftPlan));
 
@@ -45,8 +88,41 @@ void FFTProcessor::computeFFT(const vector<float>& audioData) {
         float imag = (i == 0 || i == bufferSize / 2) ? 0 : fftOutput[bufferSize - i];
         magnitudes[i] = sqrt(real * real + imag * imag);
     }
+#endif
+}
+
+void FFTProcessor::setWindow(WindowFunction function) {
+    window.clear();
+    if (function == WindowFunction::Rectangular) return;
+
+    window.resize(bufferSize);
+    double sum = 0.0;
+    for (size_t i = 0; i < bufferSize; ++i) {
+        double phase = 2.0 * M_PI * i / bufferSize;
+        double value;
+        if (function == WindowFunction::Hann) {
+            value = 0.5 - 0.5 * cos(phase);
+        } else {
+            value = 0.35875 - 0.48829 * cos(phase) + 0.14128 * cos(2.0 * phase) - 0.01168 * cos(3.0 * phase);
+        }
+        window[i] = static_cast<float>(value);
+        sum += value;
+    }
+
+    float gain = static_cast<float>(bufferSize / sum);
+    for (float& value : window) {
+        value *= gain;
+    }
 }
 
 const vector<float>& FFTProcessor::getMagnitudes() const {
     return magnitudes;
 }
+
+FFTBackend FFTProcessor::getBackend() const {
+    return backend;
+}
+
+size_t FFTProcessor::getSize() const {
+    return bufferSize;
+}
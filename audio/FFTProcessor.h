@@ -1,24 +1,55 @@
 #ifndef FFTPROCESSOR_H
 #define FFTPROCESSOR_H
 
+#include "FixedFFT.h"
+#include <memory>
 #include <vector>
 
 using namespace std;
 
+enum class WindowFunction {
+    Rectangular,     // no window, what the analysis always used
+    Hann,
+    BlackmanHarris   // 4-term, lowest leakage
+};
+
+enum class FFTBackend {
+    FFTW,    // r2r plan, any size
+    Fixed    // FixedFFT kernels, power-of-two sizes 256 to 8192
+};
+
+// Builds defined with MPV_NO_FFTW don't link FFTW and only have the fixed
+// kernels.
+#ifdef MPV_NO_FFTW
+const FFTBackend DEFAULT_FFT_BACKEND = FFTBackend::Fixed;
+#else
+const FFTBackend DEFAULT_FFT_BACKEND = FFTBackend::FFTW;
+#endif
+
 class FFTProcessor {
 public:
-    FFTProcessor(size_t bufferSize);
+    // Falls back to the other backend when the requested one can't serve
+    // bufferSize.
+    FFTProcessor(size_t bufferSize, FFTBackend backend = DEFAULT_FFT_BACKEND);
     ~FFTProcessor();
 
+    // Windows are normalized to unit mean, so a tone reads the same level
+    // whichever one is used.
+    void setWindow(WindowFunction window);
     void computeFFT(const vector<float>& audioData);
     const vector<float>& getMagnitudes() const;
+    FFTBackend getBackend() const;
+    size_t getSize() const;
 
 private:
     size_t bufferSize;
     vector<float> magnitudes;
+    vector<float> window;  // empty for rectangular
     float* fftInput;
     float* fftOutput;
     void* fftPlan;  // Plan type depends on FFTW version
+    unique_ptr<FixedFFTKernel> fixedFFT;
+    FFTBackend backend;
 };
 
 #endif // FFTPROCESSOR_H
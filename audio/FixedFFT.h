@@ -0,0 +1,294 @@
+#ifndef FIXED_FFT_H
+#define FIXED_FFT_H
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+// Header-only real FFT for power-of-two sizes known at compile time, so
+// fixed-size builds can drop FFTW.
+//
+// An N-point real transform is done as an N/2-point complex transform of
+// the even/odd samples packed as re/im, followed by the usual split step.
+// The complex transform is iterative decimation in time: bit-reversed load,
+// one radix-2 pass when log2(N/2) is odd, then radix-4 passes. Data is kept
+// as separate real and imaginary arrays so radix-4 butterflies run four at a
+// time with SSE once a pass is at least four butterflies wide. Every
+// twiddle, the bit-reversal permutation included, is a constexpr table laid
+// out in the order the passes read it.
+
+namespace fixed_fft_detail {
+
+constexpr double PI = 3.14159265358979323846;
+
+// Taylor series; arguments are reduced to [-pi, pi] first, where 24 terms
+// are well past double precision.
+constexpr double taylorSin(double x) {
+    double term = x, sum = x;
+    for (int n = 1; n < 24; ++n) {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double taylorCos(double x) {
+    double term = 1.0, sum = 1.0;
+    for (int n = 1; n < 24; ++n) {
+        term *= -x * x / ((2.0 * n - 1.0) * (2.0 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+// Angle 2*pi*k/n.
+constexpr double turnAngle(size_t k, size_t n) {
+    double angle = 2.0 * PI * static_cast<double>(k % n) / static_cast<double>(n);
+    return angle > PI ? angle - 2.0 * PI : angle;
+}
+
+constexpr size_t log2(size_t n) {
+    size_t bits = 0;
+    while ((size_t(1) << bits) < n) ++bits;
+    return bits;
+}
+
+template <size_t N>
+struct Tables {
+    static constexpr size_t M = N / 2;
+    static constexpr size_t BITS = log2(M);
+    static constexpr bool ODD_PASS = (BITS % 2) != 0;
+
+    array<uint32_t, M> bitReverse{};
+    // Radix-4 twiddles, pass after pass: w1, w2, w3 as re[L] im[L] each.
+    array<float, 2 * M> passTwiddles{};
+    // W_N^k for the real-input split step.
+    array<float, M> splitCos{};
+    array<float, M> splitSin{};
+
+    constexpr Tables() {
+        for (size_t i = 0; i < M; ++i) {
+            uint32_t reversed = 0;
+            for (size_t b = 0; b < BITS; ++b) {
+                reversed |= ((i >> b) & 1u) << (BITS - 1 - b);
+            }
+            bitReverse[i] = reversed;
+        }
+
+        size_t offset = 0;
+        for (size_t L = ODD_PASS ? 2 : 1; L < M; L *= 4) {
+            for (size_t m = 1; m <= 3; ++m) {
+                for (size_t j = 0; j < L; ++j) {
+                    double angle = turnAngle(m * j, 4 * L);
+                    passTwiddles[offset + j] = static_cast<float>(taylorCos(angle));
+                    passTwiddles[offset + L + j] = static_cast<float>(-taylorSin(angle));
+                }
+                offset += 2 * L;
+            }
+        }
+
+        for (size_t k = 0; k < M; ++k) {
+            double angle = turnAngle(k, N);
+            splitCos[k] = static_cast<float>(taylorCos(angle));
+            splitSin[k] = static_cast<float>(taylorSin(angle));
+        }
+    }
+};
+
+}  // namespace fixed_fft_detail
+
+template <size_t N>
+class FixedFFT {
+    static_assert(N >= 16 && (N & (N - 1)) == 0, "FixedFFT needs a power-of-two size of at least 16");
+
+public:
+    static constexpr size_t SIZE = N;
+
+    // x holds N samples; re and im receive bins 0..N/2 inclusive.
+    void forward(const float* x, float* re, float* im) {
+        transformPacked(x);
+        split(re, im);
+    }
+
+    // |X[k]| for k in [0, N/2), the bins FFTProcessor reports.
+    void magnitudes(const float* x, float* out) {
+        transformPacked(x);
+        split(splitRe, splitIm);
+        for (size_t k = 0; k < M; ++k) {
+            out[k] = sqrt(splitRe[k] * splitRe[k] + splitIm[k] * splitIm[k]);
+        }
+    }
+
+private:
+    using Tables = fixed_fft_detail::Tables<N>;
+    static constexpr size_t M = N / 2;
+    static constexpr Tables tables{};
+
+    void transformPacked(const float* x) {
+        for (size_t k = 0; k < M; ++k) {
+            uint32_t source = tables.bitReverse[k];
+            zr[k] = x[2 * source];
+            zi[k] = x[2 * source + 1];
+        }
+
+        if (Tables::ODD_PASS) {
+            for (size_t k = 0; k < M; k += 2) {
+                float ar = zr[k], ai = zi[k];
+                zr[k] = ar + zr[k + 1];
+                zi[k] = ai + zi[k + 1];
+                zr[k + 1] = ar - zr[k + 1];
+                zi[k + 1] = ai - zi[k + 1];
+            }
+        }
+
+        const float* twiddles = tables.passTwiddles.data();
+        for (size_t L = Tables::ODD_PASS ? 2 : 1; L < M; L *= 4) {
+            for (size_t group = 0; group < M; group += 4 * L) {
+                radix4Pass(group, L, twiddles);
+            }
+            twiddles += 6 * L;
+        }
+    }
+
+    // Bit-reversed order leaves the length-L sub-transforms of residues
+    // 0, 2, 1, 3 (mod 4) at group, +L, +2L, +3L.
+    void radix4Pass(size_t group, size_t L, const float* twiddles) {
+        float* r0 = zr + group;
+        float* i0 = zi + group;
+        float* r2 = r0 + L;
+        float* i2 = i0 + L;
+        float* r1 = r0 + 2 * L;
+        float* i1 = i0 + 2 * L;
+        float* r3 = r0 + 3 * L;
+        float* i3 = i0 + 3 * L;
+        const float* w1r = twiddles;
+        const float* w1i = twiddles + L;
+        const float* w2r = twiddles + 2 * L;
+        const float* w2i = twiddles + 3 * L;
+        const float* w3r = twiddles + 4 * L;
+        const float* w3i = twiddles + 5 * L;
+
+        size_t j = 0;
+#ifdef __SSE2__
+        for (; j + 4 <= L; j += 4) {
+            __m128 p0r = _mm_load_ps(r0 + j), p0i = _mm_load_ps(i0 + j);
+            __m128 p1r = _mm_load_ps(r1 + j), p1i = _mm_load_ps(i1 + j);
+            __m128 p2r = _mm_load_ps(r2 + j), p2i = _mm_load_ps(i2 + j);
+            __m128 p3r = _mm_load_ps(r3 + j), p3i = _mm_load_ps(i3 + j);
+
+            __m128 ar = _mm_loadu_ps(w1r + j), ai = _mm_loadu_ps(w1i + j);
+            __m128 t1r = _mm_sub_ps(_mm_mul_ps(p1r, ar), _mm_mul_ps(p1i, ai));
+            __m128 t1i = _mm_add_ps(_mm_mul_ps(p1r, ai), _mm_mul_ps(p1i, ar));
+            ar = _mm_loadu_ps(w2r + j);
+            ai = _mm_loadu_ps(w2i + j);
+            __m128 t2r = _mm_sub_ps(_mm_mul_ps(p2r, ar), _mm_mul_ps(p2i, ai));
+            __m128 t2i = _mm_add_ps(_mm_mul_ps(p2r, ai), _mm_mul_ps(p2i, ar));
+            ar = _mm_loadu_ps(w3r + j);
+            ai = _mm_loadu_ps(w3i + j);
+            __m128 t3r = _mm_sub_ps(_mm_mul_ps(p3r, ar), _mm_mul_ps(p3i, ai));
+            __m128 t3i = _mm_add_ps(_mm_mul_ps(p3r, ai), _mm_mul_ps(p3i, ar));
+
+            __m128 s0r = _mm_add_ps(p0r, t2r), s0i = _mm_add_ps(p0i, t2i);
+            __m128 s1r = _mm_sub_ps(p0r, t2r), s1i = _mm_sub_ps(p0i, t2i);
+            __m128 s2r = _mm_add_ps(t1r, t3r), s2i = _mm_add_ps(t1i, t3i);
+            __m128 s3r = _mm_sub_ps(t1r, t3r), s3i = _mm_sub_ps(t1i, t3i);
+
+            _mm_store_ps(r0 + j, _mm_add_ps(s0r, s2r));
+            _mm_store_ps(i0 + j, _mm_add_ps(s0i, s2i));
+            _mm_store_ps(r1 + j, _mm_sub_ps(s0r, s2r));
+            _mm_store_ps(i1 + j, _mm_sub_ps(s0i, s2i));
+            _mm_store_ps(r2 + j, _mm_add_ps(s1r, s3i));
+            _mm_store_ps(i2 + j, _mm_sub_ps(s1i, s3r));
+            _mm_store_ps(r3 + j, _mm_sub_ps(s1r, s3i));
+            _mm_store_ps(i3 + j, _mm_add_ps(s1i, s3r));
+        }
+#endif
+        for (; j < L; ++j) {
+            float t1r = r1[j] * w1r[j] - i1[j] * w1i[j], t1i = r1[j] * w1i[j] + i1[j] * w1r[j];
+            float t2r = r2[j] * w2r[j] - i2[j] * w2i[j], t2i = r2[j] * w2i[j] + i2[j] * w2r[j];
+            float t3r = r3[j] * w3r[j] - i3[j] * w3i[j], t3i = r3[j] * w3i[j] + i3[j] * w3r[j];
+
+            float s0r = r0[j] + t2r, s0i = i0[j] + t2i;
+            float s1r = r0[j] - t2r, s1i = i0[j] - t2i;
+            float s2r = t1r + t3r, s2i = t1i + t3i;
+            float s3r = t1r - t3r, s3i = t1i - t3i;
+
+            // Outputs X[j], X[j+L], X[j+2L], X[j+3L] in natural order.
+            r0[j] = s0r + s2r;
+            i0[j] = s0i + s2i;
+            r2[j] = s1r + s3i;
+            i2[j] = s1i - s3r;
+            r1[j] = s0r - s2r;
+            i1[j] = s0i - s2i;
+            r3[j] = s1r - s3i;
+            i3[j] = s1i + s3r;
+        }
+    }
+
+    // Unpacks the even/odd complex transform into the real-input spectrum.
+    void split(float* re, float* im) const {
+        re[0] = zr[0] + zi[0];
+        im[0] = 0.0f;
+        re[M] = zr[0] - zi[0];
+        im[M] = 0.0f;
+        for (size_t k = 1; k < M; ++k) {
+            float ar = zr[k], ai = zi[k];
+            float br = zr[M - k], bi = -zi[M - k];
+            float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+            // (a - b) / 2 times -i
+            float orr = 0.5f * (ai - bi), oi = -0.5f * (ar - br);
+            float wr = tables.splitCos[k], wi = -tables.splitSin[k];
+            re[k] = er + orr * wr - oi * wi;
+            im[k] = ei + orr * wi + oi * wr;
+        }
+    }
+
+    alignas(16) float zr[M];
+    alignas(16) float zi[M];
+    alignas(16) float splitRe[M + 1];
+    alignas(16) float splitIm[M + 1];
+};
+
+template <size_t N>
+constexpr fixed_fft_detail::Tables<N> FixedFFT<N>::tables;
+
+// Runtime-sized front end over the compiled sizes, for callers whose size
+// comes from settings.
+class FixedFFTKernel {
+public:
+    virtual ~FixedFFTKernel() {}
+    virtual void forward(const float* x, float* re, float* im) = 0;
+    virtual void magnitudes(const float* x, float* out) = 0;
+};
+
+template <size_t N>
+class FixedFFTKernelOf : public FixedFFTKernel {
+public:
+    void forward(const float* x, float* re, float* im) override { fft.forward(x, re, im); }
+    void magnitudes(const float* x, float* out) override { fft.magnitudes(x, out); }
+
+private:
+    FixedFFT<N> fft;
+};
+
+// Null for sizes that aren't compiled in (256 through 8192 are).
+inline unique_ptr<FixedFFTKernel> makeFixedFFT(size_t size) {
+    switch (size) {
+        case 256: return unique_ptr<FixedFFTKernel>(new FixedFFTKernelOf<256>());
+        case 512: return unique_ptr<FixedFFTKernel>(new FixedFFTKernelOf<512>());
+        case 1024: return unique_ptr<FixedFFTKernel>(new FixedFFTKernelOf<1024>());
+        case 2048: return unique_ptr<FixedFFTKernel>(new FixedFFTKernelOf<2048>());
+        case 4096: return unique_ptr<FixedFFTKernel>(new FixedFFTKernelOf<4096>());
+        case 8192: return unique_ptr<FixedFFTKernel>(new FixedFFTKernelOf<8192>());
+        default: return nullptr;
+    }
+}
+
+#endif // FIXED_FFT_H
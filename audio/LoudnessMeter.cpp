@@ -0,0 +1,247 @@
+#define _USE_MATH_DEFINES
+#include "LoudnessMeter.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+static float powerToLoudness(double power) {
+    return power > 0.0 ? static_cast<float>(-0.691 + 10.0 * log10(power)) : LOUDNESS_FLOOR;
+}
+
+static float amplitudeToDecibels(float amplitude) {
+    return amplitude > 0.0f ? 20.0f * log10(amplitude) : LOUDNESS_FLOOR;
+}
+
+static float powerToDecibels(double power) {
+    return power > 0.0 ? static_cast<float>(10.0 * log10(power)) : LOUDNESS_FLOOR;
+}
+
+LoudnessMeter::LoudnessMeter(int sampleRate)
+    : sampleRate(sampleRate), subBlockLength(max(1, sampleRate / 10)),
+      subBlocks(SHORT_TERM_BLOCKS), histogramCount(HISTOGRAM_BINS), histogramPower(HISTOGRAM_BINS) {
+    // K-weighting: high shelf followed by the RLB high-pass, with the
+    // BS.1770 analogue prototypes re-derived for the actual sample rate.
+    double K = tan(M_PI * 1681.974450955533 / sampleRate);
+    double Q = 0.7071752369554196;
+    double Vh = pow(10.0, 3.999843853973347 / 20.0);
+    double Vb = pow(Vh, 0.4996667741545416);
+    double a0 = 1.0 + K / Q + K * K;
+    shelf.b0 = static_cast<float>((Vh + Vb * K / Q + K * K) / a0);
+    shelf.b1 = static_cast<float>(2.0 * (K * K - Vh) / a0);
+    shelf.b2 = static_cast<float>((Vh - Vb * K / Q + K * K) / a0);
+    shelf.a1 = static_cast<float>(2.0 * (K * K - 1.0) / a0);
+    shelf.a2 = static_cast<float>((1.0 - K / Q + K * K) / a0);
+
+    K = tan(M_PI * 38.13547087602444 / sampleRate);
+    Q = 0.5003270373238773;
+    a0 = 1.0 + K / Q + K * K;
+    highPass.b0 = 1.0f;
+    highPass.b1 = -2.0f;
+    highPass.b2 = 1.0f;
+    highPass.a1 = static_cast<float>(2.0 * (K * K - 1.0) / a0);
+    highPass.a2 = static_cast<float>((1.0 - K / Q + K * K) / a0);
+
+    // Hann-windowed sinc interpolator, one row per output phase. Tap k is
+    // applied to the sample k places after the oldest in the history.
+    for (size_t p = 0; p < PHASES; ++p) {
+        float sum = 0.0f;
+        for (size_t k = 0; k < TAPS; ++k) {
+            double t = (TAPS / 2.0 - 1.0) - static_cast<double>(k) + static_cast<double>(p) / PHASES;
+            double sinc = t == 0.0 ? 1.0 : sin(M_PI * t) / (M_PI * t);
+            double window = 0.5 * (1.0 + cos(M_PI * t / (TAPS / 2.0)));
+            interpolator[p][k] = static_cast<float>(sinc * window);
+            sum += interpolator[p][k];
+        }
+        for (size_t k = 0; k < TAPS; ++k) {
+            interpolator[p][k] /= sum;
+        }
+    }
+
+    reset();
+}
+
+void LoudnessMeter::reset() {
+    subBlockFill = 0;
+    subBlockCount = 0;
+    historyPos = 0;
+    maxTruePeak = 0.0f;
+    for (size_t ch = 0; ch < 2; ++ch) {
+        fill(begin(filterState[ch]), end(filterState[ch]), 0.0f);
+        fill(begin(history[ch]), end(history[ch]), 0.0f);
+        squareSum[ch] = 0.0;
+        peak[ch] = 0.0f;
+        truePeak[ch] = 0.0f;
+    }
+    weightedSum = 0.0;
+    fill(histogramCount.begin(), histogramCount.end(), 0u);
+    fill(histogramPower.begin(), histogramPower.end(), 0.0);
+    updateReading();
+}
+
+void LoudnessMeter::process(const float* left, const float* right, size_t frames, int channels) {
+    while (frames > 0) {
+        size_t chunk = min(frames, subBlockLength - subBlockFill);
+        size_t startPos = historyPos;
+        double leftWeighted = processChunk(left, 0, chunk);
+        historyPos = startPos;
+        double rightWeighted = processChunk(right, 1, chunk);
+        weightedSum += channels == 1 ? leftWeighted : leftWeighted + rightWeighted;
+
+        left += chunk;
+        right += chunk;
+        frames -= chunk;
+        subBlockFill += chunk;
+        if (subBlockFill == subBlockLength) {
+            finishSubBlock();
+        }
+    }
+}
+
+double LoudnessMeter::processChunk(const float* input, size_t channel, size_t frames) {
+    float* state = filterState[channel];
+    float* hist = history[channel];
+    size_t pos = historyPos;
+
+    float s0 = state[0], s1 = state[1], s2 = state[2], s3 = state[3];
+    float weighted = 0.0f, square = 0.0f, samplePeak = peak[channel], interPeak = truePeak[channel];
+
+    for (size_t i = 0; i < frames; ++i) {
+        float x = input[i];
+
+        // Transposed direct form II, both stages.
+        float y = shelf.b0 * x + s0;
+        s0 = shelf.b1 * x - shelf.a1 * y + s1;
+        s1 = shelf.b2 * x - shelf.a2 * y;
+        float z = highPass.b0 * y + s2;
+        s2 = highPass.b1 * y - highPass.a1 * z + s3;
+        s3 = highPass.b2 * y - highPass.a2 * z;
+
+        weighted += z * z;
+        square += x * x;
+        samplePeak = max(samplePeak, fabs(x));
+
+        hist[pos] = x;
+        hist[pos + TAPS] = x;
+        pos = pos + 1 == TAPS ? 0 : pos + 1;
+
+        // Phase 0 reproduces an input sample, already covered by the sample
+        // peak; only the three in-between phases need the dot product.
+        const float* window = hist + pos;
+        for (size_t p = 1; p < PHASES; ++p) {
+            const float* taps = interpolator[p];
+            float acc0 = 0.0f, acc1 = 0.0f, acc2 = 0.0f, acc3 = 0.0f;
+            for (size_t k = 0; k < TAPS; k += 4) {
+                acc0 += taps[k] * window[k];
+                acc1 += taps[k + 1] * window[k + 1];
+                acc2 += taps[k + 2] * window[k + 2];
+                acc3 += taps[k + 3] * window[k + 3];
+            }
+            interPeak = max(interPeak, fabs((acc0 + acc1) + (acc2 + acc3)));
+        }
+    }
+
+    state[0] = s0;
+    state[1] = s1;
+    state[2] = s2;
+    state[3] = s3;
+    historyPos = pos;
+    squareSum[channel] += square;
+    peak[channel] = samplePeak;
+    truePeak[channel] = max(interPeak, samplePeak);
+    return weighted;
+}
+
+void LoudnessMeter::finishSubBlock() {
+    SubBlock& block = subBlocks[subBlockCount % SHORT_TERM_BLOCKS];
+    block.weightedPower = weightedSum / subBlockLength;
+    weightedSum = 0.0;
+    for (size_t ch = 0; ch < 2; ++ch) {
+        block.power[ch] = squareSum[ch] / subBlockLength;
+        block.peak[ch] = peak[ch];
+        block.truePeak[ch] = truePeak[ch];
+        maxTruePeak = max(maxTruePeak, truePeak[ch]);
+
+        squareSum[ch] = 0.0;
+        peak[ch] = 0.0f;
+        truePeak[ch] = 0.0f;
+    }
+    subBlockFill = 0;
+    ++subBlockCount;
+
+    // Every 100 ms completes a 400 ms gating block (75% overlap).
+    if (subBlockCount >= MOMENTARY_BLOCKS) {
+        double gatingPower = 0.0;
+        for (size_t i = 0; i < MOMENTARY_BLOCKS; ++i) {
+            gatingPower += subBlocks[(subBlockCount - 1 - i) % SHORT_TERM_BLOCKS].weightedPower;
+        }
+        gatingPower /= MOMENTARY_BLOCKS;
+
+        float loudness = powerToLoudness(gatingPower);
+        if (loudness > -70.0f) {
+            size_t bin = min(HISTOGRAM_BINS - 1, static_cast<size_t>((loudness + 70.0f) * 10.0f));
+            ++histogramCount[bin];
+            histogramPower[bin] += gatingPower;
+        }
+    }
+
+    updateReading();
+}
+
+void LoudnessMeter::updateReading() {
+    size_t available = min(subBlockCount, SHORT_TERM_BLOCKS);
+    size_t momentaryBlocks = min(subBlockCount, MOMENTARY_BLOCKS);
+
+    double momentaryPower = 0.0, shortTermPower = 0.0;
+    double power[2] = {0.0, 0.0};
+    float blockPeak[2] = {0.0f, 0.0f};
+    float blockTruePeak[2] = {0.0f, 0.0f};
+    for (size_t i = 0; i < available; ++i) {
+        const SubBlock& block = subBlocks[(subBlockCount - 1 - i) % SHORT_TERM_BLOCKS];
+        shortTermPower += block.weightedPower;
+        if (i < momentaryBlocks) {
+            momentaryPower += block.weightedPower;
+            for (size_t ch = 0; ch < 2; ++ch) {
+                power[ch] += block.power[ch];
+                blockPeak[ch] = max(blockPeak[ch], block.peak[ch]);
+                blockTruePeak[ch] = max(blockTruePeak[ch], block.truePeak[ch]);
+            }
+        }
+    }
+
+    reading.momentary = momentaryBlocks ? powerToLoudness(momentaryPower / momentaryBlocks) : LOUDNESS_FLOOR;
+    reading.shortTerm = available ? powerToLoudness(shortTermPower / available) : LOUDNESS_FLOOR;
+    for (size_t ch = 0; ch < 2; ++ch) {
+        reading.peak[ch] = amplitudeToDecibels(blockPeak[ch]);
+        reading.truePeak[ch] = amplitudeToDecibels(blockTruePeak[ch]);
+        reading.rms[ch] = momentaryBlocks ? powerToDecibels(power[ch] / momentaryBlocks) : LOUDNESS_FLOOR;
+    }
+    reading.maxTruePeak = amplitudeToDecibels(maxTruePeak);
+
+    // Two-stage gate: absolute -70 LUFS (applied on insert), then relative
+    // -10 LU below the absolute-gated mean.
+    unsigned totalCount = 0;
+    double totalPower = 0.0;
+    for (size_t bin = 0; bin < HISTOGRAM_BINS; ++bin) {
+        totalCount += histogramCount[bin];
+        totalPower += histogramPower[bin];
+    }
+    if (totalCount == 0) {
+        reading.integrated = LOUDNESS_FLOOR;
+        return;
+    }
+
+    float relativeGate = powerToLoudness(totalPower / totalCount) - 10.0f;
+    size_t firstBin = static_cast<size_t>(max(0.0f, ceil((relativeGate + 70.0f) * 10.0f)));
+    unsigned gatedCount = 0;
+    double gatedPower = 0.0;
+    for (size_t bin = firstBin; bin < HISTOGRAM_BINS; ++bin) {
+        gatedCount += histogramCount[bin];
+        gatedPower += histogramPower[bin];
+    }
+    reading.integrated = gatedCount ? powerToLoudness(gatedPower / gatedCount) : LOUDNESS_FLOOR;
+}
+
+const LoudnessReading& LoudnessMeter::getReading() const {
+    return reading;
+}
@@ -0,0 +1,91 @@
+#ifndef LOUDNESS_METER_H
+#define LOUDNESS_METER_H
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Levels in dBFS / dBTP / LUFS. Silence reads as LOUDNESS_FLOOR.
+struct LoudnessReading {
+    float peak[2];        // sample peak over the momentary window
+    float truePeak[2];    // 4x oversampled peak over the momentary window
+    float rms[2];         // unweighted RMS over the momentary window
+    float maxTruePeak;    // highest true peak since reset
+    float momentary;      // EBU R128, 400 ms
+    float shortTerm;      // EBU R128, 3 s
+    float integrated;     // EBU R128, gated over the whole programme
+};
+
+const float LOUDNESS_FLOOR = -144.0f;
+
+// Incremental ITU-R BS.1770 / EBU R128 meter for a mono or stereo stream.
+//
+// Samples are folded into 100 ms sub-blocks as they arrive; the momentary,
+// short-term and integrated values are derived from those sub-blocks, so the
+// per-sample work is just the K-weighting biquads, a sum of squares and the
+// true-peak interpolator. Integrated loudness uses a 0.1 LU histogram of
+// gating blocks, so memory stays constant regardless of programme length.
+class LoudnessMeter {
+public:
+    LoudnessMeter(int sampleRate);
+
+    // Mono arrives as identical left and right; channels == 1 makes only
+    // one of them count towards loudness, as BS.1770 sums a mono programme.
+    void process(const float* left, const float* right, size_t frames, int channels = 2);
+    void reset();
+
+    // Refreshed every 100 ms sub-block.
+    const LoudnessReading& getReading() const;
+
+private:
+    struct Biquad {
+        float b0, b1, b2, a1, a2;
+    };
+
+    struct SubBlock {
+        double weightedPower;   // K-weighted mean square, summed over channels
+        double power[2];        // unweighted mean square per channel
+        float peak[2];
+        float truePeak[2];
+    };
+
+    static const size_t TAPS = 12;
+    static const size_t PHASES = 4;
+    static const size_t SHORT_TERM_BLOCKS = 30;
+    static const size_t MOMENTARY_BLOCKS = 4;
+    static const size_t HISTOGRAM_BINS = 1000;  // -70 .. +30 LUFS in 0.1 LU steps
+
+    // Returns the chunk's K-weighted sum of squares.
+    double processChunk(const float* input, size_t channel, size_t frames);
+    void finishSubBlock();
+    void updateReading();
+
+    int sampleRate;
+    size_t subBlockLength;
+    size_t subBlockFill;
+
+    Biquad shelf, highPass;
+    float filterState[2][4];
+
+    // Doubled history so each interpolation reads TAPS contiguous samples.
+    float history[2][2 * TAPS];
+    size_t historyPos;
+    float interpolator[PHASES][TAPS];
+
+    double weightedSum;  // over the channels that count towards loudness
+    double squareSum[2];
+    float peak[2];
+    float truePeak[2];
+
+    vector<SubBlock> subBlocks;
+    size_t subBlockCount;
+    float maxTruePeak;
+
+    vector<unsigned> histogramCount;
+    vector<double> histogramPower;
+
+    LoudnessReading reading;
+};
+
+#endif // LOUDNESS_METER_H
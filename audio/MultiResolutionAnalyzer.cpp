@@ -0,0 +1,216 @@
+#define _USE_MATH_DEFINES
+#include "MultiResolutionAnalyzer.h"
+#ifndef MPV_NO_FFTW
+#include <fftw3.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+// Window sizes and hops, shortest first. At 44.1 kHz the 8192-point window
+// resolves 5.4 Hz, the 512-point one 11.6 ms of time.
+static const size_t RESOLUTION_SIZES[] = {512, 2048, 8192};
+static const size_t RESOLUTION_HOPS[] = {256, 512, 2048};
+
+static const float LOWEST_BAND = 30.0f;
+static const float HIGHEST_BAND = 16000.0f;
+
+static double elapsedMs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+MultiResolutionAnalyzer::MultiResolutionAnalyzer(int sampleRate, size_t referenceSize, FFTBackend backend)
+    : referenceScale(static_cast<float>(referenceSize) / 2.0f),
+      averageMs(0.0), peakMs(0.0), boundMs(0.0), transforms(0) {
+    size_t longest = RESOLUTION_SIZES[sizeof(RESOLUTION_SIZES) / sizeof(RESOLUTION_SIZES[0]) - 1];
+    history.assign(longest, 0.0f);
+    hann.resize(longest);
+    for (size_t i = 0; i < longest; ++i) {
+        hann[i] = static_cast<float>(0.5 - 0.5 * cos(2.0 * M_PI * i / longest));
+    }
+
+    // One scratch pair for every plan; FFTW only needs the pointers to stay
+    // valid, not a buffer per size.
+    scratchInput = new float[longest];
+    scratchOutput = new float[longest];
+
+    for (size_t i = 0; i < sizeof(RESOLUTION_SIZES) / sizeof(RESOLUTION_SIZES[0]); ++i) {
+        Resolution resolution;
+        resolution.size = RESOLUTION_SIZES[i];
+        resolution.hop = RESOLUTION_HOPS[i];
+        resolution.pending = 0;
+        resolution.magnitudes.assign(resolution.size / 2, 0.0f);
+        resolution.plan = nullptr;
+        // Every size here has a fixed kernel.
+#ifdef MPV_NO_FFTW
+        (void)backend;
+        resolution.fixed = makeFixedFFT(resolution.size);
+#else
+        if (backend == FFTBackend::Fixed) {
+            resolution.fixed = makeFixedFFT(resolution.size);
+        } else {
+            resolution.plan = fftwf_plan_r2r_1d(static_cast<int>(resolution.size), scratchInput, scratchOutput,
+                                                FFTW_R2HC, FFTW_MEASURE);
+            if (!resolution.plan) {
+                cerr << "ERROR: Failed to create FFTW plan for " << resolution.size << " points." << endl;
+            }
+        }
+#endif
+        resolutions.push_back(move(resolution));
+    }
+
+    // Band edges and the resolution that serves each band never change, so
+    // the per-push work is a table walk.
+    float nyquist = sampleRate / 2.0f;
+    float highest = min(HIGHEST_BAND, nyquist * 0.95f);
+    float ratio = pow(highest / LOWEST_BAND, 1.0f / SPECTRUM_BANDS);
+    bands.assign(SPECTRUM_BANDS, 0.0f);
+    for (size_t b = 0; b < SPECTRUM_BANDS; ++b) {
+        float low = LOWEST_BAND * pow(ratio, static_cast<float>(b));
+        float high = low * ratio;
+        bandFrequencies.push_back(sqrt(low * high));
+
+        size_t chosen = resolutions.size() - 1;
+        for (size_t r = 0; r < resolutions.size(); ++r) {
+            float binWidth = static_cast<float>(sampleRate) / resolutions[r].size;
+            if (binWidth * 2.0f <= high - low) {
+                chosen = r;
+                break;
+            }
+        }
+
+        const Resolution& resolution = resolutions[chosen];
+        float binWidth = static_cast<float>(sampleRate) / resolution.size;
+        BandSource source;
+        source.resolution = chosen;
+        source.startBin = min(resolution.size / 2 - 1, static_cast<size_t>(round(low / binWidth)));
+        source.endBin = min(resolution.size / 2 - 1, static_cast<size_t>(round(high / binWidth)));
+        source.endBin = max(source.startBin, source.endBin);
+        bandSources.push_back(source);
+    }
+
+    // Cost bound: time one transform of every size, the most a push can do.
+    auto start = chrono::steady_clock::now();
+    for (auto& resolution : resolutions) {
+        transform(resolution);
+    }
+    boundMs = elapsedMs(start);
+    transforms = 0;
+}
+
+MultiResolutionAnalyzer::~MultiResolutionAnalyzer() {
+#ifndef MPV_NO_FFTW
+    for (auto& resolution : resolutions) {
+        if (resolution.plan) {
+            fftwf_destroy_plan(static_cast<fftwf_plan>(resolution.plan));
+        }
+    }
+#endif
+    delete[] scratchInput;
+    delete[] scratchOutput;
+}
+
+void MultiResolutionAnalyzer::push(const float* samples, size_t count) {
+    auto start = chrono::steady_clock::now();
+
+    if (count >= history.size()) {
+        copy(samples + count - history.size(), samples + count, history.begin());
+    } else {
+        move(history.begin() + count, history.end(), history.begin());
+        copy(samples, samples + count, history.end() - count);
+    }
+
+    bool changed = false;
+    for (auto& resolution : resolutions) {
+        resolution.pending += count;
+        if (resolution.pending >= resolution.hop) {
+            // Only the newest window matters for display, so a resolution
+            // that fell several hops behind still runs once.
+            resolution.pending = 0;
+            transform(resolution);
+            changed = true;
+        }
+    }
+    if (changed) {
+        stitch();
+    }
+
+    double ms = elapsedMs(start);
+    averageMs += 0.05 * (ms - averageMs);
+    peakMs = max(peakMs, ms);
+}
+
+void MultiResolutionAnalyzer::reset(const vector<float>& samples) {
+    fill(history.begin(), history.end(), 0.0f);
+    size_t keep = min(samples.size(), history.size());
+    copy(samples.end() - keep, samples.end(), history.end() - keep);
+
+    for (auto& resolution : resolutions) {
+        resolution.pending = 0;
+        transform(resolution);
+    }
+    stitch();
+}
+
+void MultiResolutionAnalyzer::transform(Resolution& resolution) {
+    if (!resolution.plan && !resolution.fixed) return;
+
+    size_t size = resolution.size;
+    size_t stride = hann.size() / size;
+    const float* window = history.data() + history.size() - size;
+    for (size_t i = 0; i < size; ++i) {
+        scratchInput[i] = window[i] * hann[i * stride];
+    }
+
+    // A Hann-windowed sine peaks at amplitude * size / 4; rescale to the
+    // reference FFT so every resolution reads on the same scale.
+    float scale = referenceScale * 4.0f / size;
+    if (resolution.fixed) {
+        resolution.fixed->magnitudes(scratchInput, resolution.magnitudes.data());
+        for (float& magnitude : resolution.magnitudes) {
+            magnitude *= scale;
+        }
+    } else {
+#ifndef MPV_NO_FFTW
+        fftwf_execute(static_cast<fftwf_plan>(resolution.plan));
+        for (size_t i = 0; i < size / 2; ++i) {
+            float real = scratchOutput[i];
+            float imag = i == 0 ? 0.0f : scratchOutput[size - i];
+            resolution.magnitudes[i] = sqrt(real * real + imag * imag) * scale;
+        }
+#endif
+    }
+    ++transforms;
+}
+
+void MultiResolutionAnalyzer::stitch() {
+    for (size_t b = 0; b < bandSources.size(); ++b) {
+        const BandSource& source = bandSources[b];
+        const vector<float>& magnitudes = resolutions[source.resolution].magnitudes;
+        bands[b] = *max_element(magnitudes.begin() + source.startBin, magnitudes.begin() + source.endBin + 1);
+    }
+}
+
+size_t MultiResolutionAnalyzer::getHistorySize() const {
+    return history.size();
+}
+
+const vector<float>& MultiResolutionAnalyzer::getBands() const {
+    return bands;
+}
+
+const vector<float>& MultiResolutionAnalyzer::getBandFrequencies() const {
+    return bandFrequencies;
+}
+
+AnalyzerCost MultiResolutionAnalyzer::getCost() const {
+    AnalyzerCost cost;
+    cost.averageMs = averageMs;
+    cost.peakMs = peakMs;
+    cost.boundMs = boundMs;
+    cost.transforms = transforms;
+    return cost;
+}
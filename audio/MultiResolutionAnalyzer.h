@@ -0,0 +1,80 @@
+#ifndef MULTI_RESOLUTION_ANALYZER_H
+#define MULTI_RESOLUTION_ANALYZER_H
+
+#include "FFTProcessor.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+// Log-spaced output bands from 30 Hz to 16 kHz (or Nyquist).
+const size_t SPECTRUM_BANDS = 96;
+
+struct AnalyzerCost {
+    double averageMs;   // moving average per push()
+    double peakMs;      // worst push() so far
+    double boundMs;     // worst case estimate: every resolution due at once
+    size_t transforms;  // FFTs run so far
+};
+
+// Runs several FFT sizes over one shared sample history and stitches them
+// into a single band vector: long windows resolve the bass, short windows
+// keep transients sharp in the treble. Each band is served by the shortest
+// window whose bins are still at most half the band's width.
+//
+// All sizes share one Hann table (a periodic Hann of length N, sampled every
+// k-th point, is exactly the Hann window of length N/k) and one pair of FFT
+// scratch buffers. Every resolution hops at its own rate but runs at most
+// once per push(), so the cost of a push is bounded by one transform of
+// each size.
+class MultiResolutionAnalyzer {
+public:
+    // Band levels are scaled like the magnitudes of a referenceSize-point
+    // rectangular FFT, the scale the rest of the analysis publishes in.
+    MultiResolutionAnalyzer(int sampleRate, size_t referenceSize, FFTBackend backend = DEFAULT_FFT_BACKEND);
+    ~MultiResolutionAnalyzer();
+
+    void push(const float* samples, size_t count);
+    // Replaces the history (oldest first) and recomputes every resolution.
+    void reset(const vector<float>& samples);
+
+    size_t getHistorySize() const;
+    const vector<float>& getBands() const;
+    const vector<float>& getBandFrequencies() const;  // band centres, Hz
+    AnalyzerCost getCost() const;
+
+private:
+    struct Resolution {
+        size_t size;
+        size_t hop;
+        size_t pending;              // samples pushed since it last ran
+        vector<float> magnitudes;    // size / 2 bins, already normalized
+        void* plan;                  // FFTW backend
+        unique_ptr<FixedFFTKernel> fixed;
+    };
+
+    struct BandSource {
+        size_t resolution;
+        size_t startBin, endBin;     // inclusive
+    };
+
+    void transform(Resolution& resolution);
+    void stitch();
+
+    float referenceScale;
+    vector<Resolution> resolutions;  // shortest first
+    vector<BandSource> bandSources;
+    vector<float> bandFrequencies;
+    vector<float> bands;
+
+    vector<float> history;           // newest sample last, longest window long
+    vector<float> hann;              // periodic, longest window long
+    float* scratchInput;
+    float* scratchOutput;
+
+    double averageMs, peakMs, boundMs;
+    size_t transforms;
+};
+
+#endif // MULTI_RESOLUTION_ANALYZER_H
@@ -0,0 +1,181 @@
+#include "ParallelMP3Decoder.h"
+#include "ThreadRoles.h"
+#include <mpg123.h>
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+// Frames decoded before each segment start. Layer III frames can borrow
+// up to 511 bytes of main data from earlier frames; a few frames of
+// pre-roll cover that at any bitrate.
+static const long RESERVOIR_PREROLL_FRAMES = 4;
+
+// Below this, splitting costs more than it saves.
+static const off_t MIN_SEGMENT_SECONDS = 10;
+
+static mpg123_handle* openHandle(const string& filePath) {
+    mpg123_handle* mh = mpg123_new(nullptr, nullptr);
+    if (!mh) {
+        cerr << "Failed to create mpg123 handle." << endl;
+        return nullptr;
+    }
+
+    mpg123_param(mh, MPG123_ADD_FLAGS, MPG123_GAPLESS | MPG123_FORCE_FLOAT, 0.0);
+    mpg123_param(mh, MPG123_PREFRAMES, RESERVOIR_PREROLL_FRAMES, 0.0);
+
+    if (mpg123_open(mh, filePath.c_str()) != MPG123_OK) {
+        cerr << "Failed to open file: " << filePath << endl;
+        mpg123_delete(mh);
+        return nullptr;
+    }
+    return mh;
+}
+
+static void closeHandle(mpg123_handle* mh) {
+    mpg123_close(mh);
+    mpg123_delete(mh);
+}
+
+ParallelMP3Decoder::ParallelMP3Decoder(size_t threadCount)
+    : threadCount(max<size_t>(1, threadCount)), indexStep(0) {}
+
+bool ParallelMP3Decoder::decode(const string& filePath, PcmStore& pcm, int& sampleRate) {
+    mpg123_handle* mh = openHandle(filePath);
+    if (!mh) {
+        return false;
+    }
+
+    long rate;
+    int channels, encoding;
+    if (mpg123_getformat(mh, &rate, &channels, &encoding) != MPG123_OK || encoding != MPG123_ENC_FLOAT_32) {
+        cerr << "Failed to get float audio format." << endl;
+        closeHandle(mh);
+        return false;
+    }
+
+    // One full pass over the frame headers (no decoding) gives the exact
+    // length and a complete seek index that every segment handle reuses.
+    if (mpg123_scan(mh) != MPG123_OK) {
+        cerr << "Failed to scan MP3 file: " << mpg123_strerror(mh) << endl;
+        closeHandle(mh);
+        return false;
+    }
+    off_t totalSamples = mpg123_length(mh);
+
+    off_t* offsets = nullptr;
+    size_t fill = 0;
+    if (mpg123_index(mh, &offsets, &indexStep, &fill) == MPG123_OK && offsets) {
+        frameIndex.assign(offsets, offsets + fill);
+    } else {
+        frameIndex.clear();
+    }
+    closeHandle(mh);
+
+    if (totalSamples <= 0) {
+        cerr << "Failed to determine MP3 length." << endl;
+        return false;
+    }
+
+    sampleRate = static_cast<int>(rate);
+    // Sized once up front so segments can write their ranges concurrently.
+    pcm.reset(pcm.getFormat(), channels);
+    pcm.resize(static_cast<size_t>(totalSamples));
+
+    size_t segmentCount = threadCount;
+    if (frameIndex.empty()) {
+        segmentCount = 1;
+    }
+    segmentCount = min<size_t>(segmentCount, max<off_t>(1, totalSamples / (MIN_SEGMENT_SECONDS * rate)));
+
+    vector<Segment> segments(segmentCount);
+    for (size_t i = 0; i < segmentCount; ++i) {
+        segments[i].start = totalSamples * static_cast<off_t>(i) / static_cast<off_t>(segmentCount);
+        segments[i].end = totalSamples * static_cast<off_t>(i + 1) / static_cast<off_t>(segmentCount);
+        segments[i].ok = false;
+    }
+
+    vector<thread> workers;
+    for (size_t i = 1; i < segmentCount; ++i) {
+        workers.emplace_back([&, i] {
+            applyThreadRole(ThreadRole::Decode);
+            decodeSegment(filePath, segments[i], channels, pcm);
+        });
+    }
+    decodeSegment(filePath, segments[0], channels, pcm);
+    for (thread& worker : workers) {
+        worker.join();
+    }
+
+    for (const Segment& segment : segments) {
+        if (!segment.ok) {
+            cerr << "Failed to decode MP3 segment at sample " << segment.start << "." << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ParallelMP3Decoder::decodeSegment(const string& filePath, Segment& segment, int channels,
+                                       PcmStore& pcm) const {
+    mpg123_handle* mh = openHandle(filePath);
+    if (!mh) {
+        return false;
+    }
+
+    // Reading the format up front keeps the first mpg123_read from
+    // stopping at MPG123_NEW_FORMAT.
+    long rate;
+    int formatChannels, encoding;
+    if (mpg123_getformat(mh, &rate, &formatChannels, &encoding) != MPG123_OK || formatChannels != channels) {
+        cerr << "Failed to get MP3 segment format." << endl;
+        closeHandle(mh);
+        return false;
+    }
+
+    if (!frameIndex.empty()) {
+        vector<off_t> index(frameIndex);
+        mpg123_set_index(mh, index.data(), indexStep, index.size());
+    }
+
+    // Sample-accurate: mpg123 lands on the frame before the target (minus
+    // the pre-roll frames), decodes forward and drops the excess.
+    if (segment.start > 0 && mpg123_seek(mh, segment.start, SEEK_SET) != segment.start) {
+        cerr << "Failed to seek MP3 segment: " << mpg123_strerror(mh) << endl;
+        closeHandle(mh);
+        return false;
+    }
+
+    size_t bufferSize = mpg123_outblock(mh);
+    vector<unsigned char> buffer(bufferSize);
+    off_t position = segment.start;
+    size_t done = 0;
+    int status = MPG123_OK;
+
+    while (position < segment.end) {
+        status = mpg123_read(mh, buffer.data(), bufferSize, &done);
+        if (status == MPG123_NEW_FORMAT) {
+            continue;
+        }
+        if (status != MPG123_OK && status != MPG123_DONE) {
+            break;
+        }
+
+        const float* samples = reinterpret_cast<const float*>(buffer.data());
+        off_t frames = static_cast<off_t>(done / (sizeof(float) * channels));
+        frames = min(frames, segment.end - position);
+        pcm.write(static_cast<size_t>(position), samples, static_cast<size_t>(frames));
+        position += frames;
+
+        if (status == MPG123_DONE) {
+            break;
+        }
+    }
+
+    closeHandle(mh);
+    // The last segment may come up a few samples short if the scanned
+    // length included padding the decoder trimmed; that tail stays silent.
+    segment.ok = position == segment.end || status == MPG123_DONE;
+    return segment.ok;
+}
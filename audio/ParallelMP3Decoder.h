@@ -0,0 +1,43 @@
+#ifndef PARALLEL_MP3_DECODER_H
+#define PARALLEL_MP3_DECODER_H
+
+#include "PcmStore.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+using namespace std;
+
+// Decodes one MP3 on several threads.
+//
+// A scan builds the frame index and exact (gapless) length once; the track
+// is then cut into equal sample ranges, each decoded on its own
+// mpg123_handle that reuses the index. Every segment handle seeks
+// sample-accurately to its start with a few frames of pre-roll decoded and
+// discarded to refill the Layer III bit reservoir, and writes straight into
+// its slice of the preallocated output, so segments join without seams.
+// Expects mpg123_init() to have been called (AudioFileReader does).
+class ParallelMP3Decoder {
+public:
+    ParallelMP3Decoder(size_t threadCount);
+
+    // Refills pcm in its current format, mono sources as one channel.
+    // On failure pcm is left partly written; decode it some other way.
+    bool decode(const string& filePath, PcmStore& pcm, int& sampleRate);
+
+private:
+    struct Segment {
+        off_t start;
+        off_t end;
+        bool ok;
+    };
+
+    bool decodeSegment(const string& filePath, Segment& segment, int channels, PcmStore& pcm) const;
+
+    size_t threadCount;
+    vector<off_t> frameIndex;
+    off_t indexStep;
+};
+
+#endif // PARALLEL_MP3_DECODER_H
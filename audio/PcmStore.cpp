@@ -0,0 +1,251 @@
+#include "PcmStore.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+static const float INT16_SCALE = 1.0f / 32768.0f;
+
+static int16_t floatToInt16(float sample) {
+    float scaled = nearbyintf(sample * 32768.0f);
+    return static_cast<int16_t>(min(32767.0f, max(-32768.0f, scaled)));
+}
+
+// Round to nearest even, with overflow to infinity and gradual underflow.
+static uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    uint32_t magnitude = bits & 0x7fffffffu;
+
+    if (magnitude >= 0x7f800000u) {  // inf or NaN
+        return static_cast<uint16_t>(sign | 0x7c00u | (magnitude > 0x7f800000u ? 0x200u : 0u));
+    }
+    if (magnitude >= 0x477ff000u) {  // rounds past the largest half
+        return static_cast<uint16_t>(sign | 0x7c00u);
+    }
+    if (magnitude < 0x38800000u) {   // half subnormal or zero
+        if (magnitude < 0x33000000u) return static_cast<uint16_t>(sign);
+        uint32_t exponent = magnitude >> 23;
+        uint32_t mantissa = (magnitude & 0x7fffffu) | 0x800000u;
+        uint32_t shift = 126 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t midpoint = 1u << (shift - 1);
+        if (remainder > midpoint || (remainder == midpoint && (half & 1u))) ++half;
+        return static_cast<uint16_t>(sign | half);
+    }
+    uint32_t half = ((magnitude - 0x38000000u) >> 13);
+    uint32_t remainder = magnitude & 0x1fffu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) ++half;
+    return static_cast<uint16_t>(sign | half);
+}
+
+// Shifts the half's exponent and mantissa into float position and fixes
+// the exponent bias with one multiply, which also normalizes subnormals.
+static float halfToFloat(uint16_t half) {
+    uint32_t exponentMantissa = half & 0x7fffu;
+    uint32_t shifted = exponentMantissa << 13;
+    float scaled;
+    memcpy(&scaled, &shifted, sizeof(scaled));
+    scaled *= 5.192296858534828e33f;  // 2^112
+    uint32_t bits;
+    memcpy(&bits, &scaled, sizeof(bits));
+    if (exponentMantissa >= 0x7c00u) bits |= 0x7f800000u;  // inf or NaN
+    bits |= static_cast<uint32_t>(half & 0x8000u) << 16;
+    memcpy(&scaled, &bits, sizeof(scaled));
+    return scaled;
+}
+
+PcmStore::PcmStore() : format(PcmFormat::Float32), channels(1), frames(0) {}
+
+void PcmStore::reset(PcmFormat newFormat, int newChannels) {
+    format = newFormat;
+    channels = newChannels == 1 ? 1 : 2;
+    frames = 0;
+    for (int c = 0; c < 2; ++c) {
+        vector<float>().swap(floatSamples[c]);
+        vector<int16_t>().swap(int16Samples[c]);
+        vector<uint16_t>().swap(halfSamples[c]);
+    }
+}
+
+void PcmStore::resize(size_t newFrames) {
+    frames = newFrames;
+    for (int c = 0; c < channels; ++c) {
+        switch (format) {
+            case PcmFormat::Float32: floatSamples[c].resize(frames); break;
+            case PcmFormat::Int16: int16Samples[c].resize(frames); break;
+            case PcmFormat::Float16: halfSamples[c].resize(frames); break;
+        }
+    }
+}
+
+void PcmStore::shrink() {
+    for (int c = 0; c < channels; ++c) {
+        floatSamples[c].shrink_to_fit();
+        int16Samples[c].shrink_to_fit();
+        halfSamples[c].shrink_to_fit();
+    }
+}
+
+void PcmStore::append(const float* interleaved, size_t count) {
+    size_t position = frames;
+    resize(frames + count);
+    encode(position, interleaved, count);
+}
+
+void PcmStore::append(const int16_t* interleaved, size_t count) {
+    if (format == PcmFormat::Int16) {
+        size_t position = frames;
+        resize(frames + count);
+        for (int c = 0; c < channels; ++c) {
+            int16_t* out = int16Samples[c].data() + position;
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = interleaved[i * channels + c];
+            }
+        }
+        return;
+    }
+
+    float converted[1024];
+    size_t chunk = sizeof(converted) / sizeof(converted[0]) / channels;
+    for (size_t done = 0; done < count; done += chunk) {
+        size_t n = min(chunk, count - done);
+        for (size_t i = 0; i < n * channels; ++i) {
+            converted[i] = interleaved[done * channels + i] * INT16_SCALE;
+        }
+        append(converted, n);
+    }
+}
+
+void PcmStore::write(size_t position, const float* interleaved, size_t count) {
+    count = position < frames ? min(count, frames - position) : 0;
+    encode(position, interleaved, count);
+}
+
+void PcmStore::encode(size_t position, const float* interleaved, size_t count) {
+    for (int c = 0; c < channels; ++c) {
+        const float* in = interleaved + c;
+        switch (format) {
+            case PcmFormat::Float32: {
+                float* out = floatSamples[c].data() + position;
+                for (size_t i = 0; i < count; ++i) out[i] = in[i * channels];
+                break;
+            }
+            case PcmFormat::Int16: {
+                int16_t* out = int16Samples[c].data() + position;
+                for (size_t i = 0; i < count; ++i) out[i] = floatToInt16(in[i * channels]);
+                break;
+            }
+            case PcmFormat::Float16: {
+                uint16_t* out = halfSamples[c].data() + position;
+                for (size_t i = 0; i < count; ++i) out[i] = floatToHalf(in[i * channels]);
+                break;
+            }
+        }
+    }
+}
+
+void PcmStore::expand(int channel, size_t offset, size_t count, float* out) const {
+    size_t i = 0;
+    switch (format) {
+        case PcmFormat::Float32:
+            memcpy(out, floatSamples[channel].data() + offset, count * sizeof(float));
+            return;
+
+        case PcmFormat::Int16: {
+            const int16_t* in = int16Samples[channel].data() + offset;
+#ifdef __SSE2__
+            const __m128 scale = _mm_set1_ps(INT16_SCALE);
+            for (; i + 8 <= count; i += 8) {
+                __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                // Each sample into the top half of a 32-bit lane, then an
+                // arithmetic shift back down sign-extends it.
+                __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+                __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16);
+                _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+                _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+            }
+#endif
+            for (; i < count; ++i) out[i] = in[i] * INT16_SCALE;
+            return;
+        }
+
+        case PcmFormat::Float16: {
+            const uint16_t* in = halfSamples[channel].data() + offset;
+#if defined(__F16C__)
+            for (; i + 8 <= count; i += 8) {
+                __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                _mm_storeu_ps(out + i, _mm_cvtph_ps(packed));
+                _mm_storeu_ps(out + i + 4, _mm_cvtph_ps(_mm_srli_si128(packed, 8)));
+            }
+#elif defined(__SSE2__)
+            // halfToFloat four lanes at a time.
+            const __m128i exponentMantissaMask = _mm_set1_epi32(0x7fff);
+            const __m128i infNaNThreshold = _mm_set1_epi32(0x7bff);
+            const __m128i infNaNExponent = _mm_set1_epi32(0x7f800000);
+            const __m128 rebias = _mm_set1_ps(5.192296858534828e33f);
+            const __m128i zero = _mm_setzero_si128();
+            for (; i + 8 <= count; i += 8) {
+                __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                __m128i lanes[2] = {_mm_unpacklo_epi16(packed, zero), _mm_unpackhi_epi16(packed, zero)};
+                for (int half = 0; half < 2; ++half) {
+                    __m128i exponentMantissa = _mm_and_si128(lanes[half], exponentMantissaMask);
+                    __m128i sign = _mm_slli_epi32(_mm_xor_si128(lanes[half], exponentMantissa), 16);
+                    __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(exponentMantissa, 13)), rebias);
+                    __m128i infNaN = _mm_and_si128(_mm_cmpgt_epi32(exponentMantissa, infNaNThreshold), infNaNExponent);
+                    __m128 result = _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infNaN)));
+                    _mm_storeu_ps(out + i + 4 * half, result);
+                }
+            }
+#endif
+            for (; i < count; ++i) out[i] = halfToFloat(in[i]);
+            return;
+        }
+    }
+}
+
+size_t PcmStore::read(size_t offset, size_t count, float* left, float* right) const {
+    count = offset < frames ? min(count, frames - offset) : 0;
+    if (count == 0) return 0;
+
+    expand(0, offset, count, left);
+    if (right) {
+        if (channels == 2) {
+            expand(1, offset, count, right);
+        } else {
+            memcpy(right, left, count * sizeof(float));
+        }
+    }
+    return count;
+}
+
+size_t PcmStore::size() const {
+    return frames;
+}
+
+int PcmStore::getChannels() const {
+    return channels;
+}
+
+PcmFormat PcmStore::getFormat() const {
+    return format;
+}
+
+size_t PcmStore::memoryBytes() const {
+    size_t bytes = 0;
+    for (int c = 0; c < 2; ++c) {
+        bytes += floatSamples[c].capacity() * sizeof(float);
+        bytes += int16Samples[c].capacity() * sizeof(int16_t);
+        bytes += halfSamples[c].capacity() * sizeof(uint16_t);
+    }
+    return bytes;
+}
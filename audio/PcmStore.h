@@ -0,0 +1,61 @@
+#ifndef PCM_STORE_H
+#define PCM_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+enum class PcmFormat {
+    Float32,  // exact, 4 bytes per sample
+    Int16,    // 2 bytes; the serial MP3 decoder produces 16-bit anyway
+    Float16   // 2 bytes, 11 significant bits at any level
+};
+
+// Decoded PCM for one track, kept planar in a compact format. Mono sources
+// are stored once and read back into both channels.
+//
+// Nothing is expanded up front: read() converts only the range it is asked
+// for (a callback block, an analysis window) straight into the caller's
+// float buffers, eight samples at a time with SSE2 where available. Encoding
+// happens once at load and is scalar.
+class PcmStore {
+public:
+    PcmStore();
+
+    // Empties the store. channels must be 1 or 2.
+    void reset(PcmFormat format, int channels);
+
+    void append(const float* interleaved, size_t frames);
+    void append(const int16_t* interleaved, size_t frames);
+    // Releases growth slack once appending is done.
+    void shrink();
+
+    // For decoders that know the length up front: size once, then write
+    // disjoint ranges, from several threads if need be.
+    void resize(size_t frames);
+    void write(size_t position, const float* interleaved, size_t frames);
+
+    // Expands up to count frames starting at offset; right may be null.
+    // Returns the frames read, fewer near the end.
+    size_t read(size_t offset, size_t count, float* left, float* right) const;
+
+    size_t size() const;
+    int getChannels() const;
+    PcmFormat getFormat() const;
+    size_t memoryBytes() const;
+
+private:
+    void encode(size_t position, const float* interleaved, size_t frames);
+    void expand(int channel, size_t offset, size_t count, float* out) const;
+
+    PcmFormat format;
+    int channels;
+    size_t frames;
+    vector<float> floatSamples[2];
+    vector<int16_t> int16Samples[2];
+    vector<uint16_t> halfSamples[2];
+};
+
+#endif // PCM_STORE_H
@@ -0,0 +1,76 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+// The most recent stereo samples, interleaved, for scenes that draw the
+// waveform itself. One writer (the analysis thread) appends every block it
+// consumes and never waits. Readers copy spans by absolute sample count:
+// any span ending at or before written() and no longer than half the ring
+// is stable during the copy, since the writer would need half a ring of
+// audio (over a third of a second at 192 kHz) to lap it.
+class SampleRing {
+public:
+    SampleRing() : sampleRate(0), writeCount(0) {}
+
+    // capacity must be a power of two.
+    void allocate(size_t capacity) {
+        samples.assign(capacity * 2, 0.0f);
+        writeCount = 0;
+    }
+
+    // Set before the first write; readers scale time bases by it.
+    void setSampleRate(int rate) {
+        sampleRate = rate;
+    }
+
+    int getSampleRate() const {
+        return sampleRate;
+    }
+
+    void write(const float* left, const float* right, size_t frames) {
+        uint64_t count = writeCount.load(memory_order_relaxed);
+        size_t mask = capacity() - 1;
+        for (size_t i = 0; i < frames; ++i) {
+            size_t slot = static_cast<size_t>(count + i) & mask;
+            samples[slot * 2] = left[i];
+            samples[slot * 2 + 1] = right[i];
+        }
+        writeCount.store(count + frames, memory_order_release);
+    }
+
+    uint64_t written() const {
+        return writeCount.load(memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return samples.size() / 2;
+    }
+
+    // Copies up to count frames ending at sample end into out as L, R
+    // pairs. Returns the frames copied: fewer when the span reaches back
+    // before the first sample or beyond half the ring.
+    size_t read(uint64_t end, size_t count, float* out) const {
+        count = static_cast<size_t>(min<uint64_t>({count, end, capacity() / 2}));
+        size_t mask = capacity() - 1;
+        size_t first = static_cast<size_t>(end - count) & mask;
+        size_t head = min(count, capacity() - first);
+        memcpy(out, &samples[first * 2], head * 2 * sizeof(float));
+        memcpy(out + head * 2, samples.data(), (count - head) * 2 * sizeof(float));
+        return count;
+    }
+
+private:
+    vector<float> samples;
+    int sampleRate;
+    atomic<uint64_t> writeCount;
+};
+
+#endif // SAMPLE_RING_H
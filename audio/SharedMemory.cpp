@@ -0,0 +1,124 @@
+#include "SharedMemory.h"
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+SharedMemoryRegion::SharedMemoryRegion() : address(nullptr), length(0), owner(false), handle(nullptr) {}
+
+SharedMemoryRegion::~SharedMemoryRegion() {
+    close();
+}
+
+bool SharedMemoryRegion::create(const string& regionName, size_t size) {
+    return map(regionName, size, true);
+}
+
+bool SharedMemoryRegion::open(const string& regionName, size_t size) {
+    return map(regionName, size, false);
+}
+
+#ifdef _WIN32
+
+bool SharedMemoryRegion::map(const string& regionName, size_t size, bool creating) {
+    close();
+    // Windows mapping names can't start with '/', the POSIX convention.
+    string mappingName = regionName[0] == '/' ? regionName.substr(1) : regionName;
+    HANDLE mapping = creating
+        ? CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+                             static_cast<DWORD>(size), mappingName.c_str())
+        : OpenFileMappingA(FILE_MAP_READ, FALSE, mappingName.c_str());
+    if (!mapping) {
+        cerr << "ERROR: Cannot " << (creating ? "create" : "open") << " shared memory " << regionName << endl;
+        return false;
+    }
+
+    address = MapViewOfFile(mapping, creating ? FILE_MAP_READ | FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+    if (!address) {
+        cerr << "ERROR: Cannot map shared memory " << regionName << endl;
+        CloseHandle(mapping);
+        return false;
+    }
+    handle = mapping;
+    name = regionName;
+    length = size;
+    owner = creating;
+    return true;
+}
+
+void SharedMemoryRegion::close() {
+    if (address) UnmapViewOfFile(address);
+    if (handle) CloseHandle(static_cast<HANDLE>(handle));
+    address = nullptr;
+    handle = nullptr;
+    length = 0;
+    owner = false;
+}
+
+#else
+
+bool SharedMemoryRegion::map(const string& regionName, size_t size, bool creating) {
+    close();
+    int fd = creating ? shm_open(regionName.c_str(), O_CREAT | O_RDWR, 0644)
+                      : shm_open(regionName.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        cerr << "ERROR: Cannot " << (creating ? "create" : "open") << " shared memory " << regionName << endl;
+        return false;
+    }
+    if (creating && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        cerr << "ERROR: Cannot size shared memory " << regionName << endl;
+        ::close(fd);
+        shm_unlink(regionName.c_str());
+        return false;
+    }
+    // Mapping past the end of a smaller region only faults on first touch,
+    // so check up front.
+    struct stat info;
+    if (!creating && (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < size)) {
+        cerr << "ERROR: Shared memory " << regionName << " is smaller than " << size << " bytes" << endl;
+        ::close(fd);
+        return false;
+    }
+
+    int protection = creating ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* mapped = mmap(nullptr, size, protection, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        cerr << "ERROR: Cannot map shared memory " << regionName << endl;
+        if (creating) shm_unlink(regionName.c_str());
+        return false;
+    }
+    address = mapped;
+    name = regionName;
+    length = size;
+    owner = creating;
+    return true;
+}
+
+void SharedMemoryRegion::close() {
+    if (address) {
+        munmap(address, length);
+        if (owner) shm_unlink(name.c_str());
+    }
+    address = nullptr;
+    length = 0;
+    owner = false;
+}
+
+#endif
+
+void* SharedMemoryRegion::data() const {
+    return address;
+}
+
+size_t SharedMemoryRegion::size() const {
+    return length;
+}
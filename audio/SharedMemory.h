@@ -0,0 +1,34 @@
+#ifndef SHARED_MEMORY_H
+#define SHARED_MEMORY_H
+
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+// A named shared-memory mapping: shm_open + mmap on POSIX, a named file
+// mapping on Windows. The creator owns the name and removes it on close.
+class SharedMemoryRegion {
+public:
+    SharedMemoryRegion();
+    ~SharedMemoryRegion();
+
+    // create() maps read-write; open() maps an existing region read-only.
+    bool create(const string& name, size_t size);
+    bool open(const string& name, size_t size);
+    void close();
+
+    void* data() const;
+    size_t size() const;
+
+private:
+    bool map(const string& name, size_t size, bool creating);
+
+    string name;
+    void* address;
+    size_t length;
+    bool owner;
+    void* handle;  // Windows mapping handle
+};
+
+#endif // SHARED_MEMORY_H
@@ -0,0 +1,70 @@
+#ifndef SHARED_SPECTRUM_H
+#define SHARED_SPECTRUM_H
+
+#include "LoudnessMeter.h"
+#include "MultiResolutionAnalyzer.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// Layout of the shared-memory spectrum ring written by SpectrumPublisher
+// and read through SpectrumReader. Plain data only, so any process (or
+// language) that maps the region can read it.
+//
+// Each slot is a seqlock: the writer bumps `sequence` to an odd value,
+// writes the payload, then bumps it to the next even value. A reader copies
+// the payload between two loads of `sequence` and retries if they differ or
+// are odd. `latest` names the newest complete frame; its slot is
+// latest % SHARED_SPECTRUM_SLOTS, so a slow reader is overtaken only after
+// SHARED_SPECTRUM_SLOTS frames.
+
+const char SHARED_SPECTRUM_DEFAULT_NAME[] = "/mpv_spectrum";
+const uint32_t SHARED_SPECTRUM_MAGIC = 0x4650564D;  // "MVPF" little-endian
+const uint32_t SHARED_SPECTRUM_VERSION = 1;
+const size_t SHARED_SPECTRUM_SLOTS = 8;
+const size_t SHARED_SPECTRUM_MAX_BINS = 4096;
+
+struct SharedSpectrumFrame {
+    atomic<uint32_t> sequence;
+    uint32_t binCount;
+    uint32_t bandCount;
+    uint32_t beat;                 // 1 if an onset landed in this hop
+    uint64_t frameIndex;
+    uint64_t samplePosition;
+    float beatStrength;
+    float tempo;
+    LoudnessReading loudness;
+    uint32_t checksum;             // FNV-1a over binCount magnitudes and bandCount bands
+    float magnitudes[SHARED_SPECTRUM_MAX_BINS];
+    float bands[SPECTRUM_BANDS];
+};
+
+struct SharedSpectrumHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t sampleRate;
+    atomic<uint32_t> writerActive;
+    atomic<uint64_t> latest;       // frameIndex of the newest complete frame, 0 before the first
+    SharedSpectrumFrame slots[SHARED_SPECTRUM_SLOTS];
+};
+
+static_assert(atomic<uint32_t>::is_always_lock_free && atomic<uint64_t>::is_always_lock_free,
+              "Seqlock counters must be lock-free to live in shared memory");
+
+inline uint32_t sharedSpectrumChecksum(const float* magnitudes, size_t binCount, const float* bands, size_t bandCount) {
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](const float* values, size_t count) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+        for (size_t i = 0; i < count * sizeof(float); ++i) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    };
+    mix(magnitudes, binCount);
+    mix(bands, bandCount);
+    return hash;
+}
+
+#endif // SHARED_SPECTRUM_H
@@ -0,0 +1,274 @@
+#define _USE_MATH_DEFINES
+#include "SpectralDescriptors.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+static const float ROLLOFF_SHARE = 0.85f;
+static const float LOWEST_MEL_FREQUENCY = 20.0f;
+static const float HIGHEST_MEL_FREQUENCY = 16000.0f;
+
+// Keeps logs finite in silent bins; far below any real signal's power.
+static const float POWER_FLOOR = 1e-12f;
+static const float SILENCE = 1e-9f;
+
+static const float LN2 = 0.69314718f;
+static const float SQRT2 = 1.41421356f;
+
+static float hzToMel(float frequency) {
+    return 2595.0f * log10(1.0f + frequency / 700.0f);
+}
+
+// log2 for positive normal floats: exponent from the bits, mantissa folded
+// into [sqrt(1/2), sqrt(2)) and ln(m) = 2 atanh((m - 1) / (m + 1)) to the
+// s^7 term, within 1e-7. The SSE version below is the same arithmetic.
+static float fastLog2(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    float exponent = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+    bits = (bits & 0x7fffffu) | 0x3f800000u;
+    float mantissa;
+    memcpy(&mantissa, &bits, sizeof(mantissa));
+    if (mantissa > SQRT2) {
+        mantissa *= 0.5f;
+        exponent += 1.0f;
+    }
+    float s = (mantissa - 1.0f) / (mantissa + 1.0f);
+    float s2 = s * s;
+    float ln = s * (2.0f + s2 * (2.0f / 3.0f + s2 * (2.0f / 5.0f + s2 * (2.0f / 7.0f))));
+    return exponent + ln * (1.0f / LN2);
+}
+
+#ifdef __SSE2__
+static inline __m128 fastLog2(__m128 x) {
+    __m128i bits = _mm_castps_si128(x);
+    __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    __m128 mantissa = _mm_castsi128_ps(
+        _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x7fffff)), _mm_set1_epi32(0x3f800000)));
+    __m128 high = _mm_cmpgt_ps(mantissa, _mm_set1_ps(SQRT2));
+    mantissa = _mm_sub_ps(mantissa, _mm_and_ps(high, _mm_mul_ps(mantissa, _mm_set1_ps(0.5f))));
+    exponent = _mm_add_ps(exponent, _mm_and_ps(high, _mm_set1_ps(1.0f)));
+
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 s = _mm_div_ps(_mm_sub_ps(mantissa, one), _mm_add_ps(mantissa, one));
+    __m128 s2 = _mm_mul_ps(s, s);
+    __m128 ln = _mm_add_ps(_mm_set1_ps(2.0f / 5.0f), _mm_mul_ps(s2, _mm_set1_ps(2.0f / 7.0f)));
+    ln = _mm_add_ps(_mm_set1_ps(2.0f / 3.0f), _mm_mul_ps(s2, ln));
+    ln = _mm_add_ps(_mm_set1_ps(2.0f), _mm_mul_ps(s2, ln));
+    ln = _mm_mul_ps(s, ln);
+    return _mm_add_ps(exponent, _mm_mul_ps(ln, _mm_set1_ps(1.0f / LN2)));
+}
+
+static inline float horizontalSum(__m128 v) {
+    __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+#endif
+
+SpectralDescriptors::SpectralDescriptors(size_t fftSize, int sampleRate) : hasPrevious(false) {
+    features = SpectralFeatures();
+    configure(fftSize, sampleRate);
+}
+
+void SpectralDescriptors::configure(size_t fftSize, int sampleRate) {
+    tables = tablesFor(fftSize, sampleRate);
+    power.assign(tables->bins, 0.0f);
+    previous.assign(tables->bins, 0.0f);
+    reset();
+}
+
+void SpectralDescriptors::reset() {
+    hasPrevious = false;
+}
+
+shared_ptr<const SpectralDescriptors::Tables> SpectralDescriptors::tablesFor(size_t fftSize, int sampleRate) {
+    static mutex cacheMutex;
+    static map<pair<size_t, int>, shared_ptr<const Tables>> cache;
+
+    lock_guard<mutex> lock(cacheMutex);
+    auto& entry = cache[make_pair(fftSize, sampleRate)];
+    if (!entry) {
+        entry = buildTables(fftSize, sampleRate);
+    }
+    return entry;
+}
+
+shared_ptr<const SpectralDescriptors::Tables> SpectralDescriptors::buildTables(size_t fftSize, int sampleRate) {
+    auto tables = make_shared<Tables>();
+    tables->bins = fftSize / 2;
+    tables->binWidth = static_cast<float>(sampleRate) / fftSize;
+
+    // MEL_FILTERS + 2 edges evenly spaced in mel; filter k rises from edge k
+    // to a peak at edge k + 1 and falls to edge k + 2.
+    float lowMel = hzToMel(LOWEST_MEL_FREQUENCY);
+    float highMel = hzToMel(min(HIGHEST_MEL_FREQUENCY, sampleRate * 0.5f));
+    float melStep = (highMel - lowMel) / (MEL_FILTERS + 1);
+
+    tables->melSegment.assign(tables->bins, 0);
+    tables->melWeight.assign(tables->bins, 0.0f);
+    tables->firstMelBin = tables->bins;
+    tables->lastMelBin = 0;
+    for (size_t bin = 0; bin < tables->bins; ++bin) {
+        float position = (hzToMel(bin * tables->binWidth) - lowMel) / melStep;
+        if (position < 0.0f || position >= MEL_FILTERS + 1) continue;
+        int32_t segment = static_cast<int32_t>(position);
+        tables->melSegment[bin] = segment;
+        tables->melWeight[bin] = position - segment;
+        tables->firstMelBin = min(tables->firstMelBin, bin);
+        tables->lastMelBin = max(tables->lastMelBin, bin);
+    }
+
+    // Orthonormal DCT-II; ln 2 turns the log2 energies into natural logs.
+    tables->dct.resize(MFCC_COUNT * MEL_FILTERS);
+    for (size_t c = 0; c < MFCC_COUNT; ++c) {
+        double scale = sqrt((c == 0 ? 1.0 : 2.0) / MEL_FILTERS) * LN2;
+        for (size_t k = 0; k < MEL_FILTERS; ++k) {
+            tables->dct[c * MEL_FILTERS + k] = static_cast<float>(scale * cos(M_PI * c * (k + 0.5) / MEL_FILTERS));
+        }
+    }
+    return tables;
+}
+
+const SpectralFeatures& SpectralDescriptors::process(const float* magnitudes) {
+    const Tables& t = *tables;
+    size_t bins = t.bins;
+    if (!hasPrevious) {
+        // No history yet: flux against itself, i.e. zero.
+        copy(magnitudes, magnitudes + bins, previous.begin());
+        hasPrevious = true;
+    }
+
+    // Pass 1: moments, total and log power, flux.
+    float sumMagnitude = 0.0f, sumWeighted = 0.0f, sumSquaredWeighted = 0.0f;
+    float sumPower = 0.0f, sumLogPower = 0.0f, sumFlux = 0.0f;
+    float* powerOut = power.data();
+    float* previousData = previous.data();
+    size_t i = 0;
+#ifdef __SSE2__
+    __m128 vMagnitude = _mm_setzero_ps(), vWeighted = _mm_setzero_ps(), vSquaredWeighted = _mm_setzero_ps();
+    __m128 vPower = _mm_setzero_ps(), vLogPower = _mm_setzero_ps(), vFlux = _mm_setzero_ps();
+    __m128 index = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    const __m128 four = _mm_set1_ps(4.0f);
+    const __m128 floor = _mm_set1_ps(POWER_FLOOR);
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= bins; i += 4) {
+        __m128 m = _mm_loadu_ps(magnitudes + i);
+        __m128 p = _mm_mul_ps(m, m);
+        __m128 weighted = _mm_mul_ps(m, index);
+        vMagnitude = _mm_add_ps(vMagnitude, m);
+        vWeighted = _mm_add_ps(vWeighted, weighted);
+        vSquaredWeighted = _mm_add_ps(vSquaredWeighted, _mm_mul_ps(weighted, index));
+        vPower = _mm_add_ps(vPower, p);
+        vLogPower = _mm_add_ps(vLogPower, fastLog2(_mm_add_ps(p, floor)));
+
+        __m128 rise = _mm_max_ps(_mm_sub_ps(m, _mm_loadu_ps(previousData + i)), zero);
+        vFlux = _mm_add_ps(vFlux, _mm_mul_ps(rise, rise));
+        _mm_storeu_ps(previousData + i, m);
+        _mm_storeu_ps(powerOut + i, p);
+        index = _mm_add_ps(index, four);
+    }
+    sumMagnitude = horizontalSum(vMagnitude);
+    sumWeighted = horizontalSum(vWeighted);
+    sumSquaredWeighted = horizontalSum(vSquaredWeighted);
+    sumPower = horizontalSum(vPower);
+    sumLogPower = horizontalSum(vLogPower);
+    sumFlux = horizontalSum(vFlux);
+#endif
+    for (; i < bins; ++i) {
+        float m = magnitudes[i];
+        float p = m * m;
+        float bin = static_cast<float>(i);
+        sumMagnitude += m;
+        sumWeighted += m * bin;
+        sumSquaredWeighted += m * bin * bin;
+        sumPower += p;
+        sumLogPower += fastLog2(p + POWER_FLOOR);
+        float rise = max(m - previousData[i], 0.0f);
+        sumFlux += rise * rise;
+        previousData[i] = m;
+        powerOut[i] = p;
+    }
+
+    if (sumMagnitude < SILENCE) {
+        features = SpectralFeatures();
+        return features;
+    }
+
+    float meanBin = sumWeighted / sumMagnitude;
+    features.centroid = meanBin * t.binWidth;
+    features.spread = sqrt(max(0.0f, sumSquaredWeighted / sumMagnitude - meanBin * meanBin)) * t.binWidth;
+    features.flatness = min(1.0f, exp2(sumLogPower / bins) / (sumPower / bins + POWER_FLOOR));
+    features.flux = sqrt(sumFlux / sumPower);
+
+    // Pass 2: rolloff prefix and mel energies.
+    melEnergy.fill(0.0f);
+    float target = ROLLOFF_SHARE * sumPower;
+    float cumulative = 0.0f;
+    size_t rolloffBin = bins - 1;
+    bool rolloffFound = false;
+    for (size_t bin = 0; bin < bins; ++bin) {
+        float p = power[bin];
+        cumulative += p;
+        if (!rolloffFound && cumulative >= target) {
+            rolloffBin = bin;
+            rolloffFound = true;
+        }
+        if (bin >= t.firstMelBin && bin <= t.lastMelBin) {
+            int32_t segment = t.melSegment[bin];
+            float weighted = t.melWeight[bin] * p;
+            melEnergy[segment] += p - weighted;
+            melEnergy[segment + 1] += weighted;
+        }
+    }
+    features.rolloff = rolloffBin * t.binWidth;
+
+    // Log mel energies (filter k is melEnergy[k + 1]) through the DCT.
+    alignas(16) float logMel[MEL_FILTERS];
+    size_t k = 0;
+#ifdef __SSE2__
+    for (; k + 4 <= MEL_FILTERS; k += 4) {
+        __m128 energy = _mm_add_ps(_mm_loadu_ps(melEnergy.data() + 1 + k), floor);
+        _mm_store_ps(logMel + k, fastLog2(energy));
+    }
+#endif
+    for (; k < MEL_FILTERS; ++k) {
+        logMel[k] = fastLog2(melEnergy[k + 1] + POWER_FLOOR);
+    }
+
+    for (size_t c = 0; c < MFCC_COUNT; ++c) {
+        const float* row = t.dct.data() + c * MEL_FILTERS;
+        float sum = 0.0f;
+        k = 0;
+#ifdef __SSE2__
+        __m128 vSum = _mm_setzero_ps();
+        for (; k + 4 <= MEL_FILTERS; k += 4) {
+            vSum = _mm_add_ps(vSum, _mm_mul_ps(_mm_loadu_ps(row + k), _mm_load_ps(logMel + k)));
+        }
+        sum = horizontalSum(vSum);
+#endif
+        for (; k < MEL_FILTERS; ++k) {
+            sum += row[k] * logMel[k];
+        }
+        features.mfcc[c] = sum;
+    }
+    return features;
+}
+
+void SpectralDescriptors::processFrames(const float* magnitudes, size_t frameCount, SpectralFeatures* out) {
+    for (size_t frame = 0; frame < frameCount; ++frame) {
+        out[frame] = process(magnitudes + frame * tables->bins);
+    }
+}
+
+const SpectralFeatures& SpectralDescriptors::getFeatures() const {
+    return features;
+}
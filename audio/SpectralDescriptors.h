@@ -0,0 +1,74 @@
+#ifndef SPECTRAL_DESCRIPTORS_H
+#define SPECTRAL_DESCRIPTORS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+const size_t MFCC_COUNT = 13;
+const size_t MEL_FILTERS = 40;
+
+// Scalar summaries of one magnitude spectrum. Everything but mfcc[0] is
+// independent of the spectrum's overall level.
+struct SpectralFeatures {
+    float centroid;    // Hz, magnitude weighted: brightness
+    float spread;      // Hz, standard deviation around the centroid
+    float flatness;    // geometric over arithmetic mean of power: 0 tonal, 1 white noise
+    float rolloff;     // Hz below which 85% of the power lies
+    float flux;        // rise in magnitude since the previous frame, relative to this frame's level
+    array<float, MFCC_COUNT> mfcc;  // DCT-II (orthonormal) of log mel energies
+};
+
+// Computes SpectralFeatures once per frame in two passes over the bins.
+//
+// The first pass is SSE: it squares magnitudes into a power scratch and
+// accumulates the centroid and spread moments, total power, summed log
+// power (via a vectorized log2) and the positive flux against the previous
+// frame, which it overwrites in the same pass. The second walks the power
+// scratch once for the 85% rolloff prefix and the mel energies: each bin
+// lies between two adjacent filter peaks, so it adds to at most two
+// filters through a precomputed (segment, weight) pair. Mel filterbank and
+// DCT matrix are built once per (FFT size, sample rate) and shared, like
+// ChromaProcessor's pitch maps.
+class SpectralDescriptors {
+public:
+    SpectralDescriptors(size_t fftSize, int sampleRate);
+
+    void configure(size_t fftSize, int sampleRate);
+    // Forgets the previous frame, so the next flux reads 0.
+    void reset();
+
+    // magnitudes has fftSize / 2 bins.
+    const SpectralFeatures& process(const float* magnitudes);
+    const SpectralFeatures& getFeatures() const;
+
+    // Offline extraction: frameCount spectra stored back to back, flux
+    // chained from one to the next.
+    void processFrames(const float* magnitudes, size_t frameCount, SpectralFeatures* out);
+
+    struct Tables {
+        size_t bins;
+        float binWidth;                 // Hz per bin
+        size_t firstMelBin, lastMelBin; // bins inside the filterbank, inclusive
+        vector<int32_t> melSegment;     // per bin: padded index of the rising filter
+        vector<float> melWeight;        // per bin: position between the two peaks
+        vector<float> dct;              // MFCC_COUNT x MEL_FILTERS, natural log folded in
+    };
+
+private:
+    static shared_ptr<const Tables> tablesFor(size_t fftSize, int sampleRate);
+    static shared_ptr<const Tables> buildTables(size_t fftSize, int sampleRate);
+
+    shared_ptr<const Tables> tables;
+    vector<float> power;
+    vector<float> previous;
+    bool hasPrevious;
+    array<float, MEL_FILTERS + 2> melEnergy;  // padded: the outer two are discard slots
+    SpectralFeatures features;
+};
+
+#endif // SPECTRAL_DESCRIPTORS_H
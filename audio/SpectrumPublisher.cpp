@@ -0,0 +1,68 @@
+#include "SpectrumPublisher.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+using namespace std;
+
+SpectrumPublisher::SpectrumPublisher() : header(nullptr), frameIndex(0) {}
+
+SpectrumPublisher::~SpectrumPublisher() {
+    close();
+}
+
+bool SpectrumPublisher::open(const string& name, int sampleRate) {
+    close();
+    if (!region.create(name, sizeof(SharedSpectrumHeader))) {
+        return false;
+    }
+
+    // A fresh region is zero-filled; construct in place so the atomics are
+    // properly initialized.
+    header = new (region.data()) SharedSpectrumHeader();
+    header->magic = SHARED_SPECTRUM_MAGIC;
+    header->version = SHARED_SPECTRUM_VERSION;
+    header->slotCount = SHARED_SPECTRUM_SLOTS;
+    header->sampleRate = static_cast<uint32_t>(sampleRate);
+    header->latest.store(0);
+    header->writerActive.store(1, memory_order_release);
+    frameIndex = 0;
+    return true;
+}
+
+void SpectrumPublisher::close() {
+    if (header) {
+        header->writerActive.store(0, memory_order_release);
+        header = nullptr;
+    }
+    region.close();
+}
+
+void SpectrumPublisher::publish(const AnalysisFrame& frame) {
+    if (!header) return;
+
+    ++frameIndex;
+    SharedSpectrumFrame& slot = header->slots[frameIndex % SHARED_SPECTRUM_SLOTS];
+
+    // Odd sequence: readers that see it, or see it change, retry.
+    uint32_t sequence = slot.sequence.load(memory_order_relaxed);
+    slot.sequence.store(sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    size_t binCount = min(frame.magnitudes.size(), SHARED_SPECTRUM_MAX_BINS);
+    size_t bandCount = min(frame.bands.size(), SPECTRUM_BANDS);
+    slot.binCount = static_cast<uint32_t>(binCount);
+    slot.bandCount = static_cast<uint32_t>(bandCount);
+    slot.beat = frame.beat ? 1 : 0;
+    slot.frameIndex = frameIndex;
+    slot.samplePosition = frame.samplePosition;
+    slot.beatStrength = frame.beatStrength;
+    slot.tempo = frame.tempo;
+    slot.loudness = frame.loudness;
+    memcpy(slot.magnitudes, frame.magnitudes.data(), binCount * sizeof(float));
+    memcpy(slot.bands, frame.bands.data(), bandCount * sizeof(float));
+    slot.checksum = sharedSpectrumChecksum(slot.magnitudes, binCount, slot.bands, bandCount);
+
+    slot.sequence.store(sequence + 2, memory_order_release);
+    header->latest.store(frameIndex, memory_order_release);
+}
@@ -0,0 +1,31 @@
+#ifndef SPECTRUM_PUBLISHER_H
+#define SPECTRUM_PUBLISHER_H
+
+#include "AnalysisFrame.h"
+#include "SharedMemory.h"
+#include "SharedSpectrum.h"
+#include <string>
+
+using namespace std;
+
+// Writes analysis frames into the shared spectrum ring (see
+// SharedSpectrum.h) for other local processes. publish() is plain memory
+// writes: no locks and no system calls.
+class SpectrumPublisher {
+public:
+    SpectrumPublisher();
+    ~SpectrumPublisher();
+
+    bool open(const string& name, int sampleRate);
+    void close();
+
+    // Analysis thread only.
+    void publish(const AnalysisFrame& frame);
+
+private:
+    SharedMemoryRegion region;
+    SharedSpectrumHeader* header;
+    uint64_t frameIndex;
+};
+
+#endif // SPECTRUM_PUBLISHER_H
@@ -0,0 +1,93 @@
+#include "SpectrumReader.h"
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+// A writer at analysis rate overwrites a slot every SHARED_SPECTRUM_SLOTS
+// hops, so a handful of attempts is plenty.
+static const int READ_ATTEMPTS = 16;
+
+SpectrumReader::SpectrumReader() : header(nullptr), retries(0) {}
+
+bool SpectrumReader::open(const string& name) {
+    close();
+    if (!region.open(name, sizeof(SharedSpectrumHeader))) {
+        return false;
+    }
+
+    header = static_cast<const SharedSpectrumHeader*>(region.data());
+    if (header->magic != SHARED_SPECTRUM_MAGIC || header->version != SHARED_SPECTRUM_VERSION ||
+        header->slotCount != SHARED_SPECTRUM_SLOTS) {
+        cerr << "ERROR: " << name << " is not a version " << SHARED_SPECTRUM_VERSION << " spectrum ring." << endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SpectrumReader::close() {
+    header = nullptr;
+    region.close();
+}
+
+bool SpectrumReader::isWriterActive() const {
+    return header && header->writerActive.load(memory_order_acquire) != 0;
+}
+
+int SpectrumReader::getSampleRate() const {
+    return header ? static_cast<int>(header->sampleRate) : 0;
+}
+
+uint64_t SpectrumReader::getLatestFrame() const {
+    return header ? header->latest.load(memory_order_acquire) : 0;
+}
+
+const SharedSpectrumFrame* SpectrumReader::peekLatest(uint32_t& sequence) const {
+    uint64_t latest = getLatestFrame();
+    if (latest == 0) return nullptr;
+
+    const SharedSpectrumFrame* frame = &header->slots[latest % SHARED_SPECTRUM_SLOTS];
+    sequence = frame->sequence.load(memory_order_acquire);
+    return (sequence & 1) ? nullptr : frame;
+}
+
+bool SpectrumReader::validate(const SharedSpectrumFrame* frame, uint32_t sequence) const {
+    atomic_thread_fence(memory_order_acquire);
+    return frame->sequence.load(memory_order_relaxed) == sequence;
+}
+
+bool SpectrumReader::readLatest(SpectrumSnapshot& out, uint64_t after) {
+    for (int attempt = 0; attempt < READ_ATTEMPTS; ++attempt) {
+        if (getLatestFrame() <= after) return false;
+
+        uint32_t sequence;
+        const SharedSpectrumFrame* frame = peekLatest(sequence);
+        if (!frame) {
+            ++retries;
+            continue;
+        }
+
+        size_t binCount = min<size_t>(frame->binCount, SHARED_SPECTRUM_MAX_BINS);
+        size_t bandCount = min<size_t>(frame->bandCount, SPECTRUM_BANDS);
+        out.frameIndex = frame->frameIndex;
+        out.samplePosition = frame->samplePosition;
+        out.beat = frame->beat != 0;
+        out.beatStrength = frame->beatStrength;
+        out.tempo = frame->tempo;
+        out.loudness = frame->loudness;
+        out.checksum = frame->checksum;
+        out.magnitudes.assign(frame->magnitudes, frame->magnitudes + binCount);
+        out.bands.assign(frame->bands, frame->bands + bandCount);
+
+        if (validate(frame, sequence)) {
+            return true;
+        }
+        ++retries;
+    }
+    return false;
+}
+
+uint64_t SpectrumReader::getRetries() const {
+    return retries;
+}
@@ -0,0 +1,55 @@
+#ifndef SPECTRUM_READER_H
+#define SPECTRUM_READER_H
+
+#include "SharedMemory.h"
+#include "SharedSpectrum.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct SpectrumSnapshot {
+    uint64_t frameIndex;
+    uint64_t samplePosition;
+    bool beat;
+    float beatStrength;
+    float tempo;
+    LoudnessReading loudness;
+    uint32_t checksum;
+    vector<float> magnitudes;
+    vector<float> bands;
+};
+
+// Client side of the shared spectrum ring. Maps the region read-only; after
+// open() reading a frame is plain memory access.
+class SpectrumReader {
+public:
+    SpectrumReader();
+
+    bool open(const string& name = SHARED_SPECTRUM_DEFAULT_NAME);
+    void close();
+
+    bool isWriterActive() const;
+    int getSampleRate() const;
+    // frameIndex of the newest complete frame; 0 before the first.
+    uint64_t getLatestFrame() const;
+
+    // Copies the newest frame if it is newer than `after`. Returns false if
+    // there is none or the writer kept overwriting the slot.
+    bool readLatest(SpectrumSnapshot& out, uint64_t after = 0);
+
+    // Zero-copy access: use the frame in place, then call validate(); if it
+    // fails the data may have been torn and must be discarded.
+    const SharedSpectrumFrame* peekLatest(uint32_t& sequence) const;
+    bool validate(const SharedSpectrumFrame* frame, uint32_t sequence) const;
+
+    uint64_t getRetries() const;
+
+private:
+    SharedMemoryRegion region;
+    const SharedSpectrumHeader* header;
+    uint64_t retries;
+};
+
+#endif // SPECTRUM_READER_H
@@ -0,0 +1,457 @@
+#include "StreamReader.h"
+#include "ThreadRoles.h"
+#include <mpg123.h>
+#include <sndfile.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+using namespace std;
+
+// Kept from the start of the stream for sniffing and header seeks.
+static const size_t HEAD_BYTES = 64 * 1024;
+// Per read from the pipe when the decoder takes whatever has arrived.
+static const size_t INPUT_CHUNK_BYTES = 4096;
+// Per decode step for WAV and raw input; about 23 ms at 44.1 kHz.
+static const size_t STREAM_CHUNK_FRAMES = 1024;
+static const size_t MIN_RING_FRAMES = 4096;
+// The callback never signals (see AudioProcessor::analysisLoop), so a full
+// ring is polled.
+static const chrono::milliseconds FULL_RING_POLL(5);
+// How often a read waiting on a quiet pipe checks for close().
+static const int INPUT_POLL_MS = 100;
+
+bool parseRawPcmFormat(const string& text, RawPcmFormat& format) {
+    istringstream fields(text);
+    string encoding, rate, channels;
+    if (!getline(fields, encoding, ':') || !getline(fields, rate, ':') || !getline(fields, channels)) {
+        return false;
+    }
+
+    RawPcmFormat parsed;
+    if (encoding == "s16le") parsed.sampleFormat = RawSampleFormat::S16LE;
+    else if (encoding == "f32le") parsed.sampleFormat = RawSampleFormat::F32LE;
+    else return false;
+
+    char* end = nullptr;
+    parsed.sampleRate = static_cast<int>(strtol(rate.c_str(), &end, 10));
+    if (rate.empty() || *end != '\0' || parsed.sampleRate < 1000 || parsed.sampleRate > 768000) {
+        return false;
+    }
+    parsed.channels = static_cast<int>(strtol(channels.c_str(), &end, 10));
+    if (channels.empty() || *end != '\0' || (parsed.channels != 1 && parsed.channels != 2)) {
+        return false;
+    }
+    format = parsed;
+    return true;
+}
+
+bool isStreamSource(const string& path) {
+    if (path == "-") {
+        return true;
+    }
+#ifdef _WIN32
+    return path.rfind("\\\\.\\pipe\\", 0) == 0;
+#else
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISFIFO(info.st_mode);
+#endif
+}
+
+AudioStreamReader::AudioStreamReader()
+    : fd(-1), ownsFd(false), container(Container::Raw), bufferSeconds(0.0), position(0), capacity(0),
+      writeCount(0), readCount(0), ended(true), underruns(0), running(false), announced(false), sampleRate(0), channels(0) {
+    if (mpg123_init() != MPG123_OK) {
+        cerr << "Failed to initialize mpg123 library." << endl;
+    }
+}
+
+AudioStreamReader::~AudioStreamReader() {
+    close();
+    mpg123_exit();
+}
+
+bool AudioStreamReader::open(const string& source, const RawPcmFormat& rawFormat, double seconds) {
+    close();
+    if (source == "-") {
+        fd = 0;
+        ownsFd = false;
+#ifdef _WIN32
+        _setmode(fd, O_BINARY);
+#endif
+    } else {
+        fd = ::open(source.c_str(), O_RDONLY | O_BINARY);
+        ownsFd = true;
+    }
+    if (fd < 0) {
+        cerr << "ERROR: Failed to open stream " << source << ": " << strerror(errno) << endl;
+        return false;
+    }
+
+    raw = rawFormat;
+    bufferSeconds = seconds;
+    head.clear();
+    position = 0;
+    writeCount = 0;
+    readCount = 0;
+    ended = false;
+    underruns = 0;
+    announced = false;
+    sampleRate = 0;
+
+    running = true;
+    decodeThread = thread(&AudioStreamReader::decodeLoop, this);
+    {
+        unique_lock<mutex> lock(startMutex);
+        started.wait(lock, [this] { return announced; });
+    }
+    if (sampleRate == 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AudioStreamReader::close() {
+    running = false;
+    if (decodeThread.joinable()) {
+        decodeThread.join();
+    }
+    if (ownsFd && fd >= 0) {
+        ::close(fd);
+    }
+    fd = -1;
+    ownsFd = false;
+    ended = true;
+}
+
+int AudioStreamReader::getSampleRate() const {
+    return sampleRate;
+}
+
+int AudioStreamReader::getChannels() const {
+    return channels;
+}
+
+size_t AudioStreamReader::read(size_t count, float* left, float* right) {
+    uint64_t first = readCount.load(memory_order_relaxed);
+    size_t available = static_cast<size_t>(writeCount.load(memory_order_acquire) - first);
+    size_t frames = min(count, available);
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < frames; ++i) {
+        size_t slot = static_cast<size_t>(first + i) & mask;
+        left[i] = ring[slot * 2];
+        if (right) right[i] = ring[slot * 2 + 1];
+    }
+    readCount.store(first + frames, memory_order_release);
+
+    if (frames < count && !ended.load(memory_order_acquire)) {
+        underruns.fetch_add(1, memory_order_relaxed);
+    }
+    return frames;
+}
+
+bool AudioStreamReader::finished() const {
+    return ended.load(memory_order_acquire) &&
+           readCount.load(memory_order_relaxed) == writeCount.load(memory_order_acquire);
+}
+
+size_t AudioStreamReader::getUnderruns() const {
+    return underruns;
+}
+
+void AudioStreamReader::decodeLoop() {
+    applyThreadRole(ThreadRole::Decode);
+
+    bool ok = false;
+    if (raw.channels > 0) {
+        container = Container::Raw;
+        ok = decodeRaw();
+    } else {
+        unsigned char magic[12];
+        size_t got = input(magic, sizeof(magic), true);
+        seekInput(0);
+        bool id3 = got >= 3 && memcmp(magic, "ID3", 3) == 0;
+        bool frameSync = got >= 2 && magic[0] == 0xFF && (magic[1] & 0xE0) == 0xE0;
+        bool riff = got >= 12 && (memcmp(magic, "RIFF", 4) == 0 || memcmp(magic, "RF64", 4) == 0) &&
+                    memcmp(magic + 8, "WAVE", 4) == 0;
+        if (id3 || frameSync) {
+            container = Container::MP3;
+            ok = decodeMP3();
+        } else if (riff) {
+            container = Container::WAV;
+            ok = decodeWAV();
+        } else if (got == 0) {
+            cerr << "ERROR: The stream closed before sending any audio." << endl;
+        } else {
+            cerr << "ERROR: Unrecognised stream format; use raw-pcm for headerless PCM." << endl;
+        }
+    }
+
+    if (ok && sampleRate == 0) {
+        cerr << "ERROR: The stream ended before its format was known." << endl;
+    }
+    announce(0, 0);
+    ended.store(true, memory_order_release);
+}
+
+void AudioStreamReader::announce(int rate, int sourceChannels) {
+    lock_guard<mutex> lock(startMutex);
+    if (announced) {
+        return;
+    }
+    if (rate > 0) {
+        size_t frames = max(MIN_RING_FRAMES, static_cast<size_t>(bufferSeconds * rate));
+        capacity = 1;
+        while (capacity < frames) capacity <<= 1;
+        ring.assign(capacity * 2, 0.0f);
+    }
+    sampleRate = rate;
+    channels = sourceChannels;
+    announced = true;
+    started.notify_one();
+}
+
+void AudioStreamReader::deliver(const float* samples, size_t frames, int channels) {
+    size_t mask = capacity - 1;
+    size_t done = 0;
+    while (done < frames && running) {
+        uint64_t first = writeCount.load(memory_order_relaxed);
+        size_t space = capacity - static_cast<size_t>(first - readCount.load(memory_order_acquire));
+        if (space == 0) {
+            // Not reading the pipe now is what holds the writer back.
+            this_thread::sleep_for(FULL_RING_POLL);
+            continue;
+        }
+        size_t count = min(space, frames - done);
+        for (size_t i = 0; i < count; ++i) {
+            const float* frame = samples + (done + i) * channels;
+            size_t slot = static_cast<size_t>(first + i) & mask;
+            ring[slot * 2] = frame[0];
+            ring[slot * 2 + 1] = frame[channels - 1];
+        }
+        writeCount.store(first + count, memory_order_release);
+        done += count;
+    }
+}
+
+bool AudioStreamReader::decodeRaw() {
+    // Samples are taken as they sit in memory: little-endian hosts only.
+    size_t sampleBytes = raw.sampleFormat == RawSampleFormat::S16LE ? 2 : 4;
+    size_t frameBytes = sampleBytes * raw.channels;
+    announce(raw.sampleRate, raw.channels);
+
+    vector<unsigned char> bytes(STREAM_CHUNK_FRAMES * frameBytes);
+    vector<float> samples(STREAM_CHUNK_FRAMES * raw.channels);
+    size_t filled = 0;
+    while (running) {
+        size_t got = input(bytes.data() + filled, bytes.size() - filled, false);
+        if (got == 0) break;
+        filled += got;
+
+        size_t frames = filled / frameBytes;
+        size_t count = frames * raw.channels;
+        for (size_t i = 0; i < count; ++i) {
+            if (sampleBytes == 2) {
+                int16_t value;
+                memcpy(&value, &bytes[i * 2], 2);
+                samples[i] = value / 32768.0f;
+            } else {
+                memcpy(&samples[i], &bytes[i * 4], 4);
+            }
+        }
+        deliver(samples.data(), frames, raw.channels);
+
+        // A frame split across reads waits for the rest.
+        size_t used = frames * frameBytes;
+        memmove(bytes.data(), bytes.data() + used, filled - used);
+        filled -= used;
+    }
+    return true;
+}
+
+bool AudioStreamReader::decodeMP3() {
+    mpg123_handle* mh = mpg123_new(nullptr, nullptr);
+    if (!mh || mpg123_open_feed(mh) != MPG123_OK) {
+        cerr << "ERROR: Failed to start the MP3 stream decoder." << endl;
+        if (mh) mpg123_delete(mh);
+        return false;
+    }
+
+    size_t outputBytes = mpg123_outblock(mh);
+    // 16-bit output, as for files.
+    vector<int16_t> output(outputBytes / sizeof(int16_t));
+    vector<float> samples(output.size());
+    vector<unsigned char> chunk(INPUT_CHUNK_BYTES);
+    int channels = 0;
+    bool ok = true;
+
+    while (running) {
+        size_t done = 0;
+        int result = mpg123_read(mh, reinterpret_cast<unsigned char*>(output.data()), outputBytes, &done);
+        if (result == MPG123_NEW_FORMAT) {
+            long rate;
+            int encoding;
+            mpg123_getformat(mh, &rate, &channels, &encoding);
+            if (channels != 1 && channels != 2) {
+                cerr << "ERROR: Unsupported channel count in stream: " << channels << endl;
+                ok = false;
+                break;
+            }
+            if (sampleRate != 0 && rate != sampleRate) {
+                // The device is already open at the first rate.
+                cerr << "ERROR: Stream changed sample rate from " << sampleRate << " to " << rate << " Hz." << endl;
+                break;
+            }
+            announce(static_cast<int>(rate), channels);
+            continue;
+        }
+
+        size_t count = done / sizeof(int16_t);
+        if (count > 0 && channels > 0) {
+            for (size_t i = 0; i < count; ++i) {
+                samples[i] = output[i] / 32768.0f;
+            }
+            deliver(samples.data(), count / channels, channels);
+        }
+
+        if (result == MPG123_NEED_MORE) {
+            size_t got = input(chunk.data(), chunk.size(), false);
+            if (got == 0) break;
+            mpg123_feed(mh, chunk.data(), got);
+        } else if (result != MPG123_OK && result != MPG123_DONE) {
+            cerr << "ERROR: MP3 stream decoding failed: " << mpg123_strerror(mh) << endl;
+            ok = sampleRate != 0;
+            break;
+        }
+    }
+
+    mpg123_delete(mh);
+    return ok;
+}
+
+bool AudioStreamReader::decodeWAV() {
+    SF_VIRTUAL_IO io = {vioLength, vioSeek, vioRead, vioWrite, vioTell};
+    SF_INFO info;
+    memset(&info, 0, sizeof(info));
+    SNDFILE* file = sf_open_virtual(&io, SFM_READ, &info, this);
+    if (!file) {
+        cerr << "ERROR: Failed to read the WAV stream header: " << sf_strerror(nullptr) << endl;
+        return false;
+    }
+    if (info.channels != 1 && info.channels != 2) {
+        cerr << "ERROR: Unsupported channel count in stream: " << info.channels << endl;
+        sf_close(file);
+        return false;
+    }
+    announce(info.samplerate, info.channels);
+
+    vector<float> samples(STREAM_CHUNK_FRAMES * info.channels);
+    while (running) {
+        sf_count_t got = sf_readf_float(file, samples.data(), STREAM_CHUNK_FRAMES);
+        if (got <= 0) break;
+        deliver(samples.data(), static_cast<size_t>(got), info.channels);
+    }
+    sf_close(file);
+    return true;
+}
+
+size_t AudioStreamReader::input(unsigned char* data, size_t size, bool complete) {
+    size_t copied = 0;
+    if (position < head.size()) {
+        copied = min(size, static_cast<size_t>(head.size() - position));
+        memcpy(data, &head[position], copied);
+        position += copied;
+    }
+
+    while (copied < size && (complete || copied == 0) && running) {
+#ifndef _WIN32
+        // Wait in slices so close() is not held up by a quiet writer.
+        pollfd waiting = {fd, POLLIN, 0};
+        int ready = poll(&waiting, 1, INPUT_POLL_MS);
+        if (ready == 0 || (ready < 0 && errno == EINTR)) continue;
+#endif
+        long got = ::read(fd, data + copied, static_cast<unsigned>(size - copied));
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+
+        if (position == head.size() && head.size() < HEAD_BYTES) {
+            size_t keep = min(static_cast<size_t>(got), HEAD_BYTES - head.size());
+            head.insert(head.end(), data + copied, data + copied + keep);
+        }
+        position += got;
+        copied += got;
+    }
+    return copied;
+}
+
+bool AudioStreamReader::seekInput(uint64_t target) {
+    if (target < position) {
+        // Back over the kept head, while nothing past it has been read.
+        if (target > head.size() || position > head.size()) {
+            return false;
+        }
+        position = target;
+        return true;
+    }
+
+    unsigned char skipped[INPUT_CHUNK_BYTES];
+    while (position < target) {
+        size_t step = static_cast<size_t>(min<uint64_t>(sizeof(skipped), target - position));
+        if (input(skipped, step, true) < step) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int64_t AudioStreamReader::vioLength(void* user) {
+    // A pipe has no length; a huge one makes libsndfile trust the data
+    // chunk's size, or read to the end when the writer left it open.
+    return numeric_limits<int64_t>::max() / 2;
+}
+
+int64_t AudioStreamReader::vioSeek(int64_t offset, int whence, void* user) {
+    AudioStreamReader* reader = static_cast<AudioStreamReader*>(user);
+    int64_t target;
+    if (whence == SEEK_SET) target = offset;
+    else if (whence == SEEK_CUR) target = static_cast<int64_t>(reader->position) + offset;
+    else return -1;
+
+    if (target < 0 || !reader->seekInput(static_cast<uint64_t>(target))) {
+        return -1;
+    }
+    return static_cast<int64_t>(reader->position);
+}
+
+int64_t AudioStreamReader::vioRead(void* data, int64_t count, void* user) {
+    AudioStreamReader* reader = static_cast<AudioStreamReader*>(user);
+    return static_cast<int64_t>(reader->input(static_cast<unsigned char*>(data), static_cast<size_t>(count), true));
+}
+
+int64_t AudioStreamReader::vioWrite(const void* data, int64_t count, void* user) {
+    return 0;
+}
+
+int64_t AudioStreamReader::vioTell(void* user) {
+    return static_cast<int64_t>(static_cast<AudioStreamReader*>(user)->position);
+}
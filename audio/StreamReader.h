@@ -0,0 +1,114 @@
+#ifndef STREAM_READER_H
+#define STREAM_READER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+enum class RawSampleFormat {
+    S16LE,
+    F32LE
+};
+
+// Layout of headerless PCM. channels == 0 means the stream has a header
+// to sniff instead.
+struct RawPcmFormat {
+    RawSampleFormat sampleFormat = RawSampleFormat::S16LE;
+    int sampleRate = 0;
+    int channels = 0;
+};
+
+// "<s16le|f32le>:<rate>:<channels>", e.g. "s16le:44100:2".
+bool parseRawPcmFormat(const string& text, RawPcmFormat& format);
+
+// "-" for stdin, or a named pipe.
+bool isStreamSource(const string& path);
+
+// Audio piped in from another process. Unlike AudioFileReader nothing is
+// held whole: a decode thread reads the pipe as data arrives, decodes it
+// (MP3 through mpg123's feed API, WAV through libsndfile virtual I/O, or
+// raw PCM) and writes stereo frames into a fixed ring that the audio
+// callback drains. When the ring is full the thread stops reading, so the
+// writer blocks on the pipe; memory stays fixed and the delay from pipe to
+// speaker is at most the ring plus one block.
+//
+// The format comes from the first bytes, not the name: ID3 or an MPEG
+// frame sync is MP3, RIFF/RF64 ... WAVE is WAV.
+class AudioStreamReader {
+public:
+    AudioStreamReader();
+    ~AudioStreamReader();
+
+    // Waits until the format is known, so getSampleRate() is valid on
+    // return. bufferSeconds sizes the ring.
+    bool open(const string& source, const RawPcmFormat& raw, double bufferSeconds);
+    void close();
+
+    int getSampleRate() const;
+    // Of the source, also valid once open() returns. Mono is read as
+    // identical left and right.
+    int getChannels() const;
+
+    // Audio callback. Copies up to count frames and returns how many;
+    // never blocks. right may be null.
+    size_t read(size_t count, float* left, float* right);
+    // The source has ended and everything decoded has been read.
+    bool finished() const;
+    // Reads that came up short while the source was still open.
+    size_t getUnderruns() const;
+
+private:
+    enum class Container { Raw, MP3, WAV };
+
+    void decodeLoop();
+    bool decodeRaw();
+    bool decodeMP3();
+    bool decodeWAV();
+    // Startup handshake with open(): rate 0 reports failure.
+    void announce(int rate, int channels);
+    void deliver(const float* samples, size_t frames, int channels);
+
+    // Pipe input. Bytes up to HEAD_BYTES are kept so the sniffing and
+    // libsndfile's header parsing can seek back over them.
+    size_t input(unsigned char* data, size_t size, bool complete);
+    bool seekInput(uint64_t target);
+
+    // libsndfile virtual I/O over input(); sf_count_t is int64_t.
+    static int64_t vioLength(void* user);
+    static int64_t vioSeek(int64_t offset, int whence, void* user);
+    static int64_t vioRead(void* data, int64_t count, void* user);
+    static int64_t vioWrite(const void* data, int64_t count, void* user);
+    static int64_t vioTell(void* user);
+
+    int fd;
+    bool ownsFd;
+    Container container;
+    RawPcmFormat raw;
+    double bufferSeconds;
+    vector<unsigned char> head;
+    uint64_t position;
+
+    vector<float> ring;  // interleaved L, R
+    size_t capacity;
+    atomic<uint64_t> writeCount;
+    atomic<uint64_t> readCount;
+    atomic<bool> ended;
+    atomic<size_t> underruns;
+
+    thread decodeThread;
+    atomic<bool> running;
+    mutex startMutex;
+    condition_variable started;
+    bool announced;
+    int sampleRate;
+    int channels;
+};
+
+#endif // STREAM_READER_H
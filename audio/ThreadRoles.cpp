@@ -0,0 +1,248 @@
+#include "ThreadRoles.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+// Used when a real-time policy is given without a priority. Below the
+// kernel's own threaded IRQ handlers (50) only matters for hard real-time;
+// for audio, being above every SCHED_OTHER thread is what counts.
+static const int DEFAULT_REALTIME_PRIORITY = 70;
+
+static ThreadPolicy rolePolicies[THREAD_ROLE_COUNT];
+
+ThreadPolicy::ThreadPolicy() : scheduling(SchedulingPolicy::Normal), priority(0) {}
+
+ThreadPolicyResult::ThreadPolicyResult() : schedulingError(0), affinityError(0), clampedPriority(0) {}
+
+static bool parseNumber(const string& text, int& out) {
+    char* end = nullptr;
+    long value = strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || value < 0 || value > 1023) {
+        return false;
+    }
+    out = static_cast<int>(value);
+    return true;
+}
+
+static bool parseCpuList(const string& text, vector<int>& cpus) {
+    cpus.clear();
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        string item = text.substr(start, comma == string::npos ? string::npos : comma - start);
+        size_t dash = item.find('-');
+        int first = 0, last = 0;
+        if (dash == string::npos) {
+            if (!parseNumber(item, first)) return false;
+            last = first;
+        } else if (!parseNumber(item.substr(0, dash), first) || !parseNumber(item.substr(dash + 1), last) ||
+                   last < first) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+        if (comma == string::npos) break;
+        start = comma + 1;
+    }
+    sort(cpus.begin(), cpus.end());
+    cpus.erase(unique(cpus.begin(), cpus.end()), cpus.end());
+    return !cpus.empty();
+}
+
+bool parseThreadPolicy(const string& text, ThreadPolicy& policy) {
+    ThreadPolicy parsed;
+    string scheduling = text;
+
+    size_t at = scheduling.find('@');
+    if (at != string::npos) {
+        if (!parseCpuList(scheduling.substr(at + 1), parsed.cpus)) return false;
+        scheduling = scheduling.substr(0, at);
+    }
+
+    size_t colon = scheduling.find(':');
+    string name = scheduling.substr(0, colon);
+    if (name == "normal") parsed.scheduling = SchedulingPolicy::Normal;
+    else if (name == "fifo") parsed.scheduling = SchedulingPolicy::Fifo;
+    else if (name == "rr") parsed.scheduling = SchedulingPolicy::RoundRobin;
+    else return false;
+
+    if (colon != string::npos) {
+        if (parsed.scheduling == SchedulingPolicy::Normal) return false;
+        if (!parseNumber(scheduling.substr(colon + 1), parsed.priority) || parsed.priority < 1 ||
+            parsed.priority > 99) {
+            return false;
+        }
+    } else if (parsed.scheduling != SchedulingPolicy::Normal) {
+        parsed.priority = DEFAULT_REALTIME_PRIORITY;
+    }
+
+    policy = parsed;
+    return true;
+}
+
+const char* threadRoleName(ThreadRole role) {
+    switch (role) {
+        case ThreadRole::Audio: return "audio";
+        case ThreadRole::Analysis: return "analysis";
+        case ThreadRole::Render: return "render";
+        case ThreadRole::Decode: return "decode";
+    }
+    return "?";
+}
+
+void setThreadRolePolicy(ThreadRole role, const ThreadPolicy& policy) {
+    rolePolicies[static_cast<size_t>(role)] = policy;
+}
+
+const ThreadPolicy& getThreadRolePolicy(ThreadRole role) {
+    return rolePolicies[static_cast<size_t>(role)];
+}
+
+bool applyThreadRole(ThreadRole role) {
+    return applyThreadPolicy(getThreadRolePolicy(role), threadRoleName(role));
+}
+
+#ifdef _WIN32
+
+// Windows has no user-selectable real-time policies; both map onto thread
+// priorities within the process's priority class.
+static int applyScheduling(const ThreadPolicy& policy, int&) {
+    int priority = policy.scheduling == SchedulingPolicy::Fifo ? THREAD_PRIORITY_TIME_CRITICAL
+                                                               : THREAD_PRIORITY_HIGHEST;
+    return SetThreadPriority(GetCurrentThread(), priority) ? 0 : static_cast<int>(GetLastError());
+}
+
+static int applyAffinity(const ThreadPolicy& policy) {
+    DWORD_PTR mask = 0;
+    for (int cpu : policy.cpus) {
+        if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) mask |= static_cast<DWORD_PTR>(1) << cpu;
+    }
+    if (!mask) return ERROR_INVALID_PARAMETER;
+    return SetThreadAffinityMask(GetCurrentThread(), mask) ? 0 : static_cast<int>(GetLastError());
+}
+
+static string errorText(int error) {
+    return "error " + to_string(error);
+}
+
+bool lockProcessMemory() {
+    cerr << "WARNING: Memory locking is not supported on Windows." << endl;
+    return false;
+}
+
+#else
+
+static int applyScheduling(const ThreadPolicy& policy, int& clampedPriority) {
+    int native = policy.scheduling == SchedulingPolicy::Fifo ? SCHED_FIFO : SCHED_RR;
+    sched_param param = {};
+    param.sched_priority = clamp(policy.priority, sched_get_priority_min(native), sched_get_priority_max(native));
+    int error = pthread_setschedparam(pthread_self(), native, &param);
+
+#ifdef RLIMIT_RTPRIO
+    // Without CAP_SYS_NICE a thread may still take real-time priorities up
+    // to RLIMIT_RTPRIO (set per user in limits.conf); an unprivileged
+    // process can raise its soft limit as far as the hard one.
+    rlimit limit;
+    if (error == EPERM && getrlimit(RLIMIT_RTPRIO, &limit) == 0) {
+        if (limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_RTPRIO, &limit);
+        }
+        if (limit.rlim_cur > 0) {
+            int allowed = static_cast<int>(min<rlim_t>(limit.rlim_cur, static_cast<rlim_t>(param.sched_priority)));
+            if (allowed < param.sched_priority) {
+                clampedPriority = allowed;
+            }
+            param.sched_priority = allowed;
+            error = pthread_setschedparam(pthread_self(), native, &param);
+        }
+    }
+#endif
+    return error;
+}
+
+static int applyAffinity(const ThreadPolicy& policy) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : policy.cpus) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    return ENOTSUP;
+#endif
+}
+
+static string errorText(int error) {
+    return strerror(error);
+}
+
+bool lockProcessMemory() {
+    rlimit limit;
+    int flags = MCL_CURRENT | MCL_FUTURE;
+    if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        if (limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_MEMLOCK, &limit);
+        }
+        if (limit.rlim_cur != RLIM_INFINITY) {
+            flags = MCL_CURRENT;
+        }
+    }
+
+    if (mlockall(flags) != 0) {
+        cerr << "WARNING: Cannot lock process memory: " << strerror(errno) << endl;
+        return false;
+    }
+    if (!(flags & MCL_FUTURE)) {
+        cerr << "WARNING: RLIMIT_MEMLOCK is finite; memory allocated from now on is not locked." << endl;
+    }
+    return true;
+}
+
+#endif
+
+ThreadPolicyResult applyThreadPolicyQuietly(const ThreadPolicy& policy) {
+    ThreadPolicyResult result;
+    if (policy.scheduling != SchedulingPolicy::Normal) {
+        result.schedulingError = applyScheduling(policy, result.clampedPriority);
+    }
+    if (!policy.cpus.empty()) {
+        result.affinityError = applyAffinity(policy);
+    }
+    return result;
+}
+
+bool reportThreadPolicy(const ThreadPolicyResult& result, const char* label) {
+    if (result.clampedPriority > 0) {
+        cerr << "WARNING: " << label << " thread priority clamped to " << result.clampedPriority
+             << " by RLIMIT_RTPRIO." << endl;
+    }
+    if (result.schedulingError) {
+        cerr << "WARNING: " << label << " thread stays on normal scheduling: " << errorText(result.schedulingError)
+             << endl;
+    }
+    if (result.affinityError) {
+        cerr << "WARNING: " << label << " thread affinity not applied: " << errorText(result.affinityError) << endl;
+    }
+    return !result.schedulingError && !result.affinityError;
+}
+
+bool applyThreadPolicy(const ThreadPolicy& policy, const char* label) {
+    return reportThreadPolicy(applyThreadPolicyQuietly(policy), label);
+}
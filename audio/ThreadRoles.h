@@ -0,0 +1,75 @@
+#ifndef THREAD_ROLES_H
+#define THREAD_ROLES_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// The threads that matter for glitch-free playback. Each role has one
+// process-wide ThreadPolicy that its threads apply to themselves when they
+// start.
+enum class ThreadRole {
+    Audio,     // PortAudio callback, applied on its first block
+    Analysis,  // AudioProcessor's analysis thread
+    Render,    // the main thread once playback has started
+    Decode     // playlist prefetch and ParallelMP3Decoder workers
+};
+
+const size_t THREAD_ROLE_COUNT = 4;
+
+enum class SchedulingPolicy {
+    Normal,     // left to the OS scheduler
+    Fifo,       // SCHED_FIFO
+    RoundRobin  // SCHED_RR
+};
+
+struct ThreadPolicy {
+    ThreadPolicy();
+
+    SchedulingPolicy scheduling;
+    int priority;      // real-time priority; ignored for Normal
+    vector<int> cpus;  // affinity; empty lets the thread run anywhere
+};
+
+// What applying a policy did. Errors are errno values (GetLastError() on
+// Windows), 0 when that part was applied or not asked for.
+struct ThreadPolicyResult {
+    ThreadPolicyResult();
+
+    int schedulingError;
+    int affinityError;
+    int clampedPriority;  // priority RLIMIT_RTPRIO allowed, if lower than asked; else 0
+};
+
+// "<normal|fifo|rr>[:priority][@cpus]", cpus as a list of numbers and
+// ranges: "fifo:80@3", "rr@2,3", "normal@0-1".
+bool parseThreadPolicy(const string& text, ThreadPolicy& policy);
+const char* threadRoleName(ThreadRole role);
+
+// Set every role before any of its threads start; the table is not
+// synchronized.
+void setThreadRolePolicy(ThreadRole role, const ThreadPolicy& policy);
+const ThreadPolicy& getThreadRolePolicy(ThreadRole role);
+
+// Applies a policy to the calling thread. When SCHED_FIFO/SCHED_RR is
+// refused, the soft RLIMIT_RTPRIO is raised to the hard limit and the
+// priority clamped to it before giving up. Whatever can't be applied is
+// logged and the thread carries on with what it has; returns false if
+// anything was refused. A default policy is a no-op.
+bool applyThreadPolicy(const ThreadPolicy& policy, const char* label);
+bool applyThreadRole(ThreadRole role);
+
+// The same in two halves, for threads that must not log: the first
+// applies the policy silently, the second logs the result from any thread.
+ThreadPolicyResult applyThreadPolicyQuietly(const ThreadPolicy& policy);
+bool reportThreadPolicy(const ThreadPolicyResult& result, const char* label);
+
+// mlockall() for the whole process so the real-time path never faults on
+// a paged-out sample buffer. Under a finite RLIMIT_MEMLOCK only the pages
+// mapped now are locked: MCL_FUTURE would make later allocations fail
+// once the limit is reached.
+bool lockProcessMemory();
+
+#endif // THREAD_ROLES_H
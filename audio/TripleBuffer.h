@@ -0,0 +1,54 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+using namespace std;
+
+// Lock-free single-writer/single-reader handoff of the latest value.
+//
+// The writer fills writeBuffer() and publishes it; the reader always gets
+// the most recently published buffer. Neither side ever waits or copies:
+// publishing and reading just swap indices with the shared middle slot.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : back(0), middle(1), front(2) {}
+
+    // Only safe before the reader and writer threads start.
+    void reset(const T& value) {
+        for (T& buffer : buffers) {
+            buffer = value;
+        }
+        back = 0;
+        middle = 1;
+        front = 2;
+    }
+
+    T& writeBuffer() {
+        return buffers[back];
+    }
+
+    void publish() {
+        back = middle.exchange(back | FRESH, memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Stays valid until the next call to read().
+    const T* read() {
+        if (middle.load(memory_order_acquire) & FRESH) {
+            front = middle.exchange(front, memory_order_acq_rel) & INDEX_MASK;
+        }
+        return &buffers[front];
+    }
+
+private:
+    static const unsigned INDEX_MASK = 0x3;
+    static const unsigned FRESH = 0x4;
+
+    T buffers[3];
+    unsigned back;           // writer only
+    atomic<unsigned> middle; // shared, FRESH set when it holds an unread frame
+    unsigned front;          // reader only
+};
+
+#endif // TRIPLE_BUFFER_H
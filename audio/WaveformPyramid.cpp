@@ -0,0 +1,289 @@
+#include "WaveformPyramid.h"
+#include "ThreadRoles.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <sys/stat.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+using namespace std;
+
+static const char PYRAMID_MAGIC[4] = {'M', 'P', 'V', 'W'};
+static const uint32_t PYRAMID_VERSION = 1;
+
+static const float LOW_CROSSOVER = 250.0f;
+static const float HIGH_CROSSOVER = 4000.0f;
+// Frames run through the band filters before a range's first entry. Both
+// time constants are under 1 ms, so this settles them far below float
+// resolution.
+static const size_t WARMUP_FRAMES = 4096;
+// Level-0 entries per read while building; 16384 frames.
+static const size_t BLOCK_ENTRIES = 64;
+// Below this many entries per thread a range costs more to start than it saves.
+static const size_t MIN_THREAD_ENTRIES = 4096;
+
+static WaveformEntry mergeEntries(const WaveformEntry* entries, size_t count) {
+    WaveformEntry merged = entries[0];
+    for (size_t i = 1; i < count; ++i) {
+        merged.minimum = min(merged.minimum, entries[i].minimum);
+        merged.maximum = max(merged.maximum, entries[i].maximum);
+        merged.power += entries[i].power;
+        merged.low += entries[i].low;
+        merged.mid += entries[i].mid;
+        merged.high += entries[i].high;
+    }
+    float scale = 1.0f / count;
+    merged.power *= scale;
+    merged.low *= scale;
+    merged.mid *= scale;
+    merged.high *= scale;
+    return merged;
+}
+
+static bool sourceStamp(const string& sourcePath, uint64_t& size, int64_t& modified) {
+    struct stat info;
+    if (stat(sourcePath.c_str(), &info) != 0) {
+        return false;
+    }
+    size = static_cast<uint64_t>(info.st_size);
+    modified = static_cast<int64_t>(info.st_mtime);
+    return true;
+}
+
+WaveformPyramid::WaveformPyramid() : frameCount(0), sampleRate(0) {}
+
+void WaveformPyramid::clear() {
+    levels.clear();
+    frameCount = 0;
+}
+
+WaveformPyramid::BandFilter WaveformPyramid::makeFilter() const {
+    BandFilter filter;
+    filter.lowState = 0.0f;
+    filter.highState = 0.0f;
+    filter.lowCoefficient = 1.0f - exp(-2.0f * static_cast<float>(M_PI) * LOW_CROSSOVER / sampleRate);
+    filter.highCoefficient = 1.0f - exp(-2.0f * static_cast<float>(M_PI) * HIGH_CROSSOVER / sampleRate);
+    return filter;
+}
+
+// mid holds frames samples; every PYRAMID_BASE_FRAMES (or the remainder at
+// the end) become one entry. out may be null to only advance the filters.
+void WaveformPyramid::summarize(const float* mid, size_t frames, BandFilter& filter, WaveformEntry* out) {
+    float lowState = filter.lowState, highState = filter.highState;
+    for (size_t start = 0; start < frames; start += PYRAMID_BASE_FRAMES) {
+        size_t count = min(PYRAMID_BASE_FRAMES, frames - start);
+        float minimum = mid[start], maximum = mid[start];
+        float power = 0.0f, low = 0.0f, middle = 0.0f, high = 0.0f;
+        for (size_t i = start; i < start + count; ++i) {
+            float x = mid[i];
+            lowState += filter.lowCoefficient * (x - lowState);
+            highState += filter.highCoefficient * (x - highState);
+            float upper = x - highState;
+            float band = highState - lowState;
+            minimum = min(minimum, x);
+            maximum = max(maximum, x);
+            power += x * x;
+            low += lowState * lowState;
+            middle += band * band;
+            high += upper * upper;
+        }
+        if (out) {
+            float scale = 1.0f / count;
+            out[start / PYRAMID_BASE_FRAMES] = {minimum, maximum, power * scale, low * scale, middle * scale,
+                                                high * scale};
+        }
+    }
+    filter.lowState = lowState;
+    filter.highState = highState;
+}
+
+static void mixToMid(float* left, const float* right, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        left[i] = 0.5f * (left[i] + right[i]);
+    }
+}
+
+void WaveformPyramid::buildRange(const PcmStore& pcm, size_t firstEntry, size_t lastEntry) {
+    vector<float> left(BLOCK_ENTRIES * PYRAMID_BASE_FRAMES), right(left.size());
+    BandFilter filter = makeFilter();
+
+    size_t start = firstEntry * PYRAMID_BASE_FRAMES;
+    size_t warmup = min(start, WARMUP_FRAMES);
+    size_t read = pcm.read(start - warmup, warmup, left.data(), right.data());
+    mixToMid(left.data(), right.data(), read);
+    summarize(left.data(), read, filter, nullptr);
+
+    for (size_t entry = firstEntry; entry < lastEntry; entry += BLOCK_ENTRIES) {
+        size_t entries = min(BLOCK_ENTRIES, lastEntry - entry);
+        read = pcm.read(entry * PYRAMID_BASE_FRAMES, entries * PYRAMID_BASE_FRAMES, left.data(), right.data());
+        mixToMid(left.data(), right.data(), read);
+        summarize(left.data(), read, filter, levels[0].data() + entry);
+    }
+}
+
+void WaveformPyramid::buildLevels() {
+    levels.resize(1);
+    while (levels.back().size() > 1) {
+        const vector<WaveformEntry>& below = levels.back();
+        vector<WaveformEntry> above((below.size() + PYRAMID_FACTOR - 1) / PYRAMID_FACTOR);
+        for (size_t i = 0; i < above.size(); ++i) {
+            size_t first = i * PYRAMID_FACTOR;
+            above[i] = mergeEntries(&below[first], min(PYRAMID_FACTOR, below.size() - first));
+        }
+        levels.push_back(move(above));
+    }
+}
+
+bool WaveformPyramid::build(const PcmStore& pcm, int rate, size_t threads) {
+    clear();
+    sampleRate = rate;
+    frameCount = pcm.size();
+    if (frameCount == 0 || sampleRate <= 0) {
+        return false;
+    }
+
+    size_t entries = (frameCount + PYRAMID_BASE_FRAMES - 1) / PYRAMID_BASE_FRAMES;
+    levels.emplace_back(entries);
+    size_t rangeCount = max<size_t>(1, min(threads, entries / MIN_THREAD_ENTRIES));
+
+    vector<thread> workers;
+    for (size_t i = 1; i < rangeCount; ++i) {
+        workers.emplace_back([&, i] {
+            applyThreadRole(ThreadRole::Decode);
+            buildRange(pcm, entries * i / rangeCount, entries * (i + 1) / rangeCount);
+        });
+    }
+    buildRange(pcm, 0, entries / rangeCount);
+    for (thread& worker : workers) {
+        worker.join();
+    }
+
+    buildLevels();
+    return true;
+}
+
+void WaveformPyramid::query(double startFrame, double endFrame, size_t columns, vector<WaveformEntry>& out) const {
+    out.assign(columns, WaveformEntry{0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f});
+    if (levels.empty() || levels[0].empty() || columns == 0 || endFrame <= startFrame) {
+        return;
+    }
+
+    double framesPerColumn = (endFrame - startFrame) / columns;
+    size_t level = 0;
+    double entryFrames = static_cast<double>(PYRAMID_BASE_FRAMES);
+    while (level + 1 < levels.size() && entryFrames * PYRAMID_FACTOR <= framesPerColumn) {
+        ++level;
+        entryFrames *= PYRAMID_FACTOR;
+    }
+
+    const vector<WaveformEntry>& entries = levels[level];
+    for (size_t column = 0; column < columns; ++column) {
+        double from = max(0.0, startFrame + column * framesPerColumn);
+        double to = startFrame + (column + 1) * framesPerColumn;
+        if (to <= 0.0 || from >= static_cast<double>(frameCount)) {
+            continue;
+        }
+        size_t first = static_cast<size_t>(from / entryFrames);
+        size_t last = min(entries.size(), static_cast<size_t>(ceil(to / entryFrames)));
+        if (first >= entries.size()) {
+            continue;
+        }
+        out[column] = mergeEntries(&entries[first], max<size_t>(1, last - first));
+    }
+}
+
+bool WaveformPyramid::save(const string& path, const string& sourcePath) const {
+    uint64_t sourceSize = 0;
+    int64_t sourceModified = 0;
+    if (levels.empty() || !sourceStamp(sourcePath, sourceSize, sourceModified)) {
+        return false;
+    }
+
+    ofstream file(path, ios::binary);
+    if (!file) {
+        cerr << "WARNING: Cannot write overview cache " << path << endl;
+        return false;
+    }
+    uint64_t frames = frameCount;
+    int32_t rate = sampleRate;
+    uint32_t baseFrames = PYRAMID_BASE_FRAMES;
+    uint64_t count = levels[0].size();
+    file.write(PYRAMID_MAGIC, sizeof(PYRAMID_MAGIC));
+    file.write(reinterpret_cast<const char*>(&PYRAMID_VERSION), sizeof(PYRAMID_VERSION));
+    file.write(reinterpret_cast<const char*>(&sourceSize), sizeof(sourceSize));
+    file.write(reinterpret_cast<const char*>(&sourceModified), sizeof(sourceModified));
+    file.write(reinterpret_cast<const char*>(&frames), sizeof(frames));
+    file.write(reinterpret_cast<const char*>(&rate), sizeof(rate));
+    file.write(reinterpret_cast<const char*>(&baseFrames), sizeof(baseFrames));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    // Only level 0 is stored; the levels above rebuild from it in well
+    // under a millisecond per minute of audio.
+    file.write(reinterpret_cast<const char*>(levels[0].data()), count * sizeof(WaveformEntry));
+
+    if (!file) {
+        cerr << "WARNING: Failed writing overview cache " << path << endl;
+        return false;
+    }
+    return true;
+}
+
+bool WaveformPyramid::load(const string& path, const string& sourcePath) {
+    ifstream file(path, ios::binary);
+    uint64_t sourceSize = 0;
+    int64_t sourceModified = 0;
+    if (!file || !sourceStamp(sourcePath, sourceSize, sourceModified)) {
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0, baseFrames = 0;
+    uint64_t storedSize = 0, frames = 0, count = 0;
+    int64_t storedModified = 0;
+    int32_t rate = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&storedSize), sizeof(storedSize));
+    file.read(reinterpret_cast<char*>(&storedModified), sizeof(storedModified));
+    file.read(reinterpret_cast<char*>(&frames), sizeof(frames));
+    file.read(reinterpret_cast<char*>(&rate), sizeof(rate));
+    file.read(reinterpret_cast<char*>(&baseFrames), sizeof(baseFrames));
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!file || memcmp(magic, PYRAMID_MAGIC, sizeof(magic)) != 0 || version != PYRAMID_VERSION ||
+        baseFrames != PYRAMID_BASE_FRAMES || storedSize != sourceSize || storedModified != sourceModified ||
+        count != (frames + PYRAMID_BASE_FRAMES - 1) / PYRAMID_BASE_FRAMES) {
+        return false;
+    }
+
+    clear();
+    levels.emplace_back(count);
+    if (!file.read(reinterpret_cast<char*>(levels[0].data()), count * sizeof(WaveformEntry))) {
+        clear();
+        return false;
+    }
+    frameCount = frames;
+    sampleRate = rate;
+    buildLevels();
+    return true;
+}
+
+bool WaveformPyramid::empty() const {
+    return levels.empty() || levels[0].empty();
+}
+
+size_t WaveformPyramid::getFrameCount() const {
+    return frameCount;
+}
+
+int WaveformPyramid::getSampleRate() const {
+    return sampleRate;
+}
+
+size_t WaveformPyramid::getLevelCount() const {
+    return levels.size();
+}
@@ -0,0 +1,76 @@
+#ifndef WAVEFORM_PYRAMID_H
+#define WAVEFORM_PYRAMID_H
+
+#include "PcmStore.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Frames summarized by one level-0 entry, and entries merged per level up.
+const size_t PYRAMID_BASE_FRAMES = 256;
+const size_t PYRAMID_FACTOR = 4;
+
+enum class OverviewMode {
+    Off,
+    Build,   // built after every load
+    Cached   // read from a sidecar next to the audio file, written on a miss
+};
+
+// One stretch of the track, of the mid signal (L + R) / 2. Powers are mean
+// squares so entries merge by averaging.
+struct WaveformEntry {
+    float minimum, maximum;
+    float power;
+    float low, mid, high;  // power below 250 Hz, 250 Hz to 4 kHz, above 4 kHz
+};
+
+// Min/max/power summary of a whole track as a mipmap: level 0 has one
+// entry per PYRAMID_BASE_FRAMES, each level above merges PYRAMID_FACTOR of
+// the one below. A query picks the coarsest level still finer than a
+// column, so drawing any span at any zoom reads at most a few entries per
+// pixel instead of every sample.
+//
+// build() cuts level 0 into one range per thread. Each range warms the
+// band filters up on a short stretch before its start, so ranges join like
+// a single serial pass.
+class WaveformPyramid {
+public:
+    WaveformPyramid();
+
+    void clear();
+    bool build(const PcmStore& pcm, int sampleRate, size_t threads);
+
+    // Summarizes [startFrame, endFrame) into one entry per column. Columns
+    // past the end of the track come back zeroed.
+    void query(double startFrame, double endFrame, size_t columns, vector<WaveformEntry>& out) const;
+
+    // The sidecar is tied to the source's size and modification time and
+    // ignored once either changes.
+    bool save(const string& path, const string& sourcePath) const;
+    bool load(const string& path, const string& sourcePath);
+
+    bool empty() const;
+    size_t getFrameCount() const;
+    int getSampleRate() const;
+    size_t getLevelCount() const;
+
+private:
+    struct BandFilter {
+        float lowState, highState;  // one-pole low-passes at 250 Hz and 4 kHz
+        float lowCoefficient, highCoefficient;
+    };
+
+    BandFilter makeFilter() const;
+    static void summarize(const float* mid, size_t frames, BandFilter& filter, WaveformEntry* out);
+    void buildRange(const PcmStore& pcm, size_t firstEntry, size_t lastEntry);
+    void buildLevels();
+
+    vector<vector<WaveformEntry>> levels;
+    size_t frameCount;
+    int sampleRate;
+};
+
+#endif // WAVEFORM_PYRAMID_H
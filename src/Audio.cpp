@@ -1,43 +1,294 @@
 #include "Audio.h"
 #include "../audio/AudioReader.h"
+#include "../audio/BeatDetector.h"
+#include "../audio/ChromaProcessor.h"
 #include "../audio/FFTProcessor.h"
+#include "../audio/MultiResolutionAnalyzer.h"
+#include "../audio/SpectralDescriptors.h"
+#include "../audio/SpectrumPublisher.h"
+#include "../audio/StreamReader.h"
+#include "../audio/ThreadRoles.h"
+#include "TraceRecorder.h"
 #include <portaudio.h>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 
 using namespace std;
 
+// Blocks of slack between the callback and the analysis thread.
+static const size_t BLOCK_QUEUE_SLOTS = 16;
+// Raw samples kept for the scopes: 1.4 s at 192 kHz, of which half can be
+// read back at once.
+static const size_t SAMPLE_RING_FRAMES = 1 << 18;
+// Decoded audio a live stream may run ahead of playback by.
+static const double DEFAULT_STREAM_BUFFER_SECONDS = 0.25;
+// How long startProcessing() waits for the first callback to report the
+// audio thread's role; past that the outcome goes unreported.
+static const int AUDIO_ROLE_WAIT_MS = 1000;
+
 AudioProcessor::AudioProcessor(size_t bufferSize) 
-    : bufferSize(bufferSize), audioReader(nullptr), fftProcessor(nullptr), stream(nullptr), isBufferReady(false) {
-    sharedBuffer.resize(bufferSize);
+    : bufferSize(bufferSize), analysisSize(bufferSize), decodeThreads(thread::hardware_concurrency()),
+      windowFunction(WindowFunction::Rectangular), fftBackend(DEFAULT_FFT_BACKEND),
+      pcmFormat(PcmFormat::Float32), overviewMode(OverviewMode::Off),
+      streamBuffer(DEFAULT_STREAM_BUFFER_SECONDS), audioReader(nullptr), nextTrack(0), nextReader(nullptr),
+      retiredReader(nullptr), lastRetired(nullptr), tracksPending(false), currentTrack(0), prefetchRunning(false),
+      liveStream(nullptr), fftProcessor(nullptr),
+      loudnessMeter(nullptr), chromaProcessor(nullptr), spectralDescriptors(nullptr),
+      spectrumAnalyzer(nullptr), beatDetector(nullptr), spectrumPublisher(nullptr), frameSequence(0), resumeOffset(NO_SEEK), silenceDetection(false), quietSamples(0), analysisRunning(false),
+      seekRequest(NO_SEEK), droppedBlocks(0), outputUnderflows(0), audioRoleApplied(false),
+      harmonicSeparation(false), fftsAvoided(0), signalWake(nullptr), stream(nullptr), traceRecorder(nullptr),
+      offline(false), offlineTime(0.0), playbackOffset(0) {
+    blockQueue.allocate(BLOCK_QUEUE_SLOTS, bufferSize);
+    sampleRing.allocate(SAMPLE_RING_FRAMES);
 }
 
 AudioProcessor::~AudioProcessor() {
     cleanup();
 }
 
+void AudioProcessor::setDecodeThreads(size_t threads) {
+    decodeThreads = threads;
+}
+
+void AudioProcessor::setWindow(WindowFunction window) {
+    windowFunction = window;
+}
+
+void AudioProcessor::setFFTBackend(FFTBackend backend) {
+    fftBackend = backend;
+}
+
+void AudioProcessor::setPcmFormat(PcmFormat format) {
+    pcmFormat = format;
+}
+
+void AudioProcessor::setOverviewMode(OverviewMode mode) {
+    overviewMode = mode;
+}
+
+void AudioProcessor::setRawPcmFormat(const RawPcmFormat& format) {
+    rawPcmFormat = format;
+}
+
+void AudioProcessor::setStreamBuffer(double seconds) {
+    streamBuffer = seconds;
+}
+
 bool AudioProcessor::loadAudioFile(const string& fileName) {
-    audioReader = new AudioFileReader();
-    if (!audioReader->loadFile(fileName)) {
+    AudioFileReader* firstReader = new AudioFileReader();
+    audioReader = firstReader;
+    firstReader->setDecodeThreads(decodeThreads);
+    firstReader->setPcmFormat(pcmFormat);
+    firstReader->setOverviewMode(overviewMode);
+    if (!firstReader->loadFile(fileName)) {
         cerr << "Failed to load audio file: " << fileName << endl;
         return false;
     }
-    fftProcessor = new FFTProcessor(bufferSize);
+    prepareAnalysis(firstReader->getSampleRate());
+    return true;
+}
+
+bool AudioProcessor::openStream(const string& source) {
+    AudioStreamReader* stream = new AudioStreamReader();
+    if (!stream->open(source, rawPcmFormat, streamBuffer)) {
+        cerr << "Failed to open audio stream: " << source << endl;
+        delete stream;
+        return false;
+    }
+    liveStream = stream;
+    streamLeft.assign(bufferSize, 0.0f);
+    streamRight.assign(bufferSize, 0.0f);
+    prepareAnalysis(stream->getSampleRate());
     return true;
 }
 
+void AudioProcessor::prepareAnalysis(int sampleRate) {
+    for (size_t size : plannedSizes) {
+        processorFor(size);
+    }
+    fftProcessor = processorFor(analysisSize);
+    loudnessMeter = new LoudnessMeter(sampleRate);
+    chromaProcessor = new ChromaProcessor(analysisSize, sampleRate);
+    spectralDescriptors = new SpectralDescriptors(analysisSize, sampleRate);
+    spectrumAnalyzer = new MultiResolutionAnalyzer(sampleRate, bufferSize, fftBackend);
+    beatDetector = new BeatDetector(sampleRate);
+    analysisWindow.assign(analysisSize, 0.0f);
+    sampleRing.setSampleRate(sampleRate);
+    playbackOffset = 0;
+
+    AnalysisFrame silent;
+    silent.magnitudes.assign(analysisSize / 2, 0.0f);
+    silent.loudness = loudnessMeter->getReading();
+    silent.bands.assign(SPECTRUM_BANDS, 0.0f);
+    silent.spectrumCost = spectrumAnalyzer->getCost();
+    silent.chroma.fill(0.0f);
+    silent.octaveEnergy.fill(0.0f);
+    silent.percussiveRatio = 0.0f;
+    silent.descriptors = SpectralFeatures();
+    silent.beat = false;
+    silent.beatStrength = 0.0f;
+    silent.tempo = 0.0f;
+    silent.samplePosition = 0;
+    silent.samples = &sampleRing;
+    silent.samplesEnd = 0;
+    silent.sequence = 0;
+    silent.silent = true;
+    frames.reset(silent);
+}
+
+bool AudioProcessor::loadPlaylist(const vector<string>& fileNames) {
+    if (fileNames.empty() || !loadAudioFile(fileNames[0])) {
+        return false;
+    }
+
+    playlist = fileNames;
+    nextTrack = 1;
+    currentTrack = 0;
+    tracksPending = playlist.size() > 1;
+    if (tracksPending) {
+        prefetchRunning = true;
+        prefetchThread = thread(&AudioProcessor::prefetchLoop, this);
+    }
+    return true;
+}
+
+bool AudioProcessor::publishSharedMemory(const string& name) {
+    if (getSampleRate() == 0) {
+        cerr << "ERROR: Load audio before publishing to shared memory." << endl;
+        return false;
+    }
+    SpectrumPublisher* publisher = new SpectrumPublisher();
+    if (!publisher->open(name, getSampleRate())) {
+        delete publisher;
+        return false;
+    }
+    spectrumPublisher = publisher;
+    return true;
+}
+
+size_t AudioProcessor::getCurrentTrack() const {
+    return currentTrack;
+}
+
+const WaveformPyramid* AudioProcessor::getOverview() const {
+    AudioFileReader* current = reader();
+    if (!current || current->getOverview().empty()) {
+        return nullptr;
+    }
+    return &current->getOverview();
+}
+
+void AudioProcessor::prefetchLoop() {
+    applyThreadRole(ThreadRole::Decode);
+    int streamRate = reader()->getSampleRate();
+
+    while (prefetchRunning) {
+        // The callback cannot free memory, so it parks the finished reader
+        // here. It is freed at the following handoff, a whole track later,
+        // by when no pre-roll or UI query can still be reading it.
+        AudioFileReader* retired = retiredReader.exchange(nullptr);
+        if (retired) {
+            delete lastRetired;
+            lastRetired = retired;
+        }
+
+        if (!nextReader.load() && nextTrack < playlist.size()) {
+            const string& fileName = playlist[nextTrack++];
+            AudioFileReader* prefetched = new AudioFileReader();
+            prefetched->setDecodeThreads(decodeThreads);
+            prefetched->setPcmFormat(pcmFormat);
+            prefetched->setOverviewMode(overviewMode);
+            if (!prefetched->loadFile(fileName)) {
+                cerr << "WARNING: Skipping unreadable playlist entry " << fileName << endl;
+                delete prefetched;
+            } else if (prefetched->getSampleRate() != streamRate) {
+                cerr << "WARNING: Skipping " << fileName << ": " << prefetched->getSampleRate()
+                     << " Hz does not match the stream's " << streamRate << " Hz." << endl;
+                delete prefetched;
+            } else {
+                nextReader.store(prefetched, memory_order_release);
+            }
+            continue;
+        }
+
+        if (!nextReader.load() && nextTrack >= playlist.size()) {
+            tracksPending = false;
+        }
+
+        // Polled rather than signalled: the callback never signals.
+        unique_lock<mutex> lock(prefetchMutex);
+        prefetchWake.wait_for(lock, chrono::milliseconds(50), [this] { return !prefetchRunning; });
+    }
+}
+
 bool AudioProcessor::startProcessing() {
-    if (!audioReader || !fftProcessor) {
+    if (getSampleRate() == 0 || !fftProcessor) {
         cerr << "AudioProcessor not initialized properly." << endl;
         return false;
     }
 
+    analysisRunning = true;
+    analysisThread = thread(&AudioProcessor::analysisLoop, this);
+
     Pa_Initialize();
-    Pa_OpenDefaultStream(&stream, 0, 1, paFloat32, audioReader->getSampleRate(), bufferSize, audioCallback, this);
+    Pa_OpenDefaultStream(&stream, 0, 1, paFloat32, getSampleRate(), bufferSize, audioCallback, this);
     Pa_StartStream(static_cast<PaStream*>(stream));
+
+    // The callback applies its own role but must not log, so the outcome
+    // is reported from here once the first block has run.
+    const ThreadPolicy& policy = getThreadRolePolicy(ThreadRole::Audio);
+    if (policy.scheduling != SchedulingPolicy::Normal || !policy.cpus.empty()) {
+        for (int waited = 0; !audioRoleApplied.load(memory_order_acquire) && waited < AUDIO_ROLE_WAIT_MS; ++waited) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        if (audioRoleApplied.load(memory_order_acquire)) {
+            reportThreadPolicy(audioRole, threadRoleName(ThreadRole::Audio));
+        }
+    }
+    return true;
+}
+
+bool AudioProcessor::startOffline() {
+    if (getSampleRate() == 0 || !fftProcessor) {
+        cerr << "AudioProcessor not initialized properly." << endl;
+        return false;
+    }
+    offline = true;
     return true;
 }
 
+int AudioProcessor::processOffline(float* output, unsigned long frames, const PaStreamCallbackTimeInfo& timeInfo,
+                                   PaStreamCallbackFlags statusFlags) {
+    offlineTime = timeInfo.currentTime;
+    int result = audioCallback(nullptr, output, frames, &timeInfo, statusFlags, this);
+    while (analyzeNext()) {
+    }
+    return result;
+}
+
+void AudioProcessor::setTraceRecorder(TraceRecorder* recorder) {
+    traceRecorder = recorder;
+}
+
+double AudioProcessor::getStreamTime() const {
+    if (offline) return offlineTime;
+    return stream ? Pa_GetStreamTime(static_cast<PaStream*>(stream)) : 0.0;
+}
+
+size_t AudioProcessor::getDroppedBlocks() const {
+    return droppedBlocks;
+}
+
+size_t AudioProcessor::getFftsAvoided() const {
+    return fftsAvoided;
+}
+
+size_t AudioProcessor::getOutputUnderflows() const {
+    return outputUnderflows;
+}
+
 void AudioProcessor::cleanup() {
     if (stream) {
         Pa_StopStream(static_cast<PaStream*>(stream));
@@ -46,42 +297,450 @@ void AudioProcessor::cleanup() {
     }
     Pa_Terminate();
 
-    delete fftProcessor;
+    if (prefetchRunning) {
+        prefetchRunning = false;
+        prefetchWake.notify_one();
+    }
+    if (prefetchThread.joinable()) {
+        prefetchThread.join();
+    }
+
+    analysisRunning = false;
+    wakeAnalysis.notify_one();
+    if (analysisThread.joinable()) {
+        analysisThread.join();
+    }
+
+    if (loudnessMeter) {
+        const LoudnessReading& summary = loudnessMeter->getReading();
+        cerr << "LOUDNESS: integrated " << summary.integrated << " LUFS, max true peak "
+             << summary.maxTruePeak << " dBTP" << endl;
+    }
+    if (droppedBlocks > 0) {
+        cerr << "WARNING: analysis fell behind and skipped " << droppedBlocks << " blocks." << endl;
+    }
+    if (outputUnderflows > 0) {
+        cerr << "WARNING: " << outputUnderflows << " audio blocks reached the device late (dropouts)." << endl;
+    }
+    if (liveStream && liveStream->getUnderruns() > 0) {
+        cerr << "WARNING: the input stream ran dry " << liveStream->getUnderruns() << " times." << endl;
+    }
+    delete loudnessMeter;
+    loudnessMeter = nullptr;
+
+    delete spectrumAnalyzer;
+    spectrumAnalyzer = nullptr;
+
+    delete spectrumPublisher;
+    spectrumPublisher = nullptr;
+
+    delete beatDetector;
+    beatDetector = nullptr;
+
+    delete chromaProcessor;
+    chromaProcessor = nullptr;
+
+    delete spectralDescriptors;
+    spectralDescriptors = nullptr;
+
+    for (FFTProcessor* processor : fftProcessors) {
+        delete processor;
+    }
+    fftProcessors.clear();
     fftProcessor = nullptr;
 
-    delete audioReader;
-    audioReader = nullptr;
+    delete audioReader.exchange(nullptr);
+    delete nextReader.exchange(nullptr);
+    delete retiredReader.exchange(nullptr);
+    delete lastRetired;
+    lastRetired = nullptr;
+    playlist.clear();
+
+    delete liveStream;
+    liveStream = nullptr;
+}
+
+const AnalysisFrame* AudioProcessor::getLatestFrame() {
+    return frames.read();
+}
+
+void AudioProcessor::seek(double seconds) {
+    if (!reader()) return;
+    double sample = max(0.0, seconds) * reader()->getSampleRate();
+    seekToSample(static_cast<size_t>(sample));
+}
+
+void AudioProcessor::scrub(double deltaSeconds) {
+    if (!reader()) return;
+    seek(getPlaybackTime() + deltaSeconds);
+}
+
+void AudioProcessor::seekToSample(size_t sampleOffset) {
+    if (!reader()) return;
+
+    size_t totalSamples = getTotalSamples();
+    if (sampleOffset >= totalSamples) {
+        sampleOffset = totalSamples > bufferSize ? totalSamples - bufferSize : 0;
+    }
+
+    playbackOffset = sampleOffset;
+
+    // The analysis thread pre-rolls the new position straight away rather
+    // than waiting for the callback, so the next frame already shows it.
+    seekRequest = sampleOffset;
+    wakeAnalysis.notify_one();
+
+    // The stream stops itself with paComplete at the end of the track, so
+    // seeking back from there has to restart it.
+    if (stream && Pa_IsStreamActive(static_cast<PaStream*>(stream)) == 0) {
+        Pa_StopStream(static_cast<PaStream*>(stream));
+        Pa_StartStream(static_cast<PaStream*>(stream));
+    }
+}
+
+size_t AudioProcessor::getPlaybackPosition() const {
+    return playbackOffset;
+}
+
+double AudioProcessor::getPlaybackTime() const {
+    int sampleRate = getSampleRate();
+    if (sampleRate == 0) return 0.0;
+    return static_cast<double>(playbackOffset) / sampleRate;
+}
+
+size_t AudioProcessor::getTotalSamples() const {
+    AudioFileReader* current = reader();
+    return current ? current->getFrameCount() : 0;
+}
+
+int AudioProcessor::getSampleRate() const {
+    if (liveStream) return liveStream->getSampleRate();
+    AudioFileReader* current = reader();
+    return current ? current->getSampleRate() : 0;
 }
 
-vector<float> AudioProcessor::getFFTData() {
-    unique_lock<mutex> lock(audioMutex);
-    bufferReady.wait(lock, [this] { return isBufferReady; });
+void AudioProcessor::setAnalysisSize(size_t size) {
+    analysisSize = size;
+    wakeAnalysis.notify_one();
+}
 
-    fftProcessor->computeFFT(sharedBuffer);
-    isBufferReady = false;
-    return fftProcessor->getMagnitudes();
+size_t AudioProcessor::getAnalysisSize() const {
+    return analysisSize;
+}
+
+void AudioProcessor::planAnalysisSizes(const vector<size_t>& sizes) {
+    plannedSizes = sizes;
+}
+
+void AudioProcessor::setSilenceDetection(bool enabled) {
+    silenceDetection = enabled;
+}
+
+void AudioProcessor::wakeOnSignal(void (*wake)()) {
+    signalWake = wake;
+}
+
+void AudioProcessor::setHarmonicSeparation(bool enabled) {
+    harmonicSeparation = enabled;
+}
+
+void AudioProcessor::analysisLoop() {
+    applyThreadRole(ThreadRole::Analysis);
+    while (analysisRunning) {
+        if (!analyzeNext()) {
+            unique_lock<mutex> lock(wakeMutex);
+            // The callback never signals: a notify can make a syscall on the
+            // realtime thread. It only queues blocks, and this timeout is
+            // what picks them up. Seeks and shutdown do notify.
+            wakeAnalysis.wait_for(lock, chrono::milliseconds(2), [this] {
+                return !blockQueue.empty() || seekRequest != NO_SEEK || !analysisRunning;
+            });
+        }
+    }
+}
+
+bool AudioProcessor::analyzeNext() {
+    // After a seek, blocks the callback queued from the old position are
+    // dropped until the one starting at the seek target arrives.
+    size_t seekTarget = seekRequest.exchange(NO_SEEK);
+    if (seekTarget != NO_SEEK) {
+        preRollAnalysis(seekTarget);
+        resumeOffset = seekTarget;
+    }
+
+    if (analysisSize != analysisWindow.size()) {
+        resizeAnalysis(analysisSize);
+    }
+
+    AudioBlock* block = blockQueue.front();
+    if (!block) {
+        return false;
+    }
+
+    if (resumeOffset != NO_SEEK) {
+        if (block->sourceOffset != resumeOffset) {
+            blockQueue.pop();
+            return true;
+        }
+        resumeOffset = NO_SEEK;
+    }
+
+    float peak = 0.0f;
+    for (size_t i = 0; i < block->frames; ++i) {
+        peak = max(peak, max(fabs(block->left[i]), fabs(block->right[i])));
+    }
+    quietSamples = peak < SILENCE_LEVEL ? quietSamples + block->frames : 0;
+
+    loudnessMeter->process(block->left.data(), block->right.data(), block->frames, block->channels);
+    pushToWindow(analysisWindow, block->left.data(), block->frames);
+    // Its history is all quiet by now, so skipping pushes while the silence
+    // lasts leaves it as it would have been, near enough.
+    if (!isSilent(analysisWindow.size())) {
+        spectrumAnalyzer->push(block->left.data(), block->frames);
+    }
+    sampleRing.write(block->left.data(), block->right.data(), block->frames);
+    size_t samplePosition = block->sourceOffset + block->frames;
+    blockQueue.pop();
+
+    publishFrame(analysisWindow, samplePosition);
+    return true;
+}
+
+FFTProcessor* AudioProcessor::processorFor(size_t size) {
+    for (FFTProcessor* processor : fftProcessors) {
+        if (processor->getSize() == size) return processor;
+    }
+    FFTProcessor* processor = new FFTProcessor(size, fftBackend);
+    processor->setWindow(windowFunction);
+    fftProcessors.push_back(processor);
+    return processor;
+}
+
+void AudioProcessor::resizeAnalysis(size_t size) {
+    // Planned sizes are a pointer swap; anything else is planned here.
+    fftProcessor = processorFor(size);
+    chromaProcessor->configure(size, getSampleRate());
+    spectralDescriptors->configure(size, getSampleRate());
+
+    vector<float> resized(size, 0.0f);
+    size_t keep = min(size, analysisWindow.size());
+    copy(analysisWindow.end() - keep, analysisWindow.end(), resized.end() - keep);
+    analysisWindow.swap(resized);
+}
+
+void AudioProcessor::fillWindow(vector<float>& window, size_t endSample) {
+    // Samples before the start of the track and past its end read as zero.
+    size_t windowSize = window.size();
+    size_t before = windowSize > endSample ? windowSize - endSample : 0;
+    fill(window.begin(), window.begin() + before, 0.0f);
+    size_t read = reader()->getPcm().read(endSample + before - windowSize, windowSize - before,
+                                          window.data() + before, nullptr);
+    fill(window.begin() + before + read, window.end(), 0.0f);
+}
+
+bool AudioProcessor::isSilent(size_t windowSize) const {
+    return silenceDetection && quietSamples >= max(windowSize, spectrumAnalyzer->getHistorySize());
+}
+
+void AudioProcessor::preRollAnalysis(size_t sampleOffset) {
+    // The separation and onset histories belong to the old position.
+    quietSamples = 0;
+    chromaProcessor->reset();
+    spectralDescriptors->reset();
+    beatDetector->reset();
+
+    // History up to the target, so the first block played after the seek
+    // extends a valid window...
+    fillWindow(analysisWindow, sampleOffset);
+    spectrumHistory.resize(spectrumAnalyzer->getHistorySize());
+    fillWindow(spectrumHistory, sampleOffset);
+    // The multi-resolution bands in the preview lag it by one block.
+    spectrumAnalyzer->reset(spectrumHistory);
+
+    // ...and publish a frame for that first block right now instead of
+    // waiting for the callback to play it.
+    previewWindow.resize(analysisWindow.size());
+    fillWindow(previewWindow, sampleOffset + bufferSize);
+    publishFrame(previewWindow, sampleOffset + bufferSize);
+}
+
+void AudioProcessor::publishFrame(const vector<float>& window, size_t samplePosition) {
+    // A silent window has an empty spectrum; publishing exact zeros instead
+    // of transforming the noise floor also keeps auto-gained scenes still.
+    bool silent = isSilent(window.size());
+    if (silent) {
+        fftsAvoided.fetch_add(1, memory_order_relaxed);
+    } else {
+        fftProcessor->computeFFT(window);
+    }
+    const vector<float>& magnitudes = fftProcessor->getMagnitudes();
+
+    // A tone's magnitude grows with the window length; rescale so levels
+    // stay comparable when the analysis size changes.
+    float scale = static_cast<float>(bufferSize) / window.size();
+
+    AnalysisFrame& frame = frames.writeBuffer();
+    frame.magnitudes.resize(magnitudes.size());
+    for (size_t i = 0; i < magnitudes.size(); ++i) {
+        frame.magnitudes[i] = silent ? 0.0f : magnitudes[i] * scale;
+    }
+    frame.bands = spectrumAnalyzer->getBands();
+    if (silent) {
+        fill(frame.bands.begin(), frame.bands.end(), 0.0f);
+    }
+    frame.spectrumCost = spectrumAnalyzer->getCost();
+    frame.loudness = loudnessMeter->getReading();
+
+    chromaProcessor->setHarmonicSeparation(harmonicSeparation);
+    chromaProcessor->process(frame.magnitudes);
+    frame.chroma = chromaProcessor->getChroma();
+    frame.octaveEnergy = chromaProcessor->getOctaveEnergy();
+    frame.percussiveRatio = chromaProcessor->getPercussiveRatio();
+
+    frame.descriptors = spectralDescriptors->process(frame.magnitudes.data());
+
+    beatDetector->process(frame.bands, bufferSize);
+    frame.beat = beatDetector->isBeat();
+    frame.beatStrength = beatDetector->getStrength();
+    frame.tempo = beatDetector->getTempo();
+
+    frame.samplePosition = samplePosition;
+    frame.samples = &sampleRing;
+    frame.samplesEnd = sampleRing.written();
+    frame.sequence = ++frameSequence;
+    frame.silent = silent;
+    if (spectrumPublisher) {
+        spectrumPublisher->publish(frame);
+    }
+    frames.publish();
+
+    if (!silent) {
+        void (*wake)() = signalWake.exchange(nullptr);
+        if (wake) wake();
+    }
+}
+
+void AudioProcessor::pushToWindow(vector<float>& window, const float* samples, size_t count) {
+    if (count >= window.size()) {
+        copy(samples + count - window.size(), samples + count, window.begin());
+    } else {
+        move(window.begin() + count, window.end(), window.begin());
+        copy(samples, samples + count, window.end() - count);
+    }
+}
+
+size_t AudioProcessor::copyFrames(const AudioFileReader* source, size_t offset, size_t count, float* left,
+                                  float* right) {
+    return source->getPcm().read(offset, count, left, right);
 }
 
 int AudioProcessor::audioCallback(const void* inputBuffer, void* outputBuffer, unsigned long framesPerBuffer,
                                    const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void* userData) {
     AudioProcessor* processor = static_cast<AudioProcessor*>(userData);
     float* out = static_cast<float*>(outputBuffer);
-    auto& leftChannel = processor->audioReader->getLeftChannel();
+    AudioFileReader* current = processor->reader();
 
-    static size_t currentOffset = 0;
-    if (currentOffset + framesPerBuffer <= leftChannel.size()) {
-        copy(leftChannel.begin() + currentOffset, leftChannel.begin() + currentOffset + framesPerBuffer, out);
+    // PortAudio owns the callback thread, so its role is applied from
+    // inside, once; startProcessing() reports how it went.
+    if (!processor->offline && !processor->audioRoleApplied.load(memory_order_relaxed)) {
+        processor->audioRole = applyThreadPolicyQuietly(getThreadRolePolicy(ThreadRole::Audio));
+        processor->audioRoleApplied.store(true, memory_order_release);
+    }
+    if (statusFlags & paOutputUnderflow) {
+        processor->outputUnderflows.fetch_add(1, memory_order_relaxed);
+    }
 
-        {
-            lock_guard<mutex> lock(processor->audioMutex);
-            copy(leftChannel.begin() + currentOffset, leftChannel.begin() + currentOffset + framesPerBuffer, processor->sharedBuffer.begin());
-            processor->isBufferReady = true;
+    size_t currentOffset = processor->playbackOffset.load();
+    if (processor->traceRecorder) {
+        processor->traceRecorder->recordCallback(timeInfo->currentTime, currentOffset,
+                                                 timeInfo->outputBufferDacTime - timeInfo->currentTime,
+                                                 framesPerBuffer, statusFlags);
+    }
+
+    if (processor->liveStream) {
+        return processor->playStream(out, framesPerBuffer, currentOffset);
+    }
+
+    size_t fromCurrent = copyFrames(current, currentOffset, framesPerBuffer, out, nullptr);
+
+    // Near the end of a track the rest of the block comes from the
+    // prefetched next one, so the handoff lands on the exact sample.
+    AudioFileReader* next = nullptr;
+    size_t fromNext = 0;
+    if (fromCurrent < framesPerBuffer) {
+        next = processor->nextReader.load(memory_order_acquire);
+        if (next) {
+            fromNext = copyFrames(next, 0, framesPerBuffer - fromCurrent, out + fromCurrent, nullptr);
+        } else if (fromCurrent == 0 && !processor->tracksPending) {
+            return paComplete;
         }
-        processor->bufferReady.notify_one();
-        currentOffset += framesPerBuffer;
+        // Still decoding the next track (or the last one ends mid-block):
+        // pad with silence rather than stop.
+        fill(out + fromCurrent + fromNext, out + framesPerBuffer, 0.0f);
+    }
+
+    // Hand the block to the analysis thread. No locks here: if the queue
+    // is full the block is skipped for analysis but still played.
+    AudioBlock* block = processor->blockQueue.beginWrite();
+    if (block) {
+        size_t frames = min<size_t>(framesPerBuffer, block->left.size());
+        size_t head = copyFrames(current, currentOffset, frames, block->left.data(), block->right.data());
+        size_t tail = next ? copyFrames(next, 0, frames - head, block->left.data() + head, block->right.data() + head) : 0;
+        fill(block->left.begin() + head + tail, block->left.begin() + frames, 0.0f);
+        fill(block->right.begin() + head + tail, block->right.begin() + frames, 0.0f);
+        block->sourceOffset = currentOffset;
+        block->frames = frames;
+        block->channels = current->getPcm().getChannels();
+        processor->blockQueue.commitWrite();
     } else {
+        processor->droppedBlocks.fetch_add(1, memory_order_relaxed);
+    }
+
+    // A seek that lands mid-block wins over this advance. At a handoff it
+    // keeps the track it was aimed at current; the next one waits.
+    size_t expected = currentOffset;
+    if (next) {
+        if (processor->playbackOffset.compare_exchange_strong(expected, fromNext)) {
+            processor->nextReader.store(nullptr, memory_order_relaxed);
+            processor->retiredReader.store(current, memory_order_release);
+            processor->audioReader.store(next, memory_order_release);
+            processor->currentTrack.fetch_add(1);
+        }
+        return paContinue;
+    }
+
+    processor->playbackOffset.compare_exchange_strong(expected, currentOffset + fromCurrent);
+    return paContinue;
+}
+
+int AudioProcessor::playStream(float* out, unsigned long framesPerBuffer, size_t offset) {
+    // Reading the stream consumes it, so the block is taken once and both
+    // the output and the analysis copy come from the scratch channels.
+    size_t frames = min<size_t>(framesPerBuffer, streamLeft.size());
+    size_t got = liveStream->read(frames, streamLeft.data(), streamRight.data());
+    if (got == 0 && liveStream->finished()) {
+        fill(out, out + framesPerBuffer, 0.0f);
         return paComplete;
     }
+    // Short of data (the writer is late) or at the very end: pad.
+    fill(streamLeft.begin() + got, streamLeft.begin() + frames, 0.0f);
+    fill(streamRight.begin() + got, streamRight.begin() + frames, 0.0f);
+    copy(streamLeft.begin(), streamLeft.begin() + frames, out);
+    fill(out + frames, out + framesPerBuffer, 0.0f);
+
+    AudioBlock* block = blockQueue.beginWrite();
+    if (block) {
+        size_t blockFrames = min(frames, block->left.size());
+        copy(streamLeft.begin(), streamLeft.begin() + blockFrames, block->left.begin());
+        copy(streamRight.begin(), streamRight.begin() + blockFrames, block->right.begin());
+        block->sourceOffset = offset;
+        block->frames = blockFrames;
+        block->channels = liveStream->getChannels();
+        blockQueue.commitWrite();
+    } else {
+        droppedBlocks.fetch_add(1, memory_order_relaxed);
+    }
 
+    playbackOffset.store(offset + frames);
     return paContinue;
 }
@@ -4,35 +4,210 @@
 #include <vector>
 #include <string>
 #include <mutex>
+#include <atomic>
+#include <thread>
 #include <condition_variable>
 #include <portaudio.h>
+#include "../audio/AnalysisFrame.h"
+#include "../audio/BlockQueue.h"
+#include "../audio/FFTProcessor.h"
+#include "../audio/PcmStore.h"
+#include "../audio/SampleRing.h"
+#include "../audio/StreamReader.h"
+#include "../audio/LoudnessMeter.h"
+#include "../audio/ThreadRoles.h"
+#include "../audio/TripleBuffer.h"
+#include "../audio/WaveformPyramid.h"
 
 using namespace std;
 
+class AudioFileReader;
+class AudioStreamReader;
+
 class AudioProcessor {
 public:
     AudioProcessor(size_t bufferSize);
     ~AudioProcessor();
 
+    // These apply to the next loadAudioFile() or openStream().
+    void setDecodeThreads(size_t threads);
+    void setWindow(WindowFunction window);
+    void setFFTBackend(FFTBackend backend);
+    void setPcmFormat(PcmFormat format);
+    void setOverviewMode(OverviewMode mode);
+    // Headerless input; channels 0 (the default) sniffs the format.
+    void setRawPcmFormat(const RawPcmFormat& format);
+    void setStreamBuffer(double seconds);
+
     bool loadAudioFile(const string& fileName);
 
-    vector<float> getFFTData();
+    // Loads the first file like loadAudioFile and plays the rest back to
+    // back. Each following track is decoded on a background thread while the
+    // current one plays and handed over inside the callback at the exact
+    // sample, so the stream, FFT plans and analysis state carry straight on.
+    // Every track must share the first one's sample rate; others are skipped.
+    bool loadPlaylist(const vector<string>& fileNames);
+    size_t getCurrentTrack() const;
+
+    // Plays audio piped in by another process ("-" for stdin, or a FIFO)
+    // instead of a file. Decoding keeps pace with the pipe, a few hundred
+    // milliseconds ahead at most; the stream cannot seek, has no length
+    // and plays until the writer closes it.
+    bool openStream(const string& source);
+
+    // Summary of the track now playing, or null without one. Like the
+    // other UI queries it stays valid until the track after next starts.
+    const WaveformPyramid* getOverview() const;
+
+    // Newest analysis result. Never blocks or copies; the pointer stays
+    // valid until the next call. Render thread only.
+    const AnalysisFrame* getLatestFrame();
 
     bool startProcessing();
 
+    // Drives the callback by hand instead of from a PortAudio stream, for
+    // trace replay. Analysis runs synchronously inside processOffline, so a
+    // replay is deterministic for a given trace.
+    bool startOffline();
+    int processOffline(float* output, unsigned long frames, const PaStreamCallbackTimeInfo& timeInfo,
+                       PaStreamCallbackFlags statusFlags);
+
+    // Set before startProcessing(); the callback logs its timing into it.
+    void setTraceRecorder(class TraceRecorder* recorder);
+    // PortAudio stream clock, or the replayed clock when offline.
+    double getStreamTime() const;
+    size_t getDroppedBlocks() const;
+    // Hops published as silent without running the FFTs.
+    size_t getFftsAvoided() const;
+    // Blocks PortAudio reports it could not deliver to the device in time.
+    size_t getOutputUnderflows() const;
+
+    // Changes the FFT window length without touching the stream's block
+    // size. The analysis thread switches at its next hop.
+    void setAnalysisSize(size_t size);
+    size_t getAnalysisSize() const;
+    // Sizes setAnalysisSize() may switch to later. Their FFTs are planned
+    // when the audio is loaded, since FFTW_MEASURE planning on the analysis
+    // thread would stall it long enough to drop blocks. Call before loading.
+    void planAnalysisSizes(const vector<size_t>& sizes);
+
+    // Also writes every analysis frame into a shared-memory ring for other
+    // local processes. Call after loadAudioFile().
+    bool publishSharedMemory(const string& name);
+
+    // Publish frames over silence as silent, skipping their FFTs; off by
+    // default. Call before starting.
+    void setSilenceDetection(bool enabled);
+    // Render thread, before it sleeps: the next frame published with signal
+    // in it calls wake, once, from the analysis thread.
+    void wakeOnSignal(void (*wake)());
+
+    // Strips percussive energy from the chroma before it is published.
+    void setHarmonicSeparation(bool enabled);
+
+    // Seeking is safe to call from the UI thread; the callback picks the new
+    // position up at its next block.
+    void seek(double seconds);
+    void seekToSample(size_t sampleOffset);
+    void scrub(double deltaSeconds);
+    size_t getPlaybackPosition() const;
+    double getPlaybackTime() const;
+    size_t getTotalSamples() const;
+    int getSampleRate() const;
+
     void cleanup();
 
 private:
     size_t bufferSize;
-    class AudioFileReader* audioReader;
-    class FFTProcessor* fftProcessor;
+    atomic<size_t> analysisSize;
+    size_t decodeThreads;
+    WindowFunction windowFunction;
+    FFTBackend fftBackend;
+    PcmFormat pcmFormat;
+    OverviewMode overviewMode;
+    RawPcmFormat rawPcmFormat;
+    double streamBuffer;
+    // Swapped by the callback at a track handoff.
+    atomic<AudioFileReader*> audioReader;
+    AudioFileReader* reader() const { return audioReader.load(memory_order_acquire); }
+
+    // Playlist prefetch. The thread decodes playlist[nextTrack] into
+    // nextReader; the callback takes it and parks the finished reader in
+    // retiredReader.
+    vector<string> playlist;
+    size_t nextTrack;
+    atomic<AudioFileReader*> nextReader;
+    atomic<AudioFileReader*> retiredReader;
+    AudioFileReader* lastRetired;
+    atomic<bool> tracksPending;
+    atomic<size_t> currentTrack;
+    thread prefetchThread;
+    atomic<bool> prefetchRunning;
+    mutex prefetchMutex;
+    condition_variable prefetchWake;
+
+    // Live input, instead of a reader. The callback reads each block from
+    // it once into the scratch channels and plays and analyses that copy.
+    AudioStreamReader* liveStream;
+    vector<float> streamLeft;
+    vector<float> streamRight;
 
-    vector<float> sharedBuffer;
-    mutex audioMutex;
-    condition_variable bufferReady;
-    bool isBufferReady;
+    // Owned by the analysis thread while it runs.
+    FFTProcessor* fftProcessor;  // the one in fftProcessors for the current size
+    vector<FFTProcessor*> fftProcessors;
+    vector<size_t> plannedSizes;
+    LoudnessMeter* loudnessMeter;
+    class ChromaProcessor* chromaProcessor;
+    class SpectralDescriptors* spectralDescriptors;
+    class MultiResolutionAnalyzer* spectrumAnalyzer;
+    class BeatDetector* beatDetector;
+    class SpectrumPublisher* spectrumPublisher;
+    vector<float> spectrumHistory;
+    vector<float> analysisWindow;
+    vector<float> previewWindow;
+    uint64_t frameSequence;
+    size_t resumeOffset;
+    bool silenceDetection;
+    size_t quietSamples;  // newest samples in a row below SILENCE_LEVEL
+
+    BlockQueue blockQueue;
+    SampleRing sampleRing;
+    TripleBuffer<AnalysisFrame> frames;
+
+    thread analysisThread;
+    atomic<bool> analysisRunning;
+    mutex wakeMutex;
+    condition_variable wakeAnalysis;
+    atomic<size_t> seekRequest;
+    atomic<size_t> droppedBlocks;
+    atomic<size_t> outputUnderflows;
+    ThreadPolicyResult audioRole;     // written by the callback before audioRoleApplied
+    atomic<bool> audioRoleApplied;
+    atomic<bool> harmonicSeparation;
+    atomic<size_t> fftsAvoided;
+    atomic<void (*)()> signalWake;
 
     void* stream;
+    class TraceRecorder* traceRecorder;
+    bool offline;
+    double offlineTime;
+
+    atomic<size_t> playbackOffset;
+    static constexpr size_t NO_SEEK = static_cast<size_t>(-1);
+
+    void prepareAnalysis(int sampleRate);
+    int playStream(float* out, unsigned long framesPerBuffer, size_t offset);
+    void analysisLoop();
+    void prefetchLoop();
+    bool analyzeNext();
+    void resizeAnalysis(size_t size);
+    FFTProcessor* processorFor(size_t size);
+    void preRollAnalysis(size_t sampleOffset);
+    void fillWindow(vector<float>& window, size_t endSample);
+    void publishFrame(const vector<float>& window, size_t samplePosition);
+    bool isSilent(size_t windowSize) const;
+    static void pushToWindow(vector<float>& window, const float* samples, size_t count);
+    static size_t copyFrames(const AudioFileReader* source, size_t offset, size_t count, float* left, float* right);
 
     static int audioCallback(const void* inputBuffer, void* outputBuffer, unsigned long framesPerBuffer,
                              const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void* userData);
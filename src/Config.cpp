@@ -0,0 +1,284 @@
+#include "Config.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+AppConfig::AppConfig()
+    : layout(SceneLayout::Grid), fftSize(1024), hop(1024), window(WindowFunction::Rectangular),
+      fftBackend(DEFAULT_FFT_BACKEND), bandScale(BandScale::Linear), vsync(true), width(800), height(600),
+      mode(RunMode::Realtime), decodeThreads(std::thread::hardware_concurrency()),
+      pcmFormat(PcmFormat::Float32), targetFps(60.0), governor(false), loudness(true), postEffects(false), idle(false),
+      overview(OverviewMode::Off),
+      lockMemory(false), hotReload(false), streamBuffer(0.25) {}
+
+static bool parseBool(const std::string& value, bool& out) {
+    if (value == "on" || value == "true" || value == "yes" || value == "1") {
+        out = true;
+        return true;
+    }
+    if (value == "off" || value == "false" || value == "no" || value == "0") {
+        out = false;
+        return true;
+    }
+    return false;
+}
+
+static bool parseSize(const std::string& value, size_t minimum, size_t maximum, size_t& out) {
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || parsed < minimum || parsed > maximum) {
+        return false;
+    }
+    out = static_cast<size_t>(parsed);
+    return true;
+}
+
+static bool isPowerOfTwo(size_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+static std::vector<std::string> splitList(const std::string& value) {
+    std::vector<std::string> items;
+    std::string item;
+    std::istringstream stream(value);
+    while (std::getline(stream, item, ',')) {
+        std::istringstream words(item);
+        std::string word;
+        while (words >> word) {
+            items.push_back(word);
+        }
+    }
+    return items;
+}
+
+static bool applySetting(AppConfig& config, const std::string& key, const std::string& value) {
+    size_t size = 0;
+    bool ok = true;
+
+    if (key == "input") {
+        config.input = value;
+    } else if (key == "playlist") {
+        config.playlist = value;
+    } else if (key == "scenes") {
+        config.scenes = splitList(value);
+        ok = !config.scenes.empty();
+    } else if (key == "layout") {
+        if (value == "grid") config.layout = SceneLayout::Grid;
+        else if (value == "horizontal") config.layout = SceneLayout::Horizontal;
+        else if (value == "vertical") config.layout = SceneLayout::Vertical;
+        else ok = false;
+    } else if (key == "fft-size") {
+        ok = parseSize(value, 64, 65536, size) && isPowerOfTwo(size);
+        if (ok) config.fftSize = size;
+    } else if (key == "hop") {
+        // Trace events store the block size in 16 bits.
+        ok = parseSize(value, 64, 32768, size);
+        if (ok) config.hop = size;
+    } else if (key == "window") {
+        if (value == "rectangular") config.window = WindowFunction::Rectangular;
+        else if (value == "hann") config.window = WindowFunction::Hann;
+        else if (value == "blackman-harris") config.window = WindowFunction::BlackmanHarris;
+        else ok = false;
+    } else if (key == "fft-backend") {
+        if (value == "fftw") config.fftBackend = FFTBackend::FFTW;
+        else if (value == "fixed") config.fftBackend = FFTBackend::Fixed;
+        else ok = false;
+    } else if (key == "band-scale") {
+        if (value == "linear") config.bandScale = BandScale::Linear;
+        else if (value == "log") config.bandScale = BandScale::Logarithmic;
+        else ok = false;
+    } else if (key == "vsync") {
+        ok = parseBool(value, config.vsync);
+    } else if (key == "width" || key == "height") {
+        ok = parseSize(value, 64, 16384, size);
+        if (ok) (key == "width" ? config.width : config.height) = static_cast<int>(size);
+    } else if (key == "mode") {
+        if (value == "realtime") config.mode = RunMode::Realtime;
+        else if (value == "offline") config.mode = RunMode::Offline;
+        else ok = false;
+    } else if (key == "decode-threads") {
+        ok = parseSize(value, 1, 256, config.decodeThreads);
+    } else if (key == "pcm-format") {
+        if (value == "float") config.pcmFormat = PcmFormat::Float32;
+        else if (value == "int16") config.pcmFormat = PcmFormat::Int16;
+        else if (value == "float16") config.pcmFormat = PcmFormat::Float16;
+        else ok = false;
+    } else if (key == "fps") {
+        char* end = nullptr;
+        double fps = std::strtod(value.c_str(), &end);
+        ok = !value.empty() && *end == '\0' && fps >= 1.0 && fps <= 1000.0;
+        if (ok) config.targetFps = fps;
+    } else if (key == "governor") {
+        ok = parseBool(value, config.governor);
+    } else if (key == "loudness") {
+        ok = parseBool(value, config.loudness);
+    } else if (key == "post") {
+        ok = parseBool(value, config.postEffects);
+    } else if (key == "idle") {
+        ok = parseBool(value, config.idle);
+    } else if (key == "overview") {
+        if (value == "off") config.overview = OverviewMode::Off;
+        else if (value == "on") config.overview = OverviewMode::Build;
+        else if (value == "cached") config.overview = OverviewMode::Cached;
+        else ok = false;
+    } else if (key == "audio-thread") {
+        ok = parseThreadPolicy(value, config.threadPolicies[static_cast<size_t>(ThreadRole::Audio)]);
+    } else if (key == "analysis-thread") {
+        ok = parseThreadPolicy(value, config.threadPolicies[static_cast<size_t>(ThreadRole::Analysis)]);
+    } else if (key == "render-thread") {
+        ok = parseThreadPolicy(value, config.threadPolicies[static_cast<size_t>(ThreadRole::Render)]);
+    } else if (key == "decode-thread") {
+        ok = parseThreadPolicy(value, config.threadPolicies[static_cast<size_t>(ThreadRole::Decode)]);
+    } else if (key == "lock-memory") {
+        ok = parseBool(value, config.lockMemory);
+    } else if (key == "hot-reload") {
+        ok = parseBool(value, config.hotReload);
+    } else if (key == "raw-pcm") {
+        ok = parseRawPcmFormat(value, config.rawPcm);
+    } else if (key == "stream-buffer") {
+        ok = parseSize(value, 20, 10000, size);
+        if (ok) config.streamBuffer = size / 1000.0;
+    } else if (key == "shared-memory") {
+        config.sharedMemory = value;
+    } else if (key == "record") {
+        config.recordTrace = value;
+    } else if (key == "replay") {
+        config.replayTrace = value;
+    } else {
+        std::cerr << "ERROR: Unknown setting '" << key << "'." << std::endl;
+        return false;
+    }
+
+    if (!ok) {
+        std::cerr << "ERROR: Invalid value '" << value << "' for " << key << "." << std::endl;
+    }
+    return ok;
+}
+
+static std::string trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t\r");
+    if (start == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(start, end - start + 1);
+}
+
+bool loadConfigFile(const std::string& path, AppConfig& config) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "ERROR: Cannot open config file " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            std::cerr << "ERROR: " << path << ":" << lineNumber << ": expected key = value" << std::endl;
+            return false;
+        }
+        if (!applySetting(config, trim(line.substr(0, equals)), trim(line.substr(equals + 1)))) {
+            std::cerr << "ERROR: in " << path << ":" << lineNumber << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool loadPlaylistFile(const std::string& path, std::vector<std::string>& tracks) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "ERROR: Cannot open playlist " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        tracks.push_back(line);
+    }
+    if (tracks.empty()) {
+        std::cerr << "ERROR: Playlist " << path << " has no tracks." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool parseCommandLine(int argc, char* argv[], AppConfig& config) {
+    std::vector<std::pair<std::string, std::string>> settings;
+    std::string configPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            std::cerr << "ERROR: Unexpected argument '" << arg << "'." << std::endl;
+            return false;
+        }
+
+        std::string key = arg.substr(2), value;
+        size_t equals = key.find('=');
+        if (equals != std::string::npos) {
+            value = key.substr(equals + 1);
+            key = key.substr(0, equals);
+        } else if (i + 1 < argc) {
+            value = argv[++i];
+        } else {
+            std::cerr << "ERROR: Missing value for --" << key << "." << std::endl;
+            return false;
+        }
+
+        if (key == "config") {
+            configPath = value;
+        } else {
+            settings.emplace_back(key, value);
+        }
+    }
+
+    if (!configPath.empty() && !loadConfigFile(configPath, config)) {
+        return false;
+    }
+    for (const auto& setting : settings) {
+        if (!applySetting(config, setting.first, setting.second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--config file] [--key value ...]\n"
+              << "  input <file>               audio file (prompted for if omitted); - (stdin) or a FIFO\n"
+              << "                             is played as a live stream, MP3 or WAV by its header\n"
+              << "  raw-pcm s16le|f32le:<rate>:<channels>   headerless live stream (e.g. s16le:44100:2)\n"
+              << "  stream-buffer <ms>         how far decoding may run ahead of a live stream (250)\n"
+              << "  playlist <file>            list of tracks, one per line, played gaplessly\n"
+              << "  scenes <list>              comma separated: circle, bar, circular-bar, mountain, particles,\n"
+              << "                             oscilloscope, vectorscope, terrain\n"
+              << "  layout grid|horizontal|vertical\n"
+              << "  fft-size <n>               starting FFT size, power of two (1024)\n"
+              << "  hop <n>                    audio block size in frames (1024)\n"
+              << "  window rectangular|hann|blackman-harris\n"
+              << "  fft-backend fftw|fixed     fixed uses compile-time kernels (256 to 8192 points)\n"
+              << "  band-scale linear|log\n"
+              << "  vsync on|off   width <px>   height <px>\n"
+              << "  mode realtime|offline      offline renders unpaced from a fake clock\n"
+              << "  decode-threads <n>   fps <target>   loudness on|off\n"
+              << "  governor on|off            scale quality to hold the target fps (off)\n"
+              << "  pcm-format float|int16|float16   how decoded audio is held in memory (float)\n"
+              << "  post on|off                trails and bloom on the scenes that use them (off)\n"
+              << "  idle on|off                pause redraws and analysis while the input is silent (off)\n"
+              << "  overview off|on|cached     track overview strip; cached keeps it in <file>.mpvw (off)\n"
+              << "  audio-thread|analysis-thread|render-thread|decode-thread <normal|fifo|rr>[:prio][@cpus]\n"
+              << "                             scheduling and affinity per thread role (e.g. fifo:80@3)\n"
+              << "  lock-memory on|off         mlockall() once audio is loaded\n"
+              << "  hot-reload on|off          relink shaders when their sources are edited (off)\n"
+              << "  shared-memory <name>       publish frames to a shared-memory ring (e.g. /mpv_spectrum)\n"
+              << "  record <trace>   replay <trace>" << std::endl;
+}
@@ -0,0 +1,66 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include "Renderer.h"
+#include "../audio/FFTProcessor.h"
+#include "../audio/PcmStore.h"
+#include "../audio/StreamReader.h"
+#include "../audio/ThreadRoles.h"
+#include "../audio/WaveformPyramid.h"
+#include "visualizations/BaseVisualization.h"
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+enum class RunMode {
+    Realtime,  // play through PortAudio, paced by the display
+    Offline    // drive the callback from a fake clock and render unpaced
+};
+
+// Everything needed to build a session. Defaults match the interactive
+// app; the input file and scenes are prompted for when left empty.
+struct AppConfig {
+    AppConfig();
+
+    std::string input;               // "-" or a FIFO is played as a live stream
+    std::string playlist;             // file listing tracks to play gaplessly
+    std::vector<std::string> scenes;  // registry names or menu numbers
+    SceneLayout layout;
+    size_t fftSize;                   // starting size; the governor may change it
+    size_t hop;                       // audio callback block size
+    WindowFunction window;
+    FFTBackend fftBackend;
+    BandScale bandScale;
+    bool vsync;
+    int width, height;
+    RunMode mode;
+    size_t decodeThreads;
+    PcmFormat pcmFormat;
+    double targetFps;
+    bool governor;
+    bool loudness;
+    bool postEffects;                 // trails and bloom for the scenes that use them
+    bool idle;                        // stop redrawing through silence once the picture is still
+    OverviewMode overview;
+    std::array<ThreadPolicy, THREAD_ROLE_COUNT> threadPolicies;  // indexed by ThreadRole
+    bool lockMemory;
+    bool hotReload;                   // relink shaders edited while running
+    RawPcmFormat rawPcm;              // headerless stream input; channels 0 to sniff the format
+    double streamBuffer;              // seconds a live stream may be decoded ahead
+    std::string sharedMemory;         // shared spectrum ring name; empty to disable
+    std::string recordTrace;
+    std::string replayTrace;
+};
+
+// Reads "--key value" or "--key=value" arguments. "--config <file>" loads
+// a file of "key = value" lines (# starts a comment) first, wherever it
+// appears, and the remaining arguments override it. Keys are the same in
+// both places.
+bool parseCommandLine(int argc, char* argv[], AppConfig& config);
+bool loadConfigFile(const std::string& path, AppConfig& config);
+// One path per line; blank lines and # comments are skipped.
+bool loadPlaylistFile(const std::string& path, std::vector<std::string>& tracks);
+void printUsage(const char* program);
+
+#endif
@@ -0,0 +1,44 @@
+#include "IdleGovernor.h"
+#include <iostream>
+
+IdleGovernor::IdleGovernor()
+    : lastSequence(0), idle(false), idleSeconds(0.0), skippedFrames(0) {}
+
+bool IdleGovernor::skip(const AnalysisFrame& frame, Renderer& renderer, const WaveformPyramid* overview) {
+    bool quiet = frame.silent || frame.sequence == lastSequence;
+    lastSequence = frame.sequence;
+    // Asked every frame, not just quiet ones, so the Renderer knows how
+    // long its scenes have been still.
+    bool settled = renderer.isSettled(frame, overview);
+
+    if (quiet && settled) {
+        if (!idle) {
+            idle = true;
+            idleSince = Clock::now();
+            std::cerr << "IDLE: nothing changing, redraws paused" << std::endl;
+        }
+        ++skippedFrames;
+        return true;
+    }
+
+    if (idle) {
+        double seconds = std::chrono::duration<double>(Clock::now() - idleSince).count();
+        idleSeconds += seconds;
+        idle = false;
+        std::cerr << "IDLE: resumed after " << seconds << " s (" << (frame.silent ? "window event" : "signal")
+                  << ")" << std::endl;
+    }
+    return false;
+}
+
+size_t IdleGovernor::getSkippedFrames() const {
+    return skippedFrames;
+}
+
+double IdleGovernor::getIdleSeconds() const {
+    double seconds = idleSeconds;
+    if (idle) {
+        seconds += std::chrono::duration<double>(Clock::now() - idleSince).count();
+    }
+    return seconds;
+}
@@ -0,0 +1,38 @@
+#ifndef IDLE_GOVERNOR_H
+#define IDLE_GOVERNOR_H
+
+#include "Renderer.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Stops redrawing while nothing would change on screen. A frame can be
+// skipped when the analysis has nothing new to show (the input is silent,
+// or no frame has been published since the last one) and the Renderer
+// reports every scene, overlay and trail as settled. The first frame with
+// signal ends the idle stretch.
+//
+// This only decides; the loop does the waiting, so it can sleep on window
+// events and the audio thread's wake-up rather than a fixed poll.
+class IdleGovernor {
+public:
+    IdleGovernor();
+
+    // Returns true when this frame needn't be drawn.
+    bool skip(const AnalysisFrame& frame, Renderer& renderer, const WaveformPyramid* overview);
+
+    size_t getSkippedFrames() const;
+    // Total time spent idle, including a stretch still under way.
+    double getIdleSeconds() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    uint64_t lastSequence;
+    bool idle;
+    Clock::time_point idleSince;
+    double idleSeconds;
+    size_t skippedFrames;
+};
+
+#endif
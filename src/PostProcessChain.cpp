@@ -0,0 +1,338 @@
+#include "PostProcessChain.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <GLFW/glfw3.h>
+
+static const double MAX_STEP = 0.25;    // seconds; longer gaps fade trails as if this long
+static const size_t MAX_BLOOM_LEVELS = 6;  // the effect size down to 1/32 of it
+static const int MIN_BLOOM_SIZE = 8;    // pixels; smaller levels add nothing but passes
+static const int MAX_EFFECT_PIXELS = 1280 * 720;  // trails and the top bloom level, at any viewport size
+static const size_t STAMPS_PER_SCENE = POST_PASS_COUNT + 1;
+
+// Indices into programs, in the order of PROGRAM_FILES.
+enum {
+    PROGRAM_TRAILS,
+    PROGRAM_DOWNSAMPLE,
+    PROGRAM_UPSAMPLE,
+    PROGRAM_COMPOSITE
+};
+
+static const char* const PROGRAM_FILES[] = {
+    "postTrailsFragmentShader.glsl",
+    "postDownsampleFragmentShader.glsl",
+    "postUpsampleFragmentShader.glsl",
+    "postCompositeFragmentShader.glsl"
+};
+
+const char* postPassName(PostPass pass) {
+    switch (pass) {
+        case PostPass::Scene: return "scene";
+        case PostPass::Trails: return "trails";
+        case PostPass::BloomDown: return "bloom down";
+        case PostPass::BloomUp: return "bloom up";
+        case PostPass::Composite: return "composite";
+    }
+    return "unknown";
+}
+
+PostProcessChain::PostProcessChain()
+    : shaders(nullptr), emptyVao(0), stampCount{}, frameSlot(0), timings{} {
+    for (PassProgram& pass : programs) {
+        pass = {INVALID_SHADER, 0, -1, -1, -1, -1, -1};
+    }
+}
+
+PostProcessChain::~PostProcessChain() {
+    cleanup();
+}
+
+bool PostProcessChain::initialize(ShaderManager* manager) {
+    shaders = manager;
+    // The full-viewport triangle from the phosphor scopes serves every pass.
+    for (size_t i = 0; i < programs.size(); ++i) {
+        programs[i].shader = shaders->load("phosphorVertexShader.glsl", PROGRAM_FILES[i]);
+        if (programs[i].shader == INVALID_SHADER) {
+            std::cerr << "ERROR: Failed to create post-processing shader programs!" << std::endl;
+            return false;
+        }
+    }
+    glGenVertexArrays(1, &emptyVao);
+    return true;
+}
+
+void PostProcessChain::lookUpUniforms() {
+    // Hot reload relinks into a new program, which invalidates locations.
+    for (PassProgram& pass : programs) {
+        GLuint current = shaders->program(pass.shader);
+        if (current == pass.program) continue;
+        pass.program = current;
+        pass.texel = glGetUniformLocation(current, "uTexel");
+        pass.decay = glGetUniformLocation(current, "uDecay");
+        pass.threshold = glGetUniformLocation(current, "uThreshold");
+        pass.bloomStrength = glGetUniformLocation(current, "uBloomStrength");
+        pass.trails = glGetUniformLocation(current, "uTrails");
+        // Texture units never change, so they are set once per link.
+        glUseProgram(current);
+        glUniform1i(glGetUniformLocation(current, "uSource"), 0);
+        glUniform1i(glGetUniformLocation(current, "uHistory"), 1);
+        glUniform1i(glGetUniformLocation(current, "uBloom"), 2);
+    }
+}
+
+void PostProcessChain::makeTarget(Target& target, int width, int height, GLenum format) {
+    if (target.texture == 0) glGenTextures(1, &target.texture);
+    if (target.framebuffer == 0) glGenFramebuffers(1, &target.framebuffer);
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    // Linear filtering does the box part of every resample for free.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+    target.width = width;
+    target.height = height;
+}
+
+bool PostProcessChain::resize(SceneTargets& targets, int width, int height) {
+    releaseTargets(targets);
+    // Recorded even on failure so a bad size isn't retried every frame.
+    targets.width = width;
+    targets.height = height;
+
+    // Scenes may use depth (the terrain does), so the target has its own.
+    makeTarget(targets.scene, width, height, GL_RGBA8);
+    glGenRenderbuffers(1, &targets.depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, targets.depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, targets.depthBuffer);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    // Packed float: four bytes a pixel like RGBA8, but faded trails and
+    // summed bloom levels neither band nor clip.
+    // Half size, or less on big viewports so the effect passes cost no
+    // more at 4K than at 1440p.
+    int effectWidth = std::max(1, width / 2), effectHeight = std::max(1, height / 2);
+    while (effectWidth * effectHeight > MAX_EFFECT_PIXELS) {
+        effectWidth = std::max(1, effectWidth / 2);
+        effectHeight = std::max(1, effectHeight / 2);
+    }
+    if (targets.effects.trailSeconds > 0.0f) {
+        for (Target& trail : targets.trails) {
+            makeTarget(trail, effectWidth, effectHeight, GL_R11F_G11F_B10F);
+            complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        targets.trailIndex = 0;
+    }
+    if (targets.effects.bloom > 0.0f) {
+        int levelWidth = effectWidth, levelHeight = effectHeight;
+        while (targets.bloom.size() < MAX_BLOOM_LEVELS &&
+               (targets.bloom.empty() || std::min(levelWidth, levelHeight) >= MIN_BLOOM_SIZE)) {
+            targets.bloom.emplace_back();
+            makeTarget(targets.bloom.back(), levelWidth, levelHeight, GL_R11F_G11F_B10F);
+            complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+            levelWidth = std::max(1, levelWidth / 2);
+            levelHeight = std::max(1, levelHeight / 2);
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (!complete) {
+        std::cerr << "ERROR: Post-processing targets for a " << width << "x" << height
+                  << " scene are incomplete; drawing it without effects." << std::endl;
+        releaseTargets(targets);
+        return false;
+    }
+    return true;
+}
+
+void PostProcessChain::releaseTargets(SceneTargets& targets) {
+    std::vector<Target*> all = {&targets.scene, &targets.trails[0], &targets.trails[1]};
+    for (Target& level : targets.bloom) {
+        all.push_back(&level);
+    }
+    for (Target* target : all) {
+        if (target->framebuffer != 0) glDeleteFramebuffers(1, &target->framebuffer);
+        if (target->texture != 0) glDeleteTextures(1, &target->texture);
+        *target = Target();
+    }
+    targets.bloom.clear();
+    if (targets.depthBuffer != 0) glDeleteRenderbuffers(1, &targets.depthBuffer);
+    targets.depthBuffer = 0;
+}
+
+void PostProcessChain::stamp() {
+    std::vector<GLuint>& slot = stamps[frameSlot];
+    size_t& count = stampCount[frameSlot];
+    if (count == slot.size()) {
+        GLuint query = 0;
+        glGenQueries(1, &query);
+        slot.push_back(query);
+    }
+    glQueryCounter(slot[count++], GL_TIMESTAMP);
+}
+
+void PostProcessChain::beginFrame() {
+    frameSlot = (frameSlot + 1) % GPU_FRAMES;
+    std::vector<GLuint>& slot = stamps[frameSlot];
+    size_t count = stampCount[frameSlot];
+    stampCount[frameSlot] = 0;
+
+    // Reading a result that isn't back would wait for the GPU, so a late
+    // frame is skipped instead; the last good timings stay.
+    GLint available = count > 0 ? GL_TRUE : GL_FALSE;
+    if (count > 0) glGetQueryObjectiv(slot[count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        if (count == 0) timings.fill(0.0);
+        return;
+    }
+
+    timings.fill(0.0);
+    std::vector<GLuint64> times(count);
+    for (size_t i = 0; i < count; ++i) {
+        glGetQueryObjectui64v(slot[i], GL_QUERY_RESULT, &times[i]);
+    }
+    for (size_t scene = 0; scene + STAMPS_PER_SCENE <= count; scene += STAMPS_PER_SCENE) {
+        for (size_t pass = 0; pass < POST_PASS_COUNT; ++pass) {
+            timings[pass] += (times[scene + pass + 1] - times[scene + pass]) / 1e6;
+        }
+    }
+}
+
+bool PostProcessChain::begin(size_t scene, int x, int y, int width, int height, const PostEffects& effects) {
+    bool trails = effects.trailSeconds > 0.0f, bloom = effects.bloom > 0.0f;
+    if (programs[PROGRAM_COMPOSITE].shader == INVALID_SHADER || (!trails && !bloom) || width <= 0 || height <= 0) return false;
+
+    if (sceneTargets.size() <= scene) sceneTargets.resize(scene + 1);
+    SceneTargets& targets = sceneTargets[scene];
+    bool missing = (trails && targets.trails[0].texture == 0) || (bloom && targets.bloom.empty());
+    targets.effects = effects;
+    if (width != targets.width || height != targets.height || (missing && targets.scene.texture != 0)) {
+        if (!resize(targets, width, height)) return false;
+        targets.lastTime = glfwGetTime();
+    }
+    if (targets.scene.texture == 0) return false;
+
+    targets.x = x;
+    targets.y = y;
+    stamp();
+    glBindFramebuffer(GL_FRAMEBUFFER, targets.scene.framebuffer);
+    glViewport(0, 0, width, height);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    return true;
+}
+
+void PostProcessChain::drawPass(const Target& destination, const Target& source, size_t program) {
+    glBindFramebuffer(GL_FRAMEBUFFER, destination.framebuffer);
+    glViewport(0, 0, destination.width, destination.height);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, source.texture);
+    glUseProgram(programs[program].program);
+    glUniform2f(programs[program].texel, 1.0f / source.width, 1.0f / source.height);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+void PostProcessChain::end(size_t scene) {
+    SceneTargets& targets = sceneTargets[scene];
+    const PostEffects& effects = targets.effects;
+    stamp();
+
+    lookUpUniforms();
+    glBindVertexArray(emptyVao);
+    glDisable(GL_BLEND);
+
+    // Trails: the fresh frame at the effect size, or what is left of the
+    // last trail where that is brighter.
+    const Target* trail = nullptr;
+    if (effects.trailSeconds > 0.0f) {
+        double now = glfwGetTime();
+        double elapsed = std::min(MAX_STEP, now - targets.lastTime);
+        targets.lastTime = now;
+        const Target& previous = targets.trails[targets.trailIndex];
+        targets.trailIndex ^= 1;
+        trail = &targets.trails[targets.trailIndex];
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, previous.texture);
+        glUseProgram(programs[PROGRAM_TRAILS].program);
+        glUniform1f(programs[PROGRAM_TRAILS].decay, static_cast<float>(std::exp(-elapsed / effects.trailSeconds)));
+        drawPass(*trail, targets.scene, PROGRAM_TRAILS);
+    }
+    stamp();
+
+    // Bloom from the trail when there is one: it is already small and
+    // lets the trails glow too. Each level is added back into the next
+    // larger on the way up, so the top level ends up holding every scale.
+    const std::vector<Target>& bloom = targets.bloom;
+    if (effects.bloom > 0.0f) {
+        // The first step is also the bright pass; a zero threshold makes
+        // the same program a plain downsample.
+        const PassProgram& down = programs[PROGRAM_DOWNSAMPLE];
+        glUseProgram(down.program);
+        glUniform1f(down.threshold, effects.bloomThreshold);
+        drawPass(bloom[0], trail ? *trail : targets.scene, PROGRAM_DOWNSAMPLE);
+        glUniform1f(down.threshold, 0.0f);
+        for (size_t i = 1; i < bloom.size(); ++i) {
+            drawPass(bloom[i], bloom[i - 1], PROGRAM_DOWNSAMPLE);
+        }
+        stamp();
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        for (size_t i = bloom.size() - 1; i > 0; --i) {
+            drawPass(bloom[i - 1], bloom[i], PROGRAM_UPSAMPLE);
+        }
+        glDisable(GL_BLEND);
+    } else {
+        stamp();
+    }
+    stamp();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(targets.x, targets.y, targets.width, targets.height);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, trail ? trail->texture : 0);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, effects.bloom > 0.0f ? bloom[0].texture : 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, targets.scene.texture);
+    const PassProgram& composite = programs[PROGRAM_COMPOSITE];
+    glUseProgram(composite.program);
+    glUniform1i(composite.trails, trail ? 1 : 0);
+    glUniform1f(composite.bloomStrength, effects.bloom);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    for (GLenum unit : {GL_TEXTURE2, GL_TEXTURE1, GL_TEXTURE0}) {
+        glActiveTexture(unit);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glBindVertexArray(0);
+    stamp();
+}
+
+const PostTimings& PostProcessChain::getTimings() const {
+    return timings;
+}
+
+void PostProcessChain::cleanup() {
+    for (SceneTargets& targets : sceneTargets) {
+        releaseTargets(targets);
+    }
+    sceneTargets.clear();
+    for (size_t i = 0; i < GPU_FRAMES; ++i) {
+        if (!stamps[i].empty()) glDeleteQueries(static_cast<GLsizei>(stamps[i].size()), stamps[i].data());
+        stamps[i].clear();
+        stampCount[i] = 0;
+    }
+    if (emptyVao != 0) glDeleteVertexArrays(1, &emptyVao);
+    emptyVao = 0;
+    // The programs belong to the shader manager.
+    for (PassProgram& pass : programs) {
+        pass.shader = INVALID_SHADER;
+        pass.program = 0;
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef POST_PROCESS_CHAIN_H
+#define POST_PROCESS_CHAIN_H
+
+#include "ShaderUtils.h"
+#include "visualizations/BaseVisualization.h"
+#include <array>
+#include <cstddef>
+#include <vector>
+#include <GL/glew.h>
+
+enum class PostPass {
+    Scene,      // the scene itself, drawn into its offscreen target
+    Trails,     // feedback: fade last frame's trail and keep the brighter
+    BloomDown,  // bright pass and the downsampling half of the blur
+    BloomUp,    // upsampling half, each level added into the next larger
+    Composite   // everything back into the window at full resolution
+};
+
+const size_t POST_PASS_COUNT = 5;
+typedef std::array<double, POST_PASS_COUNT> PostTimings;  // milliseconds, indexed by PostPass
+
+const char* postPassName(PostPass pass);
+
+// Glow and motion trails for the scenes that ask for them (see
+// BaseVisualization::postEffects). Such a scene draws into an offscreen
+// target the size of its viewport instead of the window; end() then runs
+// the passes and composites the result into the viewport.
+//
+// Only the scene target and the composite are full resolution. Trails
+// ping-pong between two half-resolution textures, and bloom is a dual
+// filter (Kawase-style blur folded into the resampling) over a chain that
+// starts at the same size and halves up to five times. Past 1280x720 of
+// effect pixels the start drops to a quarter, so the effect passes cost
+// the same at 4K as at 1440p and only the scene and composite grow.
+//
+// Pass times come from GPU timestamps read back a few frames later, so
+// measuring never stalls the pipeline.
+class PostProcessChain {
+public:
+    PostProcessChain();
+    ~PostProcessChain();
+
+    bool initialize(ShaderManager* manager);
+    void cleanup();
+
+    // Once per frame before any scene; collects finished timestamps.
+    void beginFrame();
+
+    // Returns false, drawing nothing, when the scene wants no effects or
+    // its targets can't be made; the caller then draws straight into the
+    // window. Otherwise the scene's target is bound and cleared, and the
+    // viewport is set to cover it.
+    bool begin(size_t scene, int x, int y, int width, int height, const PostEffects& effects);
+    // Leaves the window framebuffer bound with the scene's viewport.
+    void end(size_t scene);
+
+    // Summed over scenes, for the most recent frame whose timestamps are
+    // back; all zero until then or when no scene uses the chain.
+    const PostTimings& getTimings() const;
+
+private:
+    struct Target {
+        GLuint framebuffer = 0;
+        GLuint texture = 0;
+        int width = 0, height = 0;
+    };
+
+    struct SceneTargets {
+        Target scene;
+        GLuint depthBuffer = 0;
+        Target trails[2];
+        size_t trailIndex = 0;  // the trail written last frame
+        std::vector<Target> bloom;
+        int width = 0, height = 0;
+        int x = 0, y = 0;
+        PostEffects effects = {0.0f, 0.0f, 0.0f};
+        double lastTime = 0.0;
+    };
+
+    bool resize(SceneTargets& targets, int width, int height);
+    void makeTarget(Target& target, int width, int height, GLenum format);
+    void releaseTargets(SceneTargets& targets);
+    void lookUpUniforms();
+    void drawPass(const Target& destination, const Target& source, size_t program);
+    void stamp();
+
+    // One small program per pass rather than one switching on a uniform:
+    // software rasterizers run every branch of such a shader.
+    struct PassProgram {
+        ShaderHandle shader;
+        GLuint program;  // the program the uniform locations belong to
+        GLint texel, decay, threshold, bloomStrength, trails;
+    };
+
+    ShaderManager* shaders;
+    std::array<PassProgram, 4> programs;  // trails, downsample, upsample, composite
+    GLuint emptyVao;
+    std::vector<SceneTargets> sceneTargets;
+
+    // GPU_FRAMES sets of timestamps in flight; the oldest is read back
+    // when its slot comes round again.
+    static const size_t GPU_FRAMES = 3;
+    std::vector<GLuint> stamps[GPU_FRAMES];
+    size_t stampCount[GPU_FRAMES];
+    size_t frameSlot;
+    PostTimings timings;
+};
+
+#endif
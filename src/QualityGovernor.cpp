@@ -0,0 +1,90 @@
+#include "QualityGovernor.h"
+#include <algorithm>
+#include <iostream>
+
+static const double SMOOTHING = 0.1;
+static const double DOWNGRADE_RATIO = 0.9;   // of budget
+static const double UPGRADE_RATIO = 0.5;
+static const size_t DOWNGRADE_FRAMES = 30;
+static const size_t BASE_UPGRADE_FRAMES = 180;
+static const size_t MAX_UPGRADE_FRAMES = 180 * 16;
+static const size_t COOLDOWN_FRAMES = 60;
+
+QualityGovernor::QualityGovernor(double targetFps)
+    : budget(1.0 / targetFps), overBudgetFrames(0), underBudgetFrames(0),
+      cooldownFrames(0), upgradeDelay(BASE_UPGRADE_FRAMES), lastChangeWasUpgrade(false) {
+    // Lowest to highest. DEFAULT_QUALITY is the starting point.
+    levels = {
+        {512, 32, 16, 64, 131072, 128},
+        {1024, 48, 32, 128, 196608, 256},
+        DEFAULT_QUALITY,
+        {2048, 96, 96, 360, 524288, 512},
+        {4096, 128, 128, 720, 1048576, 512},
+    };
+    level = 2;
+    averageFrame = budget * UPGRADE_RATIO;
+}
+
+bool QualityGovernor::recordFrame(double frameSeconds) {
+    averageFrame += SMOOTHING * (frameSeconds - averageFrame);
+
+    if (cooldownFrames > 0) {
+        --cooldownFrames;
+        return false;
+    }
+
+    if (averageFrame > budget * DOWNGRADE_RATIO) {
+        underBudgetFrames = 0;
+        if (++overBudgetFrames >= DOWNGRADE_FRAMES && level > 0) {
+            // Falling straight back after a climb means the climb was wrong;
+            // wait longer before trying it again.
+            if (lastChangeWasUpgrade) {
+                upgradeDelay = std::min(upgradeDelay * 2, MAX_UPGRADE_FRAMES);
+            }
+            lastChangeWasUpgrade = false;
+            changeLevel(level - 1, "over budget");
+            return true;
+        }
+    } else if (averageFrame < budget * UPGRADE_RATIO) {
+        overBudgetFrames = 0;
+        if (++underBudgetFrames >= upgradeDelay && level + 1 < levels.size()) {
+            lastChangeWasUpgrade = true;
+            changeLevel(level + 1, "headroom");
+            return true;
+        }
+    } else {
+        overBudgetFrames = 0;
+        underBudgetFrames = 0;
+    }
+    return false;
+}
+
+void QualityGovernor::changeLevel(size_t newLevel, const char* reason) {
+    const QualitySettings& next = levels[newLevel];
+    std::cerr << "QUALITY: level " << level << " -> " << newLevel << " (" << reason
+              << ", avg frame " << averageFrame * 1000.0 << " ms, budget " << budget * 1000.0 << " ms)"
+              << ": fft " << next.fftSize << ", bars " << next.barCount << ", rings " << next.ringCount
+              << ", segments " << next.circleSegments << ", particles " << next.particleCount
+              << ", terrain " << next.terrainSize << std::endl;
+
+    level = newLevel;
+    overBudgetFrames = 0;
+    underBudgetFrames = 0;
+    cooldownFrames = COOLDOWN_FRAMES;
+}
+
+const QualitySettings& QualityGovernor::getSettings() const {
+    return levels[level];
+}
+
+std::vector<size_t> QualityGovernor::getFftSizes() const {
+    std::vector<size_t> sizes;
+    for (const QualitySettings& settings : levels) {
+        sizes.push_back(settings.fftSize);
+    }
+    return sizes;
+}
+
+size_t QualityGovernor::getLevel() const {
+    return level;
+}
@@ -0,0 +1,43 @@
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+#include "visualizations/BaseVisualization.h"
+#include <cstddef>
+#include <vector>
+
+// Watches frame times and steps a ladder of QualitySettings up or down to
+// hold a frame budget.
+//
+// Dropping a level needs a sustained overrun; climbing back needs a longer
+// stretch well under budget, and that stretch doubles each time a climb has
+// to be undone, so a box that sits right at the edge settles instead of
+// oscillating between two levels.
+class QualityGovernor {
+public:
+    QualityGovernor(double targetFps);
+
+    // Returns true when the level changed and getSettings() should be applied.
+    bool recordFrame(double frameSeconds);
+
+    const QualitySettings& getSettings() const;
+    // Every FFT size the ladder can switch to, so they can be planned
+    // before the first switch.
+    std::vector<size_t> getFftSizes() const;
+    size_t getLevel() const;
+
+private:
+    void changeLevel(size_t newLevel, const char* reason);
+
+    std::vector<QualitySettings> levels;
+    size_t level;
+    double budget;
+    double averageFrame;
+
+    size_t overBudgetFrames;
+    size_t underBudgetFrames;
+    size_t cooldownFrames;
+    size_t upgradeDelay;
+    bool lastChangeWasUpgrade;
+};
+
+#endif
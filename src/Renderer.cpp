@@ -0,0 +1,309 @@
+#include "Renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+static const int OVERLAY_WIDTH = 96;
+static const int OVERVIEW_HEIGHT = 80;
+// Trails fade by exp(-t / trailSeconds); this many of them leaves less
+// than an 8-bit step.
+static const double TRAIL_FADES = 6.0;
+
+Renderer::Renderer()
+    : window(nullptr), defaultShader(INVALID_SHADER), layout(SceneLayout::Grid),
+      framebufferWidth(0), framebufferHeight(0), layoutDirty(true), damaged(true),
+      settledSince(0.0), frameWorkTime(0.0), frameTiming(false),
+      overlayViewport{0, 0, 0, 0}, showLoudness(false), overviewViewport{0, 0, 0, 0}, showOverview(false),
+      postProcessing(false) {}
+
+Renderer::~Renderer() {
+    cleanup();
+}
+
+void Renderer::framebufferSizeCallback(GLFWwindow* window, int width, int height) {
+    Renderer* renderer = static_cast<Renderer*>(glfwGetWindowUserPointer(window));
+    renderer->framebufferWidth = width;
+    renderer->framebufferHeight = height;
+    renderer->layoutDirty = true;
+}
+
+void Renderer::windowRefreshCallback(GLFWwindow* window) {
+    Renderer* renderer = static_cast<Renderer*>(glfwGetWindowUserPointer(window));
+    renderer->damaged = true;
+}
+
+bool Renderer::initialize(int windowWidth, int windowHeight, const char* title) {
+    if (!glfwInit()) {
+        std::cerr << "Failed to initialize GLFW." << std::endl;
+        return false;
+    }
+
+    window = glfwCreateWindow(windowWidth, windowHeight, title, nullptr, nullptr);
+    if (!window) {
+        std::cerr << "Failed to create GLFW window." << std::endl;
+        glfwTerminate();
+        return false;
+    }
+
+    glfwMakeContextCurrent(window);
+    // Analysis runs on its own thread now, so the display paces the loop.
+    glfwSwapInterval(1);
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK) {
+        std::cerr << "Failed to initialize GLEW." << std::endl;
+        return false;
+    }
+
+    glfwSetWindowUserPointer(window, this);
+    glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+    glfwSetWindowRefreshCallback(window, windowRefreshCallback);
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    // Every scene draws with the same program, so it is compiled once here
+    // instead of once per visualization.
+    shaders.initialize(window);
+    defaultShader = shaders.load("vertexShader.glsl", "fragmentShader.glsl");
+    if (defaultShader == INVALID_SHADER) {
+        std::cerr << "ERROR: Failed to create shader program!" << std::endl;
+        return false;
+    }
+
+    if (!loudnessOverlay.initialize() || !overviewStrip.initialize() || !postChain.initialize(&shaders)) {
+        return false;
+    }
+
+    return true;
+}
+
+void Renderer::setShaderHotReload(bool enabled) {
+    shaders.setHotReload(enabled);
+}
+
+bool Renderer::addScene(std::unique_ptr<BaseVisualization> scene) {
+    if (!window) {
+        std::cerr << "ERROR: Renderer must be initialized before adding scenes." << std::endl;
+        return false;
+    }
+    scene->setShaderManager(&shaders);
+    if (!scene->initialize()) {
+        return false;
+    }
+    scenes.push_back(std::move(scene));
+    layoutDirty = true;
+    return true;
+}
+
+void Renderer::setLayout(SceneLayout newLayout) {
+    layout = newLayout;
+    layoutDirty = true;
+}
+
+void Renderer::setQuality(const QualitySettings& settings) {
+    for (auto& scene : scenes) {
+        scene->setQuality(settings);
+    }
+}
+
+void Renderer::setBandScale(BandScale scale) {
+    for (auto& scene : scenes) {
+        scene->setBandScale(scale);
+    }
+}
+
+void Renderer::setVsync(bool enabled) {
+    glfwSwapInterval(enabled ? 1 : 0);
+}
+
+void Renderer::setPostProcessing(bool enabled) {
+    postProcessing = enabled;
+}
+
+void Renderer::setLoudnessOverlay(bool enabled) {
+    showLoudness = enabled;
+    layoutDirty = true;
+}
+
+void Renderer::setOverviewStrip(bool enabled) {
+    showOverview = enabled;
+    layoutDirty = true;
+}
+
+void Renderer::updateLayout() {
+    viewports.clear();
+
+    // The meter strip takes a fixed column on the right; scenes share the rest.
+    int sceneWidth = framebufferWidth;
+    if (showLoudness) {
+        sceneWidth = std::max(0, framebufferWidth - OVERLAY_WIDTH);
+        overlayViewport = {sceneWidth, 0, framebufferWidth - sceneWidth, framebufferHeight};
+    }
+    // The overview takes a fixed row along the bottom of the scene area.
+    int sceneBottom = 0;
+    if (showOverview) {
+        sceneBottom = std::min(OVERVIEW_HEIGHT, framebufferHeight);
+        overviewViewport = {0, 0, sceneWidth, sceneBottom};
+    }
+    int sceneHeight = framebufferHeight - sceneBottom;
+
+    size_t count = scenes.size();
+    if (count == 0) {
+        layoutDirty = false;
+        return;
+    }
+
+    size_t columns = 1, rows = 1;
+    switch (layout) {
+        case SceneLayout::Grid:
+            columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+            rows = (count + columns - 1) / columns;
+            break;
+        case SceneLayout::Horizontal:
+            columns = count;
+            break;
+        case SceneLayout::Vertical:
+            rows = count;
+            break;
+    }
+
+    int cellWidth = sceneWidth / static_cast<int>(columns);
+    int cellHeight = sceneHeight / static_cast<int>(rows);
+    for (size_t i = 0; i < count; ++i) {
+        int column = static_cast<int>(i % columns);
+        int row = static_cast<int>(i / columns);
+        // GL viewports are anchored bottom-left; fill rows from the top.
+        int y = framebufferHeight - (row + 1) * cellHeight;
+        viewports.push_back({column * cellWidth, y, cellWidth, cellHeight});
+    }
+    layoutDirty = false;
+}
+
+void Renderer::renderFrame(const AnalysisFrame& frame, const WaveformPyramid* overview) {
+    double frameStart = glfwGetTime();
+
+    if (layoutDirty) {
+        updateLayout();
+    }
+    damaged = false;
+
+    // Pick up programs relinked by the shader watcher since the last frame.
+    shaders.update();
+
+    glViewport(0, 0, framebufferWidth, framebufferHeight);
+    glClear(GL_COLOR_BUFFER_BIT);
+    GLuint defaultProgram = shaders.program(defaultShader);
+    if (postProcessing) {
+        postChain.beginFrame();
+    }
+
+    for (size_t i = 0; i < scenes.size(); ++i) {
+        // A scene with effects draws into its own target, which the chain
+        // then composites into the viewport.
+        const Viewport& viewport = viewports[i];
+        bool post = postProcessing && postChain.begin(i, viewport.x, viewport.y, viewport.width, viewport.height,
+                                                      scenes[i]->postEffects());
+        if (!post) {
+            glViewport(viewport.x, viewport.y, viewport.width, viewport.height);
+        }
+        glUseProgram(defaultProgram);
+        scenes[i]->update(frame);
+        scenes[i]->render(frame.magnitudes);
+        if (post) {
+            postChain.end(i);
+        }
+    }
+
+    if (showLoudness) {
+        glUseProgram(defaultProgram);
+        glViewport(overlayViewport.x, overlayViewport.y, overlayViewport.width, overlayViewport.height);
+        loudnessOverlay.render(frame.loudness);
+    }
+
+    if (showOverview && overview) {
+        glUseProgram(defaultProgram);
+        glViewport(overviewViewport.x, overviewViewport.y, overviewViewport.width, overviewViewport.height);
+        overviewStrip.render(*overview, frame.samplePosition, overviewViewport.width);
+    }
+
+    // Wait for the GPU here so the measured time covers the frame's real
+    // cost but not the vsync wait inside the swap. The wait stalls the
+    // pipeline, so only when someone reads the number.
+    if (frameTiming) {
+        glFinish();
+    }
+    frameWorkTime = glfwGetTime() - frameStart;
+
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+}
+
+bool Renderer::shouldClose() {
+    return glfwWindowShouldClose(window);
+}
+
+bool Renderer::isSettled(const AnalysisFrame& frame, const WaveformPyramid* overview) {
+    double now = glfwGetTime();
+    bool settled = !damaged && !layoutDirty;
+    for (const auto& scene : scenes) {
+        settled = settled && scene->isSettled();
+    }
+    settled = settled && (!showLoudness || loudnessOverlay.isSettled(frame.loudness));
+    settled = settled && (!showOverview || !overview ||
+                          overviewStrip.isSettled(*overview, frame.samplePosition, overviewViewport.width));
+    if (!settled) {
+        settledSince = now;
+        return false;
+    }
+
+    // A still scene keeps changing on screen while its old trail fades.
+    if (postProcessing) {
+        for (const auto& scene : scenes) {
+            if (now - settledSince < TRAIL_FADES * scene->postEffects().trailSeconds) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void Renderer::waitEvents(double seconds) {
+    glfwWaitEventsTimeout(seconds);
+}
+
+void Renderer::wake() {
+    glfwPostEmptyEvent();
+}
+
+double Renderer::getFrameWorkTime() const {
+    return frameWorkTime;
+}
+
+void Renderer::setFrameTiming(bool enabled) {
+    frameTiming = enabled;
+}
+
+const PostTimings& Renderer::getPostTimings() const {
+    return postChain.getTimings();
+}
+
+void Renderer::cleanup() {
+    if (!window) return;
+
+    // Scenes release their buffers while the context is still current.
+    for (auto& scene : scenes) {
+        scene->cleanup();
+    }
+    scenes.clear();
+    viewports.clear();
+    loudnessOverlay.cleanup();
+    overviewStrip.cleanup();
+    postChain.cleanup();
+
+    shaders.shutdown();
+    defaultShader = INVALID_SHADER;
+
+    glfwDestroyWindow(window);
+    window = nullptr;
+    glfwTerminate();
+}
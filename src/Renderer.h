@@ -0,0 +1,103 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include "PostProcessChain.h"
+#include "ShaderUtils.h"
+#include "../audio/AnalysisFrame.h"
+#include "visualizations/BaseVisualization.h"
+#include "visualizations/LoudnessOverlay.h"
+#include "visualizations/OverviewStrip.h"
+#include <memory>
+#include <vector>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+enum class SceneLayout {
+    Grid,        // near-square grid, filled row by row from the top left
+    Horizontal,  // side by side
+    Vertical     // stacked top to bottom
+};
+
+struct Viewport {
+    int x, y, width, height;
+};
+
+// Owns the window and GL context and composites any number of
+// visualizations into it, each in its own viewport. Per-frame state that
+// every scene shares (clear, program, swap, event poll) is done once.
+class Renderer {
+public:
+    Renderer();
+    ~Renderer();
+
+    bool initialize(int windowWidth, int windowHeight, const char* title);
+    // Relink shaders when their sources change on disk; off by default.
+    // Call before initialize().
+    void setShaderHotReload(bool enabled);
+    bool addScene(std::unique_ptr<BaseVisualization> scene);
+    void setLayout(SceneLayout layout);
+    void setLoudnessOverlay(bool enabled);
+    // Reserves a strip under the scenes for the track overview.
+    void setOverviewStrip(bool enabled);
+    void setQuality(const QualitySettings& settings);
+    void setBandScale(BandScale scale);
+    // On by default; trace replay turns it off so frames aren't paced.
+    void setVsync(bool enabled);
+    // Trails and bloom for the scenes that ask for them; off by default.
+    void setPostProcessing(bool enabled);
+
+    // The overview's playhead is frame.samplePosition, so it stays in step
+    // with the scenes; the strip is left blank when overview is null.
+    void renderFrame(const AnalysisFrame& frame, const WaveformPyramid* overview = nullptr);
+    bool shouldClose();
+
+    // True when rendering this frame would put the same picture on screen
+    // as the last one: every scene and overlay has settled, any trails
+    // have faded, and the window hasn't been resized or uncovered since.
+    bool isSettled(const AnalysisFrame& frame, const WaveformPyramid* overview = nullptr);
+    // Sleeps until a window event, a wake() or the timeout, instead of
+    // rendering; handles the events like renderFrame does.
+    void waitEvents(double seconds);
+    // Ends a waitEvents early. Safe to call from any thread.
+    static void wake();
+
+    // CPU plus GPU time of the last frame, excluding the wait for vsync.
+    // Only CPU time unless setFrameTiming(true), since counting the GPU
+    // means waiting for it at the end of every frame.
+    double getFrameWorkTime() const;
+    // For the governor, trace recording and the offline and replay
+    // summaries; off by default.
+    void setFrameTiming(bool enabled);
+    // GPU time of each post-processing pass, summed over scenes, from a
+    // frame or two back.
+    const PostTimings& getPostTimings() const;
+    void cleanup();
+
+private:
+    static void framebufferSizeCallback(GLFWwindow* window, int width, int height);
+    static void windowRefreshCallback(GLFWwindow* window);
+    void updateLayout();
+
+    GLFWwindow* window;
+    ShaderManager shaders;
+    ShaderHandle defaultShader;
+    std::vector<std::unique_ptr<BaseVisualization>> scenes;
+    std::vector<Viewport> viewports;
+    SceneLayout layout;
+    int framebufferWidth, framebufferHeight;
+    bool layoutDirty;
+    bool damaged;  // the window needs redrawing whatever the scenes say
+    double settledSince;
+    double frameWorkTime;
+    bool frameTiming;
+    LoudnessOverlay loudnessOverlay;
+    Viewport overlayViewport;
+    bool showLoudness;
+    OverviewStrip overviewStrip;
+    Viewport overviewViewport;
+    bool showOverview;
+    PostProcessChain postChain;
+    bool postProcessing;
+};
+
+#endif
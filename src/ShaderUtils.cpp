@@ -1,11 +1,25 @@
 #include "ShaderUtils.h"
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
+#include <map>
 #include <sstream>
 #include <string>
 
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static const uint32_t CACHE_MAGIC = 0x5356504D;  // "MPVS"
+
 // ✅ Function to load a shader file into a string
 std::string loadShaderSource(const char* filePath) {
     std::ifstream shaderFile(filePath);
@@ -32,29 +46,269 @@ GLuint compileShader(GLenum type, const char* source) {
         char infoLog[512];
         glGetShaderInfoLog(shader, 512, nullptr, infoLog);
         std::cerr << "ERROR: Shader Compilation Failed\n" << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
     }
 
     return shader;
 }
 
-GLuint createShaderProgram(const char* vertexPath, const char* fragmentPath) {
-    std::cerr << "DEBUG: Loading Vertex Shader: " << vertexPath << std::endl;
-    std::cerr << "DEBUG: Loading Fragment Shader: " << fragmentPath << std::endl;
-    std::string vertexCode = loadShaderSource(vertexPath);
-    std::string fragmentCode = loadShaderSource(fragmentPath);
+// FNV-1a, only used to name cache files.
+static uint64_t hashString(const std::string& data, uint64_t hash = 0xcbf29ce484222325ULL) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static std::string glString(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+ShaderManager::ShaderManager()
+    : shaderDirectory("visualizations"), cacheDirectory("shader_cache"), hotReload(false),
+      binaryCacheSupported(false), reloadContext(nullptr), watching(false) {}
+
+ShaderManager::~ShaderManager() {
+    shutdown();
+}
+
+void ShaderManager::setShaderDirectory(const std::string& directory) {
+    shaderDirectory = directory;
+}
+
+void ShaderManager::setCacheDirectory(const std::string& directory) {
+    cacheDirectory = directory;
+}
+
+void ShaderManager::setHotReload(bool enabled) {
+    hotReload = enabled;
+}
+
+bool ShaderManager::initialize(GLFWwindow* renderWindow) {
+    driverId = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+
+    GLint binaryFormats = 0;
+    if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+    }
+    binaryCacheSupported = binaryFormats > 0;
+    if (binaryCacheSupported) {
+        std::error_code ec;
+        fs::create_directories(cacheDirectory, ec);
+        if (ec) {
+            std::cerr << "WARNING: Shader cache disabled, cannot create " << cacheDirectory << std::endl;
+            binaryCacheSupported = false;
+        }
+    }
+
+    if (!hotReload) {
+        return true;
+    }
+
+    // Relinking happens on a hidden window whose context shares objects with
+    // the render context. GLFW windows must be created on the main thread.
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    reloadContext = glfwCreateWindow(1, 1, "", nullptr, renderWindow);
+    glfwDefaultWindowHints();
+    if (!reloadContext) {
+        std::cerr << "WARNING: Shader hot reload disabled, cannot create shared context." << std::endl;
+        return true;
+    }
+
+    watching = true;
+    watchThread = std::thread(&ShaderManager::watchLoop, this);
+    return true;
+}
+
+void ShaderManager::shutdown() {
+    watching = false;
+    if (watchThread.joinable()) {
+        watchThread.join();
+    }
+    if (reloadContext) {
+        glfwDestroyWindow(reloadContext);
+        reloadContext = nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    for (auto& entry : entries) {
+        GLuint pending = entry->pending.exchange(0);
+        if (pending != 0) glDeleteProgram(pending);
+        if (entry->program != 0) glDeleteProgram(entry->program);
+    }
+    entries.clear();
+}
+
+ShaderHandle ShaderManager::load(const std::string& vertexFile, const std::string& fragmentFile,
+                                 const std::vector<std::string>& feedbackVaryings) {
+    auto entry = std::make_unique<ProgramEntry>();
+    entry->vertexPath = (fs::path(shaderDirectory) / vertexFile).string();
+    if (!fragmentFile.empty()) {
+        entry->fragmentPath = (fs::path(shaderDirectory) / fragmentFile).string();
+    }
+    entry->feedbackVaryings = feedbackVaryings;
 
-    if (vertexCode.empty() || fragmentCode.empty()) {
+    entry->program = buildProgram(*entry, true);
+    if (entry->program == 0) {
+        return INVALID_SHADER;
+    }
+
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    entries.push_back(std::move(entry));
+    return entries.size() - 1;
+}
+
+GLuint ShaderManager::program(ShaderHandle handle) const {
+    return handle < entries.size() ? entries[handle]->program : 0;
+}
+
+void ShaderManager::update() {
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    for (auto& entry : entries) {
+        GLuint fresh = entry->pending.exchange(0);
+        if (fresh == 0) continue;
+
+        glDeleteProgram(entry->program);
+        entry->program = fresh;
+        std::cerr << "Reloaded shader program " << entry->vertexPath << " + " << entry->fragmentPath << std::endl;
+    }
+}
+
+std::string ShaderManager::cacheFileFor(const std::string& vertexSource, const std::string& fragmentSource,
+                                       const std::vector<std::string>& feedbackVaryings) const {
+    uint64_t hash = hashString(vertexSource);
+    hash = hashString(std::string(1, '\0') + fragmentSource, hash);
+    // Captured varyings are link state, so they are part of the binary.
+    for (const std::string& varying : feedbackVaryings) {
+        hash = hashString(std::string(1, '\0') + varying, hash);
+    }
+    hash = hashString(std::string(1, '\0') + driverId, hash);
+
+    std::ostringstream name;
+    name << std::hex << hash << ".bin";
+    return (fs::path(cacheDirectory) / name.str()).string();
+}
+
+GLuint ShaderManager::loadCachedBinary(const std::string& cacheFile) {
+    std::ifstream in(cacheFile, std::ios::binary);
+    if (!in) return 0;
+
+    uint32_t magic = 0;
+    GLenum format = 0;
+    uint32_t length = 0;
+    in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    in.read(reinterpret_cast<char*>(&format), sizeof(format));
+    in.read(reinterpret_cast<char*>(&length), sizeof(length));
+    if (!in || magic != CACHE_MAGIC || length == 0) return 0;
+
+    // A truncated or corrupt file can claim any length; never allocate
+    // more than is actually there.
+    std::streamoff header = in.tellg();
+    in.seekg(0, std::ios::end);
+    std::streamoff remaining = in.tellg() - header;
+    in.seekg(header);
+    if (!in || remaining < static_cast<std::streamoff>(length)) return 0;
+
+    std::vector<char> binary(length);
+    in.read(binary.data(), length);
+    if (!in) return 0;
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(length));
+
+    // Drivers reject binaries from other versions; fall back to compiling.
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void ShaderManager::storeCachedBinary(GLuint program, const std::string& cacheFile) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+    // Write to a temporary name first so a concurrent reader never sees a
+    // partial file.
+    std::string tempFile = cacheFile + ".tmp";
+    {
+        std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+        uint32_t size = static_cast<uint32_t>(length);
+        out.write(reinterpret_cast<const char*>(&CACHE_MAGIC), sizeof(CACHE_MAGIC));
+        out.write(reinterpret_cast<const char*>(&format), sizeof(format));
+        out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        out.write(binary.data(), length);
+        if (!out) return;
+    }
+    std::error_code ec;
+    fs::rename(tempFile, cacheFile, ec);
+}
+
+GLuint ShaderManager::buildProgram(const ProgramEntry& entry, bool useCache) {
+    const std::string& vertexPath = entry.vertexPath;
+    const std::string& fragmentPath = entry.fragmentPath;
+    bool hasFragment = !fragmentPath.empty();
+    std::string vertexCode = loadShaderSource(vertexPath.c_str());
+    std::string fragmentCode = hasFragment ? loadShaderSource(fragmentPath.c_str()) : "";
+
+    if (vertexCode.empty() || (hasFragment && fragmentCode.empty())) {
         std::cerr << "ERROR: Shader file loading failed!" << std::endl;
         return 0;
     }
 
+    std::string cacheFile;
+    if (binaryCacheSupported) {
+        cacheFile = cacheFileFor(vertexCode, fragmentCode, entry.feedbackVaryings);
+        if (useCache) {
+            GLuint cached = loadCachedBinary(cacheFile);
+            if (cached != 0) {
+                return cached;
+            }
+        }
+    }
+
+    std::cerr << "DEBUG: Compiling Vertex Shader: " << vertexPath << std::endl;
     GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexCode.c_str());
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentCode.c_str());
+    GLuint fragmentShader = 0;
+    if (hasFragment) {
+        std::cerr << "DEBUG: Compiling Fragment Shader: " << fragmentPath << std::endl;
+        fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentCode.c_str());
+    }
+    if (vertexShader == 0 || (hasFragment && fragmentShader == 0)) {
+        if (vertexShader != 0) glDeleteShader(vertexShader);
+        if (fragmentShader != 0) glDeleteShader(fragmentShader);
+        return 0;
+    }
 
     GLuint shaderProgram = glCreateProgram();
     glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
+    if (hasFragment) {
+        glAttachShader(shaderProgram, fragmentShader);
+    }
+    if (!entry.feedbackVaryings.empty()) {
+        std::vector<const char*> names;
+        for (const std::string& varying : entry.feedbackVaryings) {
+            names.push_back(varying.c_str());
+        }
+        glTransformFeedbackVaryings(shaderProgram, static_cast<GLsizei>(names.size()), names.data(),
+                                    GL_INTERLEAVED_ATTRIBS);
+    }
+    if (binaryCacheSupported) {
+        glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(shaderProgram);
+    glDeleteShader(vertexShader);
+    if (fragmentShader != 0) glDeleteShader(fragmentShader);
 
     // ✅ Check for linking errors
     GLint success;
@@ -63,10 +317,96 @@ GLuint createShaderProgram(const char* vertexPath, const char* fragmentPath) {
         char infoLog[512];
         glGetProgramInfoLog(shaderProgram, 512, nullptr, infoLog);
         std::cerr << "ERROR: Shader Program Linking Failed\n" << infoLog << std::endl;
+        glDeleteProgram(shaderProgram);
+        return 0;
     }
     std::cerr << "DEBUG: Shader Program Created Successfully: ID = " << shaderProgram << std::endl;
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
 
+    if (binaryCacheSupported) {
+        storeCachedBinary(shaderProgram, cacheFile);
+    }
     return shaderProgram;
 }
+
+void ShaderManager::relink(const std::string& changedFile) {
+    std::vector<ProgramEntry*> affected;
+    {
+        std::lock_guard<std::mutex> lock(entriesMutex);
+        for (auto& entry : entries) {
+            if (fs::path(entry->vertexPath).filename() == changedFile ||
+                fs::path(entry->fragmentPath).filename() == changedFile) {
+                affected.push_back(entry.get());
+            }
+        }
+    }
+
+    for (ProgramEntry* entry : affected) {
+        GLuint fresh = buildProgram(*entry, false);
+        if (fresh == 0) {
+            std::cerr << "ERROR: Reload of " << changedFile << " failed, keeping previous program." << std::endl;
+            continue;
+        }
+        // The render context must see a fully linked program before it
+        // can be bound there.
+        glFinish();
+        GLuint stale = entry->pending.exchange(fresh);
+        if (stale != 0) glDeleteProgram(stale);
+    }
+}
+
+void ShaderManager::watchLoop() {
+    glfwMakeContextCurrent(reloadContext);
+
+#ifdef __linux__
+    int inotifyFd = inotify_init1(IN_NONBLOCK);
+    if (inotifyFd < 0 ||
+        inotify_add_watch(inotifyFd, shaderDirectory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        std::cerr << "WARNING: Shader hot reload disabled, cannot watch " << shaderDirectory << std::endl;
+        if (inotifyFd >= 0) close(inotifyFd);
+        glfwMakeContextCurrent(nullptr);
+        return;
+    }
+
+    alignas(inotify_event) char events[4096];
+    while (watching) {
+        pollfd descriptor = {inotifyFd, POLLIN, 0};
+        if (poll(&descriptor, 1, 200) <= 0) continue;
+
+        ssize_t length = read(inotifyFd, events, sizeof(events));
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(events + offset);
+            if (event->len > 0) {
+                relink(event->name);
+            }
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+    close(inotifyFd);
+#else
+    // No inotify here; poll modification times instead.
+    std::map<std::string, fs::file_time_type> modified;
+    while (watching) {
+        std::vector<std::string> paths;
+        {
+            std::lock_guard<std::mutex> lock(entriesMutex);
+            for (auto& entry : entries) {
+                paths.push_back(entry->vertexPath);
+                if (!entry->fragmentPath.empty()) paths.push_back(entry->fragmentPath);
+            }
+        }
+        for (const std::string& path : paths) {
+            std::error_code ec;
+            fs::file_time_type time = fs::last_write_time(path, ec);
+            if (ec) continue;
+            auto known = modified.find(path);
+            if (known != modified.end() && known->second != time) {
+                relink(fs::path(path).filename().string());
+            }
+            modified[path] = time;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+#endif
+
+    glfwMakeContextCurrent(nullptr);
+}
@@ -2,8 +2,80 @@
 #define SHADERS_H
 
 #include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
-GLuint createShaderProgram(const char* vertexPath, const char* fragmentPath);
+typedef size_t ShaderHandle;
+const ShaderHandle INVALID_SHADER = static_cast<ShaderHandle>(-1);
+
+// Loads, caches and hot-reloads shader programs.
+//
+// Linked programs are stored as driver binaries (glGetProgramBinary) keyed by
+// a hash of the sources and the driver strings, so a warm start skips
+// compilation entirely. When hot reload is on, a watcher thread relinks
+// edited sources on a hidden shared context and update() swaps the new
+// program in between frames; a failed edit keeps the old program.
+class ShaderManager {
+public:
+    ShaderManager();
+    ~ShaderManager();
+
+    // renderWindow's context must be current on the calling thread.
+    bool initialize(GLFWwindow* renderWindow);
+    void shutdown();
+
+    void setShaderDirectory(const std::string& directory);
+    void setCacheDirectory(const std::string& directory);
+    // Off by default; call before initialize().
+    void setHotReload(bool enabled);
+
+    // File names are relative to the shader directory. Returns
+    // INVALID_SHADER if the program cannot be built. feedbackVaryings are
+    // captured interleaved by transform feedback; such update-only programs
+    // may leave fragmentFile empty.
+    ShaderHandle load(const std::string& vertexFile, const std::string& fragmentFile,
+                      const std::vector<std::string>& feedbackVaryings = {});
+    GLuint program(ShaderHandle handle) const;
+
+    // Render thread, between frames.
+    void update();
+
+private:
+    struct ProgramEntry {
+        std::string vertexPath;
+        std::string fragmentPath;  // empty for vertex-only programs
+        std::vector<std::string> feedbackVaryings;
+        GLuint program = 0;
+        std::atomic<GLuint> pending{0};
+    };
+
+    GLuint buildProgram(const ProgramEntry& entry, bool useCache);
+    GLuint loadCachedBinary(const std::string& cacheFile);
+    void storeCachedBinary(GLuint program, const std::string& cacheFile);
+    std::string cacheFileFor(const std::string& vertexSource, const std::string& fragmentSource,
+                             const std::vector<std::string>& feedbackVaryings) const;
+
+    void watchLoop();
+    void relink(const std::string& changedFile);
+
+    std::string shaderDirectory;
+    std::string cacheDirectory;
+    std::string driverId;
+    bool hotReload;
+    bool binaryCacheSupported;
+
+    std::vector<std::unique_ptr<ProgramEntry>> entries;
+    std::mutex entriesMutex;
+
+    GLFWwindow* reloadContext;
+    std::thread watchThread;
+    std::atomic<bool> watching;
+};
 
 #endif
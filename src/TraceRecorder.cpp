@@ -0,0 +1,151 @@
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const char TRACE_MAGIC[4] = {'M', 'P', 'V', 'T'};
+static const uint32_t TRACE_VERSION = 2;
+
+TraceRecorder::TraceRecorder(size_t capacity)
+    : callbackEvents(capacity), frameEvents(capacity), callbackCount(0), frameCount(0), droppedEvents(0) {}
+
+void TraceRecorder::recordCallback(double time, size_t sourceOffset, double outputLatency, unsigned long frames,
+                                   unsigned long flags) {
+    size_t index = callbackCount.load(std::memory_order_relaxed);
+    if (index >= callbackEvents.size()) {
+        droppedEvents.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TraceEvent& event = callbackEvents[index];
+    event.time = time;
+    event.position = sourceOffset;
+    event.duration = static_cast<float>(outputLatency);
+    event.frames = static_cast<uint16_t>(std::min<unsigned long>(frames, UINT16_MAX));
+    event.flags = static_cast<uint8_t>(flags);
+    event.type = TraceEventType::Callback;
+    callbackCount.store(index + 1, std::memory_order_release);
+}
+
+void TraceRecorder::recordFrame(double time, size_t samplePosition, double workTime) {
+    size_t index = frameCount.load(std::memory_order_relaxed);
+    if (index >= frameEvents.size()) {
+        droppedEvents.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TraceEvent& event = frameEvents[index];
+    event.time = time;
+    event.position = samplePosition;
+    event.duration = static_cast<float>(workTime);
+    event.frames = 0;
+    event.flags = 0;
+    event.type = TraceEventType::Frame;
+    frameCount.store(index + 1, std::memory_order_release);
+}
+
+size_t TraceRecorder::getDroppedEvents() const {
+    return droppedEvents;
+}
+
+static void writeString(std::ofstream& file, const std::string& value) {
+    uint32_t length = static_cast<uint32_t>(value.size());
+    file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    file.write(value.data(), length);
+}
+
+static bool readString(std::ifstream& file, std::string& value) {
+    uint32_t length = 0;
+    if (!file.read(reinterpret_cast<char*>(&length), sizeof(length)) || length > 4096) {
+        return false;
+    }
+    value.resize(length);
+    return static_cast<bool>(file.read(&value[0], length));
+}
+
+bool TraceRecorder::save(const std::string& path, const TraceInfo& info) const {
+    // Merge the two streams into one timeline. A callback and a frame
+    // stamped at the same instant replay callback first.
+    std::vector<TraceEvent> events(callbackEvents.begin(), callbackEvents.begin() + callbackCount.load());
+    events.insert(events.end(), frameEvents.begin(), frameEvents.begin() + frameCount.load());
+    std::stable_sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) {
+        return a.time < b.time || (a.time == b.time && a.type < b.type);
+    });
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "ERROR: Cannot write trace " << path << std::endl;
+        return false;
+    }
+
+    uint64_t count = events.size();
+    file.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    file.write(reinterpret_cast<const char*>(&TRACE_VERSION), sizeof(TRACE_VERSION));
+    file.write(reinterpret_cast<const char*>(&info.sampleRate), sizeof(info.sampleRate));
+    file.write(reinterpret_cast<const char*>(&info.bufferSize), sizeof(info.bufferSize));
+    writeString(file, info.audioFile);
+    writeString(file, info.scenes);
+    uint8_t governor = info.governor ? 1 : 0;
+    file.write(reinterpret_cast<const char*>(&info.fftSize), sizeof(info.fftSize));
+    file.write(reinterpret_cast<const char*>(&governor), sizeof(governor));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(events.data()), events.size() * sizeof(TraceEvent));
+
+    if (!file) {
+        std::cerr << "ERROR: Failed writing trace " << path << std::endl;
+        return false;
+    }
+    std::cerr << "Wrote " << count << " trace events to " << path << std::endl;
+    if (droppedEvents > 0) {
+        std::cerr << "WARNING: " << droppedEvents << " trace events dropped, buffer full." << std::endl;
+    }
+    return true;
+}
+
+bool loadTrace(const std::string& path, Trace& trace) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "ERROR: Cannot open trace " << path << std::endl;
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t count = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!file || std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0 || version != TRACE_VERSION) {
+        std::cerr << "ERROR: " << path << " is not a version " << TRACE_VERSION << " trace." << std::endl;
+        return false;
+    }
+
+    file.read(reinterpret_cast<char*>(&trace.info.sampleRate), sizeof(trace.info.sampleRate));
+    file.read(reinterpret_cast<char*>(&trace.info.bufferSize), sizeof(trace.info.bufferSize));
+    uint8_t governor = 0;
+    if (!readString(file, trace.info.audioFile) || !readString(file, trace.info.scenes) ||
+        !file.read(reinterpret_cast<char*>(&trace.info.fftSize), sizeof(trace.info.fftSize)) ||
+        !file.read(reinterpret_cast<char*>(&governor), sizeof(governor)) ||
+        !file.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+        std::cerr << "ERROR: Truncated trace header in " << path << std::endl;
+        return false;
+    }
+    trace.info.governor = governor != 0;
+
+    // The count is only trusted as far as the file backs it up.
+    std::streamoff start = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff remaining = file.tellg() - start;
+    file.seekg(start);
+    if (!file || count > static_cast<uint64_t>(remaining) / sizeof(TraceEvent)) {
+        std::cerr << "ERROR: Truncated trace events in " << path << std::endl;
+        return false;
+    }
+
+    trace.events.resize(count);
+    if (!file.read(reinterpret_cast<char*>(trace.events.data()), count * sizeof(TraceEvent))) {
+        std::cerr << "ERROR: Truncated trace events in " << path << std::endl;
+        return false;
+    }
+    return true;
+}
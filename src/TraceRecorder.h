@@ -0,0 +1,74 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class TraceEventType : uint8_t {
+    Callback = 0,  // one audio callback
+    Frame = 1      // one rendered frame
+};
+
+// One fixed-size record. Times are on the PortAudio stream clock.
+struct TraceEvent {
+    double time;
+    uint64_t position;  // callback: source offset of the block; frame: analysed sample position shown
+    float duration;     // callback: output latency (DAC time - current time); frame: work time
+    uint16_t frames;    // callback: framesPerBuffer
+    uint8_t flags;      // callback: PaStreamCallbackFlags
+    TraceEventType type;
+};
+
+static_assert(sizeof(TraceEvent) == 24, "TraceEvent is written to disk as-is");
+
+// What a replay needs to reproduce the session's input.
+struct TraceInfo {
+    uint32_t sampleRate;
+    uint32_t bufferSize;
+    std::string audioFile;
+    std::string scenes;  // the visualization choice line
+    uint32_t fftSize;    // analysis size at the start
+    bool governor;       // whether a quality governor was changing it
+};
+
+struct Trace {
+    TraceInfo info;
+    std::vector<TraceEvent> events;  // sorted by time
+};
+
+// Collects callback and frame timings into preallocated storage; nothing is
+// written to disk until save(). Callback and render thread each own one
+// array, so recording takes no locks and never allocates. Once an array is
+// full further events are counted and dropped.
+//
+// The file is native-endian: "MPVT", version, sample rate, buffer size, the
+// two length-prefixed strings, starting FFT size, a governor byte, event
+// count, then the raw events.
+class TraceRecorder {
+public:
+    explicit TraceRecorder(size_t capacity);
+
+    // Audio callback only.
+    void recordCallback(double time, size_t sourceOffset, double outputLatency, unsigned long frames,
+                        unsigned long flags);
+    // Render thread only.
+    void recordFrame(double time, size_t samplePosition, double workTime);
+
+    // Call once both threads have stopped recording.
+    bool save(const std::string& path, const TraceInfo& info) const;
+    size_t getDroppedEvents() const;
+
+private:
+    std::vector<TraceEvent> callbackEvents;
+    std::vector<TraceEvent> frameEvents;
+    std::atomic<size_t> callbackCount;
+    std::atomic<size_t> frameCount;
+    std::atomic<size_t> droppedEvents;
+};
+
+bool loadTrace(const std::string& path, Trace& trace);
+
+#endif
@@ -0,0 +1,104 @@
+#include "TraceReplay.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+// Where the DAC is: the last callback's first sample plays at its DAC time.
+struct Playhead {
+    bool valid = false;
+    double dacTime = 0.0;
+    double offset = 0.0;
+
+    double audibleAt(double time, double sampleRate) const {
+        return offset + (time - dacTime) * sampleRate;
+    }
+};
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+void printDistribution(const char* label, std::vector<double> values) {
+    if (values.empty()) {
+        std::cout << label << ": no samples" << std::endl;
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    std::cout << std::fixed << std::setprecision(2) << label << " (ms): p50 " << percentile(values, 0.5)
+              << ", p95 " << percentile(values, 0.95) << ", p99 " << percentile(values, 0.99) << ", max "
+              << values.back() << " over " << values.size() << " frames" << std::endl;
+}
+
+}  // namespace
+
+TraceReplayer::TraceReplayer(const Trace& trace) : trace(trace) {}
+
+void TraceReplayer::run(AudioProcessor& processor, Renderer& renderer, QualityGovernor* governor) {
+    double sampleRate = processor.getSampleRate();
+    if (sampleRate != trace.info.sampleRate) {
+        std::cerr << "WARNING: trace was recorded at " << trace.info.sampleRate << " Hz, file plays at "
+                  << sampleRate << " Hz." << std::endl;
+    }
+
+    std::vector<float> output;
+    std::vector<double> recordedLatency, replayedLatency, recordedWork, replayedWork;
+    Playhead recordedPlayhead, replayedPlayhead;
+    size_t underflows = 0, divergentBlocks = 0, callbacks = 0;
+
+    for (const TraceEvent& event : trace.events) {
+        if (event.type == TraceEventType::Callback) {
+            ++callbacks;
+            if (event.flags & paOutputUnderflow) {
+                ++underflows;
+            }
+            recordedPlayhead = {true, event.time + event.duration, static_cast<double>(event.position)};
+
+            size_t offset = processor.getPlaybackPosition();
+            if (offset != event.position) {
+                ++divergentBlocks;
+            }
+            replayedPlayhead = {true, event.time + event.duration, static_cast<double>(offset)};
+
+            output.resize(std::max<size_t>(output.size(), event.frames));
+            PaStreamCallbackTimeInfo timeInfo = {0.0, event.time, event.time + event.duration};
+            if (processor.processOffline(output.data(), event.frames, timeInfo, event.flags) == paComplete) {
+                break;
+            }
+            continue;
+        }
+
+        if (renderer.shouldClose()) break;
+
+        const AnalysisFrame* frame = processor.getLatestFrame();
+        renderer.renderFrame(*frame, processor.getOverview());
+        replayedWork.push_back(renderer.getFrameWorkTime() * 1000.0);
+        recordedWork.push_back(event.duration * 1000.0);
+
+        if (recordedPlayhead.valid) {
+            double audible = recordedPlayhead.audibleAt(event.time, sampleRate);
+            recordedLatency.push_back((audible - static_cast<double>(event.position)) * 1000.0 / sampleRate);
+        }
+        if (replayedPlayhead.valid) {
+            double audible = replayedPlayhead.audibleAt(event.time, sampleRate);
+            replayedLatency.push_back((audible - static_cast<double>(frame->samplePosition)) * 1000.0 / sampleRate);
+        }
+
+        // Recorded, not replayed, frame time: quality follows the live run.
+        if (governor && governor->recordFrame(event.duration)) {
+            const QualitySettings& settings = governor->getSettings();
+            renderer.setQuality(settings);
+            processor.setAnalysisSize(settings.fftSize);
+        }
+    }
+
+    std::cout << "Replayed " << callbacks << " callbacks (" << underflows << " recorded underflows, "
+              << processor.getDroppedBlocks() << " blocks dropped by analysis, " << divergentBlocks
+              << " blocks at a different offset than recorded)." << std::endl;
+    printDistribution("Recorded audio-to-display latency", recordedLatency);
+    printDistribution("Replayed audio-to-display latency", replayedLatency);
+    printDistribution("Recorded frame work time", recordedWork);
+    printDistribution("Replayed frame work time", replayedWork);
+}
@@ -0,0 +1,33 @@
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+#include "Audio.h"
+#include "QualityGovernor.h"
+#include "Renderer.h"
+#include "TraceRecorder.h"
+
+// Replays a recorded session against a fake PortAudio clock: each callback
+// event calls the processor with the recorded time, block size and status
+// flags, each frame event renders a frame and, when the live run had a
+// governor, feeds it the recorded frame time, so quality changes happen
+// exactly where they did live.
+// Nothing waits for wall-clock time.
+//
+// At the end it prints audio-to-display latency (how far the analysed sample
+// on screen trails the sample audible at that instant) for both the
+// recording and the replay, plus frame work time, so a scheduling or
+// buffering change can be A/B'd on identical input.
+class TraceReplayer {
+public:
+    explicit TraceReplayer(const Trace& trace);
+
+    // The processor must be loaded with trace.info.audioFile and started
+    // with startOffline(). governor is null when the trace was recorded
+    // without one.
+    void run(AudioProcessor& processor, Renderer& renderer, QualityGovernor* governor);
+
+private:
+    const Trace& trace;
+};
+
+#endif
@@ -1,76 +1,348 @@
 #include "Audio.h"
-#include "visualizations/BaseVisualization.h"
-#include "visualizations/CircleVisualization.h"
-#include "visualizations/BarVisualization.h"
-#include "visualizations/CircularBarVisualization.h"
-#include "visualizations/MountainVisualization.h"
+#include "Config.h"
+#include "IdleGovernor.h"
+#include "QualityGovernor.h"
+#include "Renderer.h"
+#include "../audio/ThreadRoles.h"
+#include "TraceRecorder.h"
+#include "TraceReplay.h"
+#include "visualizations/VisualizationRegistry.h"
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <sstream>
 
 using namespace std;
 
-int main() {
-    const size_t BUFFER_SIZE = 1024;
-    const int WINDOW_WIDTH = 800;
-    const int WINDOW_HEIGHT = 600;
-
-    string fileName;
-    cout << "Enter audio file path: ";
-    cin >> fileName;
-
-    int choice;
-    cout << "\nSelect visualization:\n";
-    cout << "1. Circle Visualization\n";
-    cout << "2. Bar Visualization\n";
-    cout << "3. Circular Bar Visualization\n";
-    cout << "4. Mountain Visualization\n";
-    cout << "Enter choice: ";
-    cin >> choice;
-
-    unique_ptr<BaseVisualization> visualization;
-
-    switch (choice) {
-        case 1:
-            visualization = make_unique<CircleVisualization>();
-            break;
-        case 2:
-            visualization = make_unique<BarVisualization>();
-            break;
-        case 3:
-            visualization = make_unique<CircularBarVisualization>();
-            break;
-        case 4:
-            visualization = make_unique<MountainVisualization>();
-            break;
-        default:
-            cout << "Invalid choice. Exiting.\n";
+// Room for about 50 minutes of callbacks at 1024 frames / 44.1 kHz and as
+// many frames at 60 FPS.
+const size_t TRACE_CAPACITY = 1 << 18;
+
+// Longest an idle loop sleeps before checking again; signal and window
+// events end the sleep sooner.
+const double IDLE_POLL = 0.25;
+
+static void promptForSession(AppConfig& config) {
+    if (config.input.empty() && config.playlist.empty()) {
+        cout << "Enter audio file path: ";
+        cin >> config.input;
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    }
+
+    if (config.scenes.empty()) {
+        const auto& registry = visualizationRegistry();
+        cout << "\nSelect visualization(s):\n";
+        for (size_t i = 0; i < registry.size(); ++i) {
+            cout << i + 1 << ". " << registry[i].label << "\n";
+        }
+        cout << "Enter one or more choices separated by spaces (e.g. 2 or 2 1 4): ";
+
+        string choiceLine, choice;
+        getline(cin, choiceLine);
+        istringstream choices(choiceLine);
+        while (choices >> choice) {
+            config.scenes.push_back(choice);
+        }
+    }
+}
+
+static bool buildRenderer(Renderer& renderer, const AppConfig& config, const vector<string>& scenes,
+                          const char* title) {
+    renderer.setShaderHotReload(config.hotReload);
+    if (!renderer.initialize(config.width, config.height, title)) {
+        cerr << "Failed to initialize renderer." << endl;
+        return false;
+    }
+    renderer.setVsync(config.vsync);
+
+    for (const string& name : scenes) {
+        unique_ptr<BaseVisualization> visualization = createVisualization(name);
+        if (!visualization) {
+            cout << "Invalid choice '" << name << "'. Exiting.\n";
+            return false;
+        }
+        if (!renderer.addScene(move(visualization))) {
+            cerr << "Failed to initialize visualization." << endl;
+            return false;
+        }
+    }
+    if (scenes.empty()) {
+        cout << "No visualization selected. Exiting.\n";
+        return false;
+    }
+
+    renderer.setLayout(config.layout);
+    renderer.setBandScale(config.bandScale);
+    renderer.setLoudnessOverlay(config.loudness);
+    renderer.setPostProcessing(config.postEffects);
+    renderer.setOverviewStrip(config.overview != OverviewMode::Off);
+    return true;
+}
+
+static bool loadAudio(AudioProcessor& audioProcessor, const AppConfig& config, const vector<string>& fileNames) {
+    audioProcessor.setDecodeThreads(config.decodeThreads);
+    audioProcessor.setWindow(config.window);
+    audioProcessor.setFFTBackend(config.fftBackend);
+    audioProcessor.setPcmFormat(config.pcmFormat);
+    audioProcessor.setOverviewMode(config.overview);
+    audioProcessor.setAnalysisSize(config.fftSize);
+    audioProcessor.setRawPcmFormat(config.rawPcm);
+    audioProcessor.setStreamBuffer(config.streamBuffer);
+    // Only the realtime loop idles; offline runs and replays analyse everything.
+    audioProcessor.setSilenceDetection(config.idle && config.mode == RunMode::Realtime && config.replayTrace.empty());
+    bool live = fileNames.size() == 1 && (config.rawPcm.channels > 0 || isStreamSource(fileNames[0]));
+    if (live ? !audioProcessor.openStream(fileNames[0]) : !audioProcessor.loadPlaylist(fileNames)) {
+        cerr << "Failed to load audio file." << endl;
+        return false;
+    }
+    // After the first track is decoded, so its samples are locked too.
+    if (config.lockMemory) {
+        lockProcessMemory();
+    }
+    return true;
+}
+
+static void configureThreadRoles(const AppConfig& config) {
+    for (size_t i = 0; i < THREAD_ROLE_COUNT; ++i) {
+        setThreadRolePolicy(static_cast<ThreadRole>(i), config.threadPolicies[i]);
+    }
+}
+
+static void applyGovernor(QualityGovernor* governor, double frameTime, Renderer& renderer,
+                          AudioProcessor& audioProcessor) {
+    if (governor && governor->recordFrame(frameTime)) {
+        const QualitySettings& settings = governor->getSettings();
+        renderer.setQuality(settings);
+        audioProcessor.setAnalysisSize(settings.fftSize);
+    }
+}
+
+static int replay(const AppConfig& config) {
+    Trace trace;
+    if (!loadTrace(config.replayTrace, trace)) {
+        return -1;
+    }
+
+    // The trace fixes the input, scenes, block size and the analysis size
+    // and governor; everything else comes from the config, so one trace
+    // can be replayed under several.
+    AppConfig replayConfig = config;
+    replayConfig.vsync = false;
+    replayConfig.fftSize = trace.info.fftSize;
+    replayConfig.governor = trace.info.governor;
+    istringstream sceneList(trace.info.scenes);
+    vector<string> scenes;
+    for (string scene; sceneList >> scene;) {
+        scenes.push_back(scene);
+    }
+
+    Renderer renderer;
+    if (!buildRenderer(renderer, replayConfig, scenes, "Audio Visualizer (replay)")) {
+        return -1;
+    }
+
+    unique_ptr<QualityGovernor> governor;
+    AudioProcessor audioProcessor(trace.info.bufferSize);
+    if (replayConfig.governor) {
+        governor = make_unique<QualityGovernor>(config.targetFps);
+        audioProcessor.planAnalysisSizes(governor->getFftSizes());
+    }
+    if (!loadAudio(audioProcessor, replayConfig, {trace.info.audioFile}) || !audioProcessor.startOffline()) {
+        return -1;
+    }
+
+    applyThreadRole(ThreadRole::Render);
+    renderer.setFrameTiming(true);
+    TraceReplayer replayer(trace);
+    replayer.run(audioProcessor, renderer, governor.get());
+
+    audioProcessor.cleanup();
+    renderer.cleanup();
+    return 0;
+}
+
+// Renders as fast as possible against a fake clock: each frame advances it
+// by one frame interval and the callback is driven to keep up. Useful for
+// throughput sweeps without an audio device.
+static void runOffline(AudioProcessor& audioProcessor, Renderer& renderer, QualityGovernor* governor,
+                       const AppConfig& config) {
+    double frameInterval = 1.0 / config.targetFps;
+    double blockSeconds = static_cast<double>(config.hop) / audioProcessor.getSampleRate();
+    vector<float> output(config.hop);
+
+    double clock = 0.0, audioClock = 0.0;
+    double totalWork = 0.0, peakWork = 0.0;
+    PostTimings totalPost = {};
+    size_t frameCount = 0;
+    bool finished = false;
+    auto wallStart = chrono::steady_clock::now();
+
+    while (!finished && !renderer.shouldClose()) {
+        clock += frameInterval;
+        while (!finished && audioClock < clock) {
+            PaStreamCallbackTimeInfo timeInfo = {0.0, audioClock, audioClock};
+            finished = audioProcessor.processOffline(output.data(), config.hop, timeInfo, 0) == paComplete;
+            audioClock += blockSeconds;
+        }
+
+        const AnalysisFrame* frame = audioProcessor.getLatestFrame();
+        renderer.renderFrame(*frame, audioProcessor.getOverview());
+
+        double work = renderer.getFrameWorkTime();
+        totalWork += work;
+        peakWork = max(peakWork, work);
+        const PostTimings& post = renderer.getPostTimings();
+        for (size_t i = 0; i < POST_PASS_COUNT; ++i) {
+            totalPost[i] += post[i];
+        }
+        ++frameCount;
+        applyGovernor(governor, work, renderer, audioProcessor);
+    }
+
+    double wall = chrono::duration<double>(chrono::steady_clock::now() - wallStart).count();
+    cout << "Offline: " << frameCount << " frames covering " << audioClock << " s of audio in " << wall
+         << " s (" << (wall > 0.0 ? audioClock / wall : 0.0) << "x realtime), frame work average "
+         << (frameCount ? totalWork / frameCount * 1000.0 : 0.0) << " ms, peak " << peakWork * 1000.0 << " ms"
+         << endl;
+    const AnalyzerCost& cost = audioProcessor.getLatestFrame()->spectrumCost;
+    cout << "Multi-resolution analysis: " << cost.averageMs << " ms per block average, peak " << cost.peakMs
+         << " ms, bound " << cost.boundMs << " ms over " << cost.transforms << " transforms" << endl;
+    if (frameCount && totalPost[static_cast<size_t>(PostPass::Composite)] > 0.0) {
+        cout << "Post-processing GPU time per frame:";
+        for (size_t i = 0; i < POST_PASS_COUNT; ++i) {
+            cout << (i ? ", " : " ") << postPassName(static_cast<PostPass>(i)) << " " << totalPost[i] / frameCount
+                 << " ms";
+        }
+        cout << endl;
+    }
+}
+
+static void runRealtime(AudioProcessor& audioProcessor, Renderer& renderer, QualityGovernor* governor,
+                        IdleGovernor* idle, TraceRecorder* recorder) {
+    while (!renderer.shouldClose()) {
+        const AnalysisFrame* frame = audioProcessor.getLatestFrame();
+        if (idle && idle->skip(*frame, renderer, audioProcessor.getOverview())) {
+            // The analysis thread posts a wake-up with the first frame that
+            // has signal, so drawing resumes within one audio block.
+            audioProcessor.wakeOnSignal(Renderer::wake);
+            renderer.waitEvents(IDLE_POLL);
+            continue;
+        }
+        renderer.renderFrame(*frame, audioProcessor.getOverview());
+
+        if (recorder) {
+            recorder->recordFrame(audioProcessor.getStreamTime(), frame->samplePosition, renderer.getFrameWorkTime());
+        }
+        applyGovernor(governor, renderer.getFrameWorkTime(), renderer, audioProcessor);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    AppConfig config;
+    if (!parseCommandLine(argc, argv, config)) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    configureThreadRoles(config);
+    if (!config.replayTrace.empty()) {
+        return replay(config);
+    }
+
+    // The prompts read stdin, which is taken when the audio comes in on it.
+    if (config.input == "-" && config.scenes.empty()) {
+        cerr << "ERROR: Pass the scenes on the command line when streaming from stdin." << endl;
+        return -1;
+    }
+    promptForSession(config);
+
+    Renderer renderer;
+    if (!buildRenderer(renderer, config, config.scenes, "Audio Visualizer")) {
+        return -1;
+    }
+
+    vector<string> tracks;
+    if (!config.playlist.empty()) {
+        if (!loadPlaylistFile(config.playlist, tracks)) {
             return -1;
+        }
+    } else {
+        tracks.push_back(config.input);
     }
 
-    if (!visualization->initialize(WINDOW_WIDTH, WINDOW_HEIGHT)) {
-        cerr << "Failed to initialize visualization." << endl;
+    unique_ptr<QualityGovernor> governor;
+    if (config.governor) {
+        governor = make_unique<QualityGovernor>(config.targetFps);
+    }
+
+    AudioProcessor audioProcessor(config.hop);
+    if (governor) {
+        audioProcessor.planAnalysisSizes(governor->getFftSizes());
+    }
+    if (!loadAudio(audioProcessor, config, tracks)) {
         return -1;
     }
 
-    AudioProcessor audioProcessor(BUFFER_SIZE);
-    if (!audioProcessor.loadAudioFile(fileName)) {
-        cerr << "Failed to load audio file." << endl;
+    if (!config.sharedMemory.empty() && !audioProcessor.publishSharedMemory(config.sharedMemory)) {
         return -1;
     }
 
+    if (config.mode == RunMode::Offline) {
+        if (!audioProcessor.startOffline()) {
+            return -1;
+        }
+        applyThreadRole(ThreadRole::Render);
+        renderer.setFrameTiming(true);
+        runOffline(audioProcessor, renderer, governor.get(), config);
+        audioProcessor.cleanup();
+        renderer.cleanup();
+        return 0;
+    }
+
+    unique_ptr<TraceRecorder> recorder;
+    if (!config.recordTrace.empty()) {
+        recorder = make_unique<TraceRecorder>(TRACE_CAPACITY);
+        audioProcessor.setTraceRecorder(recorder.get());
+    }
+
     if (!audioProcessor.startProcessing()) {
         cerr << "Failed to start audio processing." << endl;
         return -1;
     }
+    // Only now: threads inherit their creator's scheduling and affinity, so
+    // an earlier switch would leak the render policy into the analysis,
+    // PortAudio and decode threads.
+    applyThreadRole(ThreadRole::Render);
+    renderer.setFrameTiming(governor || recorder);
+
+    unique_ptr<IdleGovernor> idle;
+    if (config.idle) {
+        idle = make_unique<IdleGovernor>();
+    }
 
-    while (!visualization->shouldClose()) {
-        auto fftData = audioProcessor.getFFTData();
-        visualization->render(fftData);
+    runRealtime(audioProcessor, renderer, governor.get(), idle.get(), recorder.get());
+    if (idle) {
+        cerr << "Idle: " << idle->getSkippedFrames() << " frames skipped over " << idle->getIdleSeconds()
+             << " s, " << audioProcessor.getFftsAvoided() << " FFTs avoided" << endl;
     }
 
+    // Stop the stream before saving so the callback is done writing.
+    int sampleRate = audioProcessor.getSampleRate();
     audioProcessor.cleanup();
-    visualization->cleanup();
+    if (recorder) {
+        string scenes;
+        for (const string& scene : config.scenes) {
+            scenes += (scenes.empty() ? "" : " ") + scene;
+        }
+        // Replays cover the first track only.
+        TraceInfo info = {static_cast<uint32_t>(sampleRate), static_cast<uint32_t>(config.hop), tracks[0], scenes,
+                          static_cast<uint32_t>(config.fftSize), config.governor};
+        recorder->save(config.recordTrace, info);
+    }
+    renderer.cleanup();
 
     return 0;
 }
@@ -0,0 +1,106 @@
+// Times the serial MP3 decoder against ParallelMP3Decoder at increasing
+// thread counts and checks the parallel output against the serial one, then
+// compares PcmStore formats: memory held and the cost of expanding the
+// track in callback-sized blocks.
+//
+//   ./decode_benchmark <file.mp3> [max threads]
+
+#include "../../audio/AudioReader.h"
+#include "../../audio/ParallelMP3Decoder.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " <file.mp3> [max threads]" << endl;
+        return -1;
+    }
+    string filePath = argv[1];
+    size_t maxThreads = argc > 2 ? strtoul(argv[2], nullptr, 10) : max(1u, thread::hardware_concurrency());
+
+    AudioFileReader serial;
+    serial.setDecodeThreads(1);
+    serial.setPcmFormat(PcmFormat::Float32);
+    auto start = chrono::steady_clock::now();
+    if (!serial.loadFile(filePath)) {
+        return -1;
+    }
+    double serialTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    vector<float> reference(serial.getFrameCount()), referenceRight(serial.getFrameCount());
+    serial.getPcm().read(0, reference.size(), reference.data(), referenceRight.data());
+    double seconds = static_cast<double>(reference.size()) / serial.getSampleRate();
+
+    cout << fixed << setprecision(3);
+    cout << "track: " << seconds << " s, " << reference.size() << " samples/channel" << endl;
+    cout << "serial loadMP3: " << serialTime << " s (" << seconds / serialTime << "x realtime)" << endl;
+
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        ParallelMP3Decoder decoder(threads);
+        PcmStore pcm;
+        pcm.reset(PcmFormat::Float32, 2);
+        int sampleRate;
+        auto begin = chrono::steady_clock::now();
+        if (!decoder.decode(filePath, pcm, sampleRate)) {
+            return -1;
+        }
+        chrono::duration<double> parallelTime = chrono::steady_clock::now() - begin;
+        vector<float> left(pcm.size());
+        pcm.read(0, left.size(), left.data(), nullptr);
+
+        // The serial path decodes to 16-bit, the parallel one to float, so
+        // expect differences up to one 16-bit step.
+        size_t compared = min(left.size(), reference.size());
+        float maxError = 0.0f;
+        for (size_t i = 0; i < compared; ++i) {
+            maxError = max(maxError, fabs(left[i] - reference[i]));
+        }
+
+        cout << "parallel x" << threads << ": " << parallelTime.count() << " s, speedup "
+             << serialTime / parallelTime.count() << "x, samples " << left.size()
+             << (left.size() == reference.size() ? " (match)" : " (MISMATCH)")
+             << ", max error " << scientific << maxError << fixed << endl;
+    }
+
+    // Expansion cost is what the callback and analysis pay per block, so
+    // time it at the callback's block size and report it per second of audio.
+    const size_t BLOCK_FRAMES = 1024;
+    vector<float> blockLeft(BLOCK_FRAMES), blockRight(BLOCK_FRAMES);
+    size_t stereoFloatBytes = reference.size() * 2 * sizeof(float);
+    for (PcmFormat format : {PcmFormat::Float32, PcmFormat::Int16, PcmFormat::Float16}) {
+        PcmStore pcm;
+        pcm.reset(format, serial.getPcm().getChannels());
+        vector<float> interleaved(BLOCK_FRAMES * 2);
+        for (size_t offset = 0; offset < reference.size(); offset += BLOCK_FRAMES) {
+            size_t frames = min(BLOCK_FRAMES, reference.size() - offset);
+            for (size_t i = 0; i < frames; ++i) {
+                interleaved[pcm.getChannels() * i] = reference[offset + i];
+                if (pcm.getChannels() == 2) interleaved[2 * i + 1] = referenceRight[offset + i];
+            }
+            pcm.append(interleaved.data(), frames);
+        }
+        pcm.shrink();
+
+        float maxError = 0.0f;
+        auto begin = chrono::steady_clock::now();
+        for (size_t offset = 0; offset < pcm.size(); offset += BLOCK_FRAMES) {
+            size_t frames = pcm.read(offset, BLOCK_FRAMES, blockLeft.data(), blockRight.data());
+            maxError = max(maxError, fabs(blockLeft[frames - 1] - reference[offset + frames - 1]));
+        }
+        double expandTime = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+        const char* name = format == PcmFormat::Float32 ? "float" : (format == PcmFormat::Int16 ? "int16" : "float16");
+        cout << "pcm " << name << ": " << pcm.memoryBytes() / (1024.0 * 1024.0) << " MB ("
+             << static_cast<double>(stereoFloatBytes) / pcm.memoryBytes() << "x smaller than stereo float), "
+             << expandTime / seconds * 1e6 << " us to expand each second, max error " << scientific << maxError
+             << fixed << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Extracts SpectralDescriptors for a whole file and writes them as CSV, one
+// row per hop, for offline analysis and for checking the live values.
+//
+//   ./descriptor_extract <file> [fft size] [hop] > descriptors.csv
+
+#include "../../audio/AudioReader.h"
+#include "../../audio/FFTProcessor.h"
+#include "../../audio/SpectralDescriptors.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+// Spectra handed to processFrames at a time.
+static const size_t BATCH_FRAMES = 256;
+
+static void writeRows(const SpectralFeatures* features, size_t count, size_t firstFrame, size_t hop, int sampleRate) {
+    for (size_t i = 0; i < count; ++i) {
+        const SpectralFeatures& f = features[i];
+        cout << static_cast<double>((firstFrame + i) * hop) / sampleRate << ',' << f.centroid << ','
+             << f.spread << ',' << f.flatness << ',' << f.rolloff << ',' << f.flux;
+        for (float coefficient : f.mfcc) {
+            cout << ',' << coefficient;
+        }
+        cout << '\n';
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " <file> [fft size] [hop]" << endl;
+        return -1;
+    }
+    size_t fftSize = argc > 2 ? strtoul(argv[2], nullptr, 10) : 2048;
+    size_t hop = argc > 3 ? strtoul(argv[3], nullptr, 10) : fftSize / 4;
+    if (fftSize < 64 || hop == 0) {
+        cerr << "ERROR: FFT size must be at least 64 and hop above 0." << endl;
+        return -1;
+    }
+
+    AudioFileReader reader;
+    reader.setPcmFormat(PcmFormat::Float32);
+    if (!reader.loadFile(argv[1])) {
+        return -1;
+    }
+    size_t frames = reader.getFrameCount();
+    int sampleRate = reader.getSampleRate();
+    vector<float> left(frames), right(frames);
+    reader.getPcm().read(0, frames, left.data(), right.data());
+    for (size_t i = 0; i < frames; ++i) {
+        left[i] = 0.5f * (left[i] + right[i]);
+    }
+
+    FFTProcessor fft(fftSize);
+    fft.setWindow(WindowFunction::Hann);
+    SpectralDescriptors descriptors(fftSize, sampleRate);
+    size_t bins = fftSize / 2;
+    size_t hops = frames >= fftSize ? (frames - fftSize) / hop + 1 : 0;
+
+    cout << "time,centroid,spread,flatness,rolloff,flux";
+    for (size_t i = 0; i < MFCC_COUNT; ++i) {
+        cout << ",mfcc" << i;
+    }
+    cout << '\n';
+
+    vector<float> window(fftSize);
+    vector<float> spectra(BATCH_FRAMES * bins);
+    vector<SpectralFeatures> features(BATCH_FRAMES);
+    double descriptorTime = 0.0;
+    for (size_t first = 0; first < hops; first += BATCH_FRAMES) {
+        size_t count = min(BATCH_FRAMES, hops - first);
+        for (size_t i = 0; i < count; ++i) {
+            size_t start = (first + i) * hop;
+            copy(left.begin() + start, left.begin() + start + fftSize, window.begin());
+            fft.computeFFT(window);
+            const vector<float>& magnitudes = fft.getMagnitudes();
+            copy(magnitudes.begin(), magnitudes.begin() + bins, spectra.begin() + i * bins);
+        }
+
+        auto start = chrono::steady_clock::now();
+        descriptors.processFrames(spectra.data(), count, features.data());
+        descriptorTime += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        writeRows(features.data(), count, first, hop, sampleRate);
+    }
+
+    if (hops > 0) {
+        // stdout carries the CSV, so the summary goes to stderr.
+        cerr << hops << " frames, " << descriptorTime * 1e6 / hops << " us per frame in descriptors" << endl;
+    }
+    return 0;
+}
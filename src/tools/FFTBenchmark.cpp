@@ -0,0 +1,99 @@
+// Times the FixedFFT kernels against the FFTW r2r path FFTProcessor uses
+// and checks their magnitudes against FFTW's at every compiled size.
+//
+//   ./fft_benchmark [iterations]
+
+#include "../../audio/FixedFFT.h"
+#include <fftw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+static const size_t SIZES[] = {256, 512, 1024, 2048, 4096, 8192};
+
+// Magnitudes from an R2HC output, laid out the way FFTProcessor reads them.
+static void halfComplexMagnitudes(const float* output, size_t size, float* magnitudes) {
+    for (size_t i = 0; i < size / 2; ++i) {
+        float real = output[i];
+        float imag = i == 0 ? 0.0f : output[size - i];
+        magnitudes[i] = sqrt(real * real + imag * imag);
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20000;
+    if (iterations == 0) {
+        cerr << "Usage: " << argv[0] << " [iterations]" << endl;
+        return -1;
+    }
+
+    mt19937 random(1234);
+    uniform_real_distribution<float> sample(-1.0f, 1.0f);
+    bool allAccurate = true;
+
+    cout << fixed << setprecision(1);
+    for (size_t size : SIZES) {
+        float* input = static_cast<float*>(fftwf_malloc(sizeof(float) * size));
+        float* output = static_cast<float*>(fftwf_malloc(sizeof(float) * size));
+        fftwf_plan plan = fftwf_plan_r2r_1d(static_cast<int>(size), input, output, FFTW_R2HC, FFTW_MEASURE);
+        unique_ptr<FixedFFTKernel> kernel = makeFixedFFT(size);
+        if (!plan || !kernel) {
+            cerr << "ERROR: no transform for " << size << " points." << endl;
+            return -1;
+        }
+
+        // Planning with FFTW_MEASURE overwrites the input, so fill it after.
+        vector<float> signal(size);
+        for (float& value : signal) {
+            value = sample(random);
+        }
+        copy(signal.begin(), signal.end(), input);
+
+        vector<float> reference(size / 2), result(size / 2);
+        fftwf_execute(plan);
+        halfComplexMagnitudes(output, size, reference.data());
+        kernel->magnitudes(signal.data(), result.data());
+
+        float peak = *max_element(reference.begin(), reference.end());
+        float maxError = 0.0f;
+        for (size_t i = 0; i < size / 2; ++i) {
+            maxError = max(maxError, fabs(result[i] - reference[i]));
+        }
+        // float rounding grows roughly with log2(size); 1e-5 of the peak is
+        // well clear of it and far below anything the display resolves.
+        float relativeError = maxError / peak;
+        bool accurate = relativeError < 1e-5f;
+        allAccurate = allAccurate && accurate;
+
+        // Magnitudes are part of both timings since every caller needs them.
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            fftwf_execute(plan);
+            halfComplexMagnitudes(output, size, reference.data());
+        }
+        double fftwNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / iterations;
+
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            kernel->magnitudes(signal.data(), result.data());
+        }
+        double fixedNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / iterations;
+
+        cout << setw(5) << size << " points: fftw " << setw(9) << fftwNs << " ns, fixed " << setw(9) << fixedNs
+             << " ns (" << setprecision(2) << fftwNs / fixedNs << "x), max error " << scientific << relativeError
+             << fixed << setprecision(1) << (accurate ? "" : " (INACCURATE)") << endl;
+
+        fftwf_destroy_plan(plan);
+        fftwf_free(input);
+        fftwf_free(output);
+    }
+
+    return allAccurate ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+// Reads the shared spectrum ring published with --shared-memory and checks
+// it: every frame's checksum must match its payload (no torn reads) and
+// frame indices must only move forward. Reports frames received, frames
+// skipped because the reader polled too slowly, and seqlock retries.
+//
+//   ./spectrum_reader [name] [seconds]
+
+#include "../../audio/SpectrumReader.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    string name = argc > 1 ? argv[1] : SHARED_SPECTRUM_DEFAULT_NAME;
+    double seconds = argc > 2 ? strtod(argv[2], nullptr) : 10.0;
+
+    SpectrumReader reader;
+    if (!reader.open(name)) {
+        cerr << "Is the visualizer running with --shared-memory " << name << "?" << endl;
+        return -1;
+    }
+    cout << "Reading " << name << " at " << reader.getSampleRate() << " Hz for " << seconds << " s" << endl;
+
+    SpectrumSnapshot snapshot;
+    uint64_t lastFrame = 0, received = 0, skipped = 0, torn = 0, backwards = 0, beats = 0;
+    auto start = chrono::steady_clock::now();
+    auto deadline = start + chrono::duration<double>(seconds);
+
+    while (chrono::steady_clock::now() < deadline && reader.isWriterActive()) {
+        if (!reader.readLatest(snapshot, lastFrame)) {
+            this_thread::sleep_for(chrono::microseconds(500));
+            continue;
+        }
+
+        uint32_t checksum = sharedSpectrumChecksum(snapshot.magnitudes.data(), snapshot.magnitudes.size(),
+                                                   snapshot.bands.data(), snapshot.bands.size());
+        if (checksum != snapshot.checksum) {
+            ++torn;
+        }
+        if (snapshot.frameIndex <= lastFrame) {
+            ++backwards;
+        } else if (lastFrame != 0) {
+            skipped += snapshot.frameIndex - lastFrame - 1;
+        }
+        if (snapshot.beat) {
+            ++beats;
+        }
+        lastFrame = snapshot.frameIndex;
+        ++received;
+    }
+
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Received " << received << " frames (" << received / elapsed << " per second), skipped " << skipped
+         << ", torn " << torn << ", out of order " << backwards << ", seqlock retries " << reader.getRetries()
+         << ", beats " << beats << ", last tempo " << snapshot.tempo << " BPM" << endl;
+    return torn == 0 && backwards == 0 ? 0 : 1;
+}
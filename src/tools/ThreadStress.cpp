@@ -0,0 +1,199 @@
+// Stress test for thread roles. An emulated audio thread (a 256-frame block
+// every 5.3 ms) and render thread (fixed work at 60 FPS) run against
+// memory-streaming load threads, first as ordinary threads sharing every
+// CPU, then isolated: the given policies applied, memory locked and the
+// load kept off the audio and render CPUs. Reports audio deadline misses
+// (dropouts) and wakeup lateness, and render frame-time percentiles.
+//
+//   ./thread_stress [seconds per run] [load threads] [audio policy] [render policy]
+//
+// Policies use the --audio-thread syntax; the defaults pin audio (fifo:80)
+// and render (rr:60) to the last two CPUs. Real-time scheduling needs
+// CAP_SYS_NICE or an RLIMIT_RTPRIO allowance, and what was refused is
+// logged, so an unprivileged run shows what affinity alone buys.
+
+#include "../../audio/FixedFFT.h"
+#include "../../audio/ThreadRoles.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+static const size_t BLOCK_FRAMES = 256;
+static const int STREAM_RATE = 48000;
+static const double FRAME_INTERVAL = 1.0 / 60.0;
+static const double RENDER_WORK = 0.004;              // seconds of render work per frame, unloaded
+static const size_t LOAD_BYTES = 64 * 1024 * 1024;   // per load thread, well past any LLC
+
+struct RunResult {
+    size_t blocks = 0;
+    size_t dropouts = 0;
+    vector<double> lateness;    // audio wakeup lateness, seconds
+    vector<double> frameTimes;  // render work, seconds
+};
+
+static double percentile(vector<double> values, double fraction) {
+    if (values.empty()) return 0.0;
+    size_t index = min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static double seconds(Clock::duration duration) {
+    return chrono::duration<double>(duration).count();
+}
+
+// Stands in for the callback's copy plus the analysis handoff.
+static void audioWork(FixedFFT<1024>& fft, vector<float>& input, vector<float>& output) {
+    for (size_t i = 0; i < BLOCK_FRAMES; ++i) {
+        input[i] = input[(i + BLOCK_FRAMES) % input.size()] * 0.999f;
+    }
+    fft.magnitudes(input.data(), output.data());
+}
+
+static void renderWork(FixedFFT<4096>& fft, vector<float>& input, vector<float>& output, size_t transforms) {
+    for (size_t i = 0; i < transforms; ++i) {
+        fft.magnitudes(input.data(), output.data());
+        input[i % input.size()] += output[i % output.size()] * 1e-9f;
+    }
+}
+
+static void audioThread(const ThreadPolicy& policy, Clock::time_point end, RunResult& result) {
+    applyThreadPolicy(policy, "audio");
+    FixedFFT<1024> fft;
+    vector<float> input(1024, 0.5f), output(512);
+    Clock::duration period = chrono::duration_cast<Clock::duration>(
+        chrono::duration<double>(static_cast<double>(BLOCK_FRAMES) / STREAM_RATE));
+
+    Clock::time_point due = Clock::now() + period;
+    while (due < end) {
+        this_thread::sleep_until(due - period);
+        Clock::time_point woke = Clock::now();
+        audioWork(fft, input, output);
+        Clock::time_point finished = Clock::now();
+
+        result.lateness.push_back(seconds(woke - (due - period)));
+        ++result.blocks;
+        if (finished > due) {
+            // The device ran dry; like PortAudio, restart the schedule.
+            ++result.dropouts;
+            due = finished;
+        }
+        due += period;
+    }
+}
+
+static void renderThread(const ThreadPolicy& policy, size_t transforms, Clock::time_point end, RunResult& result) {
+    applyThreadPolicy(policy, "render");
+    FixedFFT<4096> fft;
+    vector<float> input(4096, 0.25f), output(2048);
+    Clock::duration interval = chrono::duration_cast<Clock::duration>(chrono::duration<double>(FRAME_INTERVAL));
+
+    Clock::time_point next = Clock::now();
+    while (next < end) {
+        this_thread::sleep_until(next);
+        Clock::time_point start = Clock::now();
+        renderWork(fft, input, output, transforms);
+        result.frameTimes.push_back(seconds(Clock::now() - start));
+        next = max(next + interval, Clock::now());
+    }
+}
+
+static void loadThread(const ThreadPolicy& policy, const atomic<bool>& running) {
+    applyThreadPolicy(policy, "load");
+    vector<unsigned char> buffer(LOAD_BYTES, 1);
+    unsigned char sum = 0;
+    while (running.load(memory_order_relaxed)) {
+        for (size_t i = 0; i < buffer.size(); i += 64) {
+            sum = static_cast<unsigned char>(sum + buffer[i]);
+            buffer[i] = sum;
+        }
+    }
+}
+
+static RunResult run(double duration, size_t loadThreads, const ThreadPolicy& audio, const ThreadPolicy& render,
+                     const ThreadPolicy& load, size_t transforms) {
+    RunResult audioResult, renderResult;
+    atomic<bool> running(true);
+    vector<thread> loads;
+    for (size_t i = 0; i < loadThreads; ++i) {
+        loads.emplace_back(loadThread, cref(load), cref(running));
+    }
+    // Let the load reach steady state before measuring.
+    this_thread::sleep_for(chrono::milliseconds(500));
+
+    Clock::time_point end = Clock::now() + chrono::duration_cast<Clock::duration>(chrono::duration<double>(duration));
+    thread audioWorker(audioThread, cref(audio), end, ref(audioResult));
+    thread renderWorker(renderThread, cref(render), transforms, end, ref(renderResult));
+    audioWorker.join();
+    renderWorker.join();
+
+    running = false;
+    for (thread& worker : loads) {
+        worker.join();
+    }
+    audioResult.frameTimes = move(renderResult.frameTimes);
+    return audioResult;
+}
+
+static void report(const char* name, const RunResult& result) {
+    cout << setw(9) << left << name << right << setw(8) << result.blocks << setw(10) << result.dropouts
+         << setw(11) << percentile(result.lateness, 0.99) * 1000.0 << setw(11)
+         << percentile(result.lateness, 1.0) * 1000.0 << "  |" << setw(8) << result.frameTimes.size() << setw(9)
+         << percentile(result.frameTimes, 0.5) * 1000.0 << setw(9) << percentile(result.frameTimes, 0.95) * 1000.0
+         << setw(9) << percentile(result.frameTimes, 0.99) * 1000.0 << setw(9)
+         << percentile(result.frameTimes, 1.0) * 1000.0 << endl;
+}
+
+int main(int argc, char** argv) {
+    double duration = argc > 1 ? strtod(argv[1], nullptr) : 10.0;
+    size_t cpuCount = max(1u, thread::hardware_concurrency());
+    size_t loadThreads = argc > 2 ? strtoul(argv[2], nullptr, 10) : cpuCount;
+
+    ThreadPolicy audio, render;
+    string audioText = argc > 3 ? argv[3] : "fifo:80" + (cpuCount > 2 ? "@" + to_string(cpuCount - 1) : string());
+    string renderText = argc > 4 ? argv[4] : "rr:60" + (cpuCount > 2 ? "@" + to_string(cpuCount - 2) : string());
+    if (duration <= 0.0 || !parseThreadPolicy(audioText, audio) || !parseThreadPolicy(renderText, render)) {
+        cerr << "Usage: " << argv[0] << " [seconds per run] [load threads] [audio policy] [render policy]" << endl;
+        return -1;
+    }
+
+    // The load keeps to whatever CPUs audio and render don't claim.
+    ThreadPolicy load;
+    for (size_t cpu = 0; cpu < cpuCount; ++cpu) {
+        int id = static_cast<int>(cpu);
+        if (find(audio.cpus.begin(), audio.cpus.end(), id) == audio.cpus.end() &&
+            find(render.cpus.begin(), render.cpus.end(), id) == render.cpus.end()) {
+            load.cpus.push_back(id);
+        }
+    }
+    if (load.cpus.size() == cpuCount) {
+        load.cpus.clear();
+    }
+
+    // Size the render work to RENDER_WORK on an idle machine.
+    FixedFFT<4096> fft;
+    vector<float> input(4096, 0.25f), output(2048);
+    auto start = Clock::now();
+    renderWork(fft, input, output, 1000);
+    double perTransform = seconds(Clock::now() - start) / 1000.0;
+    size_t transforms = max<size_t>(1, static_cast<size_t>(RENDER_WORK / perTransform));
+
+    cout << "audio " << audioText << ", render " << renderText << ", " << loadThreads << " load threads, "
+         << duration << " s per run" << endl;
+    cout << fixed << setprecision(2);
+    cout << "run        blocks  dropouts  late p99ms  late maxms  |  frames    p50ms    p95ms    p99ms    maxms"
+         << endl;
+
+    report("shared", run(duration, loadThreads, ThreadPolicy(), ThreadPolicy(), ThreadPolicy(), transforms));
+    lockProcessMemory();
+    report("isolated", run(duration, loadThreads, audio, render, load, transforms));
+    return 0;
+}
@@ -1,41 +1,17 @@
 #define _USE_MATH_DEFINES  //  Ensures M_PI is defined
 #include "BarVisualization.h"
 #include "ColorUtils.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
-BarVisualization::BarVisualization() : window(nullptr), vbo(0), vao(0), smoothedFFT(128, 0.0f) {}
+BarVisualization::BarVisualization() : vbo(0), vao(0), smoothedFFT(128, 0.0f), largestStep(0.0f) {}
 
 BarVisualization::~BarVisualization() {
     cleanup();
 }
 
-static void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);  // ✅ Update OpenGL viewport when the window resizes
-}
-
-bool BarVisualization::initialize(int windowWidth, int windowHeight) {
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW." << std::endl;
-        return false;
-    }
-
-    window = glfwCreateWindow(windowWidth, windowHeight, "Bar Visualization", nullptr, nullptr);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window." << std::endl;
-        glfwTerminate();
-        return false;
-    }
-
-    glfwMakeContextCurrent(window);
-    glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "Failed to initialize GLEW." << std::endl;
-        return false;
-    }
-
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
+bool BarVisualization::initialize() {
     glGenVertexArrays(1, &vao);
     glGenBuffers(1, &vbo);
 
@@ -50,29 +26,17 @@ bool BarVisualization::initialize(int windowWidth, int windowHeight) {
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-
-    shaderProgram = createShaderProgram("visualizations/vertexShader.glsl", "visualizations/fragmentShader.glsl");
-    if (shaderProgram == 0) {
-        std::cerr << "ERROR: Failed to create shader program!" << std::endl;
-        exit(1);
-    }
-
-    glUseProgram(shaderProgram);  // ✅ Ensure OpenGL uses the shaders
-
     return true;
 }
 
 void BarVisualization::render(const std::vector<float>& fftMagnitudes) {
-    glClear(GL_COLOR_BUFFER_BIT);
-    glUseProgram(shaderProgram);  // ✅ Ensure shaders are active before drawing
-
     if (fftMagnitudes.empty()) {
         std::cerr << "ERROR: No FFT data received!\n";
         return;
     }
 
-    size_t numBars = fftMagnitudes.size() / 8; // Reduce number of bars for clarity
+    groupBins(fftMagnitudes, quality.barCount, bands);
+    size_t numBars = bands.size();
     std::vector<float> vertices;
 
     float barWidth = 2.0f / numBars; // Normalize to OpenGL's -1 to 1 range
@@ -87,8 +51,8 @@ void BarVisualization::render(const std::vector<float>& fftMagnitudes) {
     // Find max magnitude for scaling
     float maxMagnitude = 0.0f;
     for (size_t i = 0; i < numBars; ++i) {
-        if (fftMagnitudes[i] > maxMagnitude) {
-            maxMagnitude = fftMagnitudes[i];
+        if (bands[i] > maxMagnitude) {
+            maxMagnitude = bands[i];
         }
     }
     if (maxMagnitude < 1e-6) {  // Prevent division by zero
@@ -96,9 +60,10 @@ void BarVisualization::render(const std::vector<float>& fftMagnitudes) {
     }
 
     float decayFactor = 0.9f;
+    largestStep = 0.0f;
 
     for (size_t i = 0; i < numBars; ++i) {
-        float rawMag = fftMagnitudes[i];
+        float rawMag = bands[i];
 
         // Normalize magnitude relative to the maxMagnitude
         float normalizedMag = rawMag / maxMagnitude;
@@ -107,14 +72,16 @@ void BarVisualization::render(const std::vector<float>& fftMagnitudes) {
         float logMag = log10(1 + normalizedMag * 10) / log10(2); // Scales between 0 and 1
 
         // Apply exponential smoothing to stabilize fluctuations
-        smoothedFFT[i] = (smoothedFFT[i] * decayFactor) + ((1.0f - decayFactor) * logMag);
+        float smoothed = (smoothedFFT[i] * decayFactor) + ((1.0f - decayFactor) * logMag);
+        largestStep = std::max(largestStep, std::fabs(smoothed - smoothedFFT[i]));
+        smoothedFFT[i] = smoothed;
 
         // Compute final height
         float height = smoothedFFT[i] * maxHeight;
         if (height < minHeight) height = minHeight;  // Prevents bars from disappearing
 
         float x = -1.0f + i * barWidth;
-        Color color = getColorFromMagnitude(smoothedFFT[i], 0.0f, 1.0f); // ✅ Dynamic color
+        Color color = paletteColor(smoothedFFT[i], 0.0f, 1.0f); // ✅ Dynamic color
 
         vertices.insert(vertices.end(), {
             x, -1.0f,   color.r, color.g, color.b,
@@ -132,19 +99,20 @@ void BarVisualization::render(const std::vector<float>& fftMagnitudes) {
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
 
     glBindVertexArray(vao);
-    glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 2);
+    glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 5);
+}
 
-    glfwSwapBuffers(window);
-    glfwPollEvents();
+bool BarVisualization::isSettled() const {
+    return largestStep < SETTLED_STEP;
 }
 
-bool BarVisualization::shouldClose() {
-    return glfwWindowShouldClose(window);
+PostEffects BarVisualization::postEffects() const {
+    return {0.0f, 0.5f, 0.6f};
 }
 
 void BarVisualization::cleanup() {
     if (vbo != 0) glDeleteBuffers(1, &vbo);
     if (vao != 0) glDeleteVertexArrays(1, &vao);
-    if (window) glfwDestroyWindow(window);
-    glfwTerminate();
+    vbo = 0;
+    vao = 0;
 }
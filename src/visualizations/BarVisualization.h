@@ -1,7 +1,6 @@
 #ifndef BAR_VISUALIZATION_H
 #define BAR_VISUALIZATION_H
 
-#include "..\ShaderUtils.h"
 #include "BaseVisualization.h"
 #include <vector>
 #include <GL/glew.h>
@@ -12,16 +11,17 @@ public:
     BarVisualization();
     ~BarVisualization();
 
-    bool initialize(int windowWidth, int windowHeight) override;
+    bool initialize() override;
     void render(const std::vector<float>& fftMagnitudes) override;
-    bool shouldClose() override;
+    bool isSettled() const override;
+    PostEffects postEffects() const override;
     void cleanup() override;
 
 private:
-    GLFWwindow* window;
     GLuint vbo, vao;
     std::vector<float> smoothedFFT;
-    GLuint shaderProgram;
+    float largestStep;  // biggest change to smoothedFFT in the last render
+    std::vector<float> bands;
 };
 
 #endif
@@ -1,5 +1,26 @@
 #include "BaseVisualization.h"
+#include <algorithm>
+#include <cmath>
 
-// Empty because all functions are pure virtual
-// This file ensures we have a proper class structure
+void BaseVisualization::groupBins(const std::vector<float>& magnitudes, size_t bands, std::vector<float>& out) const {
+    size_t range = std::max<size_t>(1, magnitudes.size() / 8);
+    range = std::min(range, magnitudes.size());
+    bands = std::min(bands, range);
 
+    out.resize(bands);
+    for (size_t b = 0; b < bands; ++b) {
+        size_t start, end;
+        if (bandScale == BandScale::Logarithmic) {
+            // Edges at range^(b/bands); the lowest groups are narrower than
+            // a bin, so they repeat a bin rather than come out empty.
+            start = b == 0 ? 0 : static_cast<size_t>(std::pow(static_cast<double>(range), double(b) / bands));
+            end = static_cast<size_t>(std::pow(static_cast<double>(range), double(b + 1) / bands));
+            end = std::min(range, std::max(end, start + 1));
+            start = std::min(start, end - 1);
+        } else {
+            start = b * range / bands;
+            end = (b + 1) * range / bands;
+        }
+        out[b] = *std::max_element(magnitudes.begin() + start, magnitudes.begin() + end);
+    }
+}
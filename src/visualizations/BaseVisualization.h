@@ -1,17 +1,82 @@
 #ifndef BASE_VISUALIZATION_H
 #define BASE_VISUALIZATION_H
 
+#include <cstddef>
 #include <vector>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+// Detail knobs the QualityGovernor turns to hold the frame budget.
+struct QualitySettings {
+    size_t fftSize;
+    size_t barCount;        // bars/points in the bar, circular bar and mountain scenes
+    size_t ringCount;       // rings drawn by CircleVisualization
+    size_t circleSegments;  // line segments per ring
+    size_t particleCount;   // particles simulated by ParticleVisualization
+    size_t terrainSize;     // rows (spectra) and columns of the terrain grid
+};
+
+// Matches what the scenes drew before quality scaling existed.
+const QualitySettings DEFAULT_QUALITY = {1024, 64, 64, 360, 262144, 512};
+
+// A smoothed level that moved less than this in a frame is holding still:
+// a ten-thousandth of the viewport, well under a pixel.
+const float SETTLED_STEP = 1e-4f;
+
+// How the bar-style scenes spread their groups over the spectrum.
+enum class BandScale {
+    Linear,      // equal bin counts per group
+    Logarithmic  // equal pitch range per group, more detail in the bass
+};
+
+// What a scene asks of the Renderer's post-processing chain. All zero,
+// the default, draws straight into the window with no extra passes.
+struct PostEffects {
+    float trailSeconds;    // time for trails to fade to 1/e; 0 for none
+    float bloom;           // strength of the glow added back; 0 for none
+    float bloomThreshold;  // brightness where the glow starts
+};
+
+struct AnalysisFrame;
+class ShaderManager;
+
+// Visualizations only own their GL resources. The window, context, clear,
+// shader program and buffer swap belong to the Renderer, which sets the
+// viewport before calling render() so several scenes can share one frame.
+// A scene that binds its own programs may leave them bound; the Renderer
+// rebinds the shared one for the next scene.
 class BaseVisualization {
 public:
+    BaseVisualization() : quality(DEFAULT_QUALITY), bandScale(BandScale::Linear), shaders(nullptr) {}
     virtual ~BaseVisualization() {}
-    virtual bool initialize(int windowWidth, int windowHeight) = 0;
+    virtual bool initialize() = 0;
+    // Called with the whole frame just before render(), for scenes that use
+    // more of the analysis than the magnitudes.
+    virtual void update(const AnalysisFrame& frame) {}
     virtual void render(const std::vector<float>& fftMagnitudes) = 0;
-    virtual bool shouldClose() = 0;
     virtual void cleanup() = 0;
+
+    virtual PostEffects postEffects() const { return {0.0f, 0.0f, 0.0f}; }
+    // True once drawing again, with the same frame or a new silent one,
+    // would repeat the picture. The Renderer only lets the IdleGovernor
+    // stop redrawing when every scene says so; scenes that never hold
+    // still (the particle field) keep the default.
+    virtual bool isSettled() const { return false; }
+
+    virtual void setQuality(const QualitySettings& settings) { quality = settings; }
+    void setBandScale(BandScale scale) { bandScale = scale; }
+    // Set by the Renderer before initialize(), for scenes with their own programs.
+    void setShaderManager(ShaderManager* manager) { shaders = manager; }
+
+protected:
+    // Splits the lowest eighth of the spectrum (the range the bar-style
+    // scenes display) into `bands` groups and keeps the loudest bin of each.
+    // Grouping by frequency keeps the picture stable when the FFT size changes.
+    void groupBins(const std::vector<float>& magnitudes, size_t bands, std::vector<float>& out) const;
+
+    QualitySettings quality;
+    BandScale bandScale;
+    ShaderManager* shaders;
 };
 
 #endif
@@ -1,78 +1,40 @@
 #define _USE_MATH_DEFINES
 #include "CircleVisualization.h"
 #include "ColorUtils.h"
+#include "RadialGeometry.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
-CircleVisualization::CircleVisualization() : window(nullptr), vbo(0), vao(0), smoothedFFT(128, 0.0f) {}
+CircleVisualization::CircleVisualization() : vbo(0), vao(0), smoothedFFT(128, 0.0f), largestStep(0.0f) {}
 
 CircleVisualization::~CircleVisualization() {
     cleanup();
 }
 
-static void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);  // ✅ Update OpenGL viewport when the window resizes
-}
-
-bool CircleVisualization::initialize(int windowWidth, int windowHeight) {
-    std::cerr << "DEBUG: Initializing Circle Visualization..." << std::endl;
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW." << std::endl;
-        return false;
-    }
-
-    window = glfwCreateWindow(windowWidth, windowHeight, "Circle Visualization", nullptr, nullptr);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window." << std::endl;
-        glfwTerminate();
-        return false;
-    }
-
-    glfwMakeContextCurrent(window);
-    glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "Failed to initialize GLEW." << std::endl;
-        return false;
-    }
-
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
+bool CircleVisualization::initialize() {
     glGenVertexArrays(1, &vao);
     glGenBuffers(1, &vbo);
 
     glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
-    // ✅ Define vertex attribute layout (Position: location 0)
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    // Position (location 0) and color (location 1); RadialGeometry::upload
+    // sets the pointers each frame.
     glEnableVertexAttribArray(0);
-
-    // ✅ Define vertex attribute layout (Color: location 1)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
-    shaderProgram = createShaderProgram("visualizations/vertexShader.glsl", "visualizations/fragmentShader.glsl");
-    if (shaderProgram == 0) {
-        std::cerr << "ERROR: Failed to create shader program!" << std::endl;
-        exit(1);
-    }
-
-    glUseProgram(shaderProgram);
-
     return true;
 }
 
 
 void CircleVisualization::render(const std::vector<float>& fftMagnitudes) {
-    glClear(GL_COLOR_BUFFER_BIT);
-
     if (fftMagnitudes.empty()) {
         std::cerr << "ERROR: No FFT data received!\n";
         return;
     }
 
     size_t numPoints = fftMagnitudes.size() ;
-    std::vector<float> vertices;
 
     if (smoothedFFT.size() != numPoints) {
         smoothedFFT.resize(numPoints, 0.0f);
@@ -84,64 +46,55 @@ void CircleVisualization::render(const std::vector<float>& fftMagnitudes) {
     }
 
     float decayFactor = 0.9f;
+    largestStep = 0.0f;
     for (size_t i = 0; i < numPoints; ++i) {
-        smoothedFFT[i] = (smoothedFFT[i] * decayFactor) + (fftMagnitudes[i] * (1.0f - decayFactor));
+        float smoothed = (smoothedFFT[i] * decayFactor) + (fftMagnitudes[i] * (1.0f - decayFactor));
+        largestStep = std::max(largestStep, std::fabs(smoothed - smoothedFFT[i]));
+        smoothedFFT[i] = smoothed;
     }
 
     float maxRadius = 0.9f;
     float minRadius = 0.1f;
-    float centerX = 0.0f, centerY = 0.0f;
 
-    for (size_t i = 0; i < numPoints; i += 8) {
-        float angleOffset = 2.0f * M_PI * i / numPoints;
+    size_t ringStep = std::max<size_t>(1, numPoints / quality.ringCount);
+    size_t segments = quality.circleSegments;
+
+    // Ring i is the same unit circle rotated by 2*pi*i/numPoints, so both
+    // come from cached direction tables.
+    const UnitDirections& circle = RadialGeometry::directions(segments);
+    const UnitDirections& offsets = RadialGeometry::directions(numPoints);
+
+    geometry.clear();
+    ringFirsts.clear();
+    ringCounts.clear();
+    for (size_t i = 0; i < numPoints; i += ringStep) {
         float magnitude = smoothedFFT[i];
         float radius = minRadius + (maxRadius - minRadius) * magnitude * 0.5f;
-    
-        std::vector<float> ringVertices;  // ✅ Store vertices for this ring only
-
-        Color color = getColorFromMagnitude(smoothedFFT[i], 0.0f, 1.0f);
-    
-        for (int j = 0; j < 360; j += 1) {
-            float theta = j * M_PI / 180.0f;
-            float x = centerX + radius * cos(theta + angleOffset);
-            float y = centerY + radius * sin(theta + angleOffset);
-    
-            float r = color.r;
-            float g = color.g;
-            float b = color.b;
-
-            // float r = 0.5f;
-            // float g = 0.5f;
-            // float b = 0.5f;
-            
-            ringVertices.insert(ringVertices.end(), {x, y, r, g, b});
-        }
-    
-        // ✅ Send this ring separately to OpenGL
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, ringVertices.size() * sizeof(float), ringVertices.data(), GL_DYNAMIC_DRAW);
-    
-        glBindVertexArray(vao);
-        glDrawArrays(GL_LINE_LOOP, 0, ringVertices.size() / 5);  // ✅ Draw only this ring
+
+        ringFirsts.push_back(static_cast<GLint>(geometry.vertexCount()));
+        ringCounts.push_back(static_cast<GLsizei>(segments));
+        geometry.appendCircle(circle, radius, offsets.cosines[i], offsets.sines[i]);
+        geometry.appendColor(paletteColor(magnitude, 0.0f, 1.0f), segments);
     }
 
-    glfwSwapBuffers(window);
-    glfwPollEvents();
+    // One upload and one draw call for every ring.
+    geometry.upload(vao, vbo);
+    glMultiDrawArrays(GL_LINE_LOOP, ringFirsts.data(), ringCounts.data(), static_cast<GLsizei>(ringFirsts.size()));
 }
 
 
-// bool CircleVisualization::shouldClose() {
-//     return glfwWindowShouldClose(window);
-// }
+// Rings leave a short wake as they pulse.
+bool CircleVisualization::isSettled() const {
+    return largestStep < SETTLED_STEP;
+}
 
-bool CircleVisualization::shouldClose() {
-    bool closed = glfwWindowShouldClose(window);
-    return closed;
+PostEffects CircleVisualization::postEffects() const {
+    return {0.3f, 0.8f, 0.5f};
 }
-    
+
 void CircleVisualization::cleanup() {
     if (vbo != 0) glDeleteBuffers(1, &vbo);
     if (vao != 0) glDeleteVertexArrays(1, &vao);
-    if (window) glfwDestroyWindow(window);
-    glfwTerminate();
+    vbo = 0;
+    vao = 0;
 }
@@ -2,7 +2,7 @@
 #define CIRCLE_VISUALIZATION_H
 
 #include "BaseVisualization.h"
-#include "..\ShaderUtils.h"
+#include "RadialGeometry.h"
 #include <vector>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -12,16 +12,20 @@ public:
     CircleVisualization();
     ~CircleVisualization();
 
-    bool initialize(int windowWidth, int windowHeight) override;
+    bool initialize() override;
     void render(const std::vector<float>& fftMagnitudes) override;
-    bool shouldClose() override;
+    bool isSettled() const override;
+    PostEffects postEffects() const override;
     void cleanup() override;
 
 private:
-    GLFWwindow* window;
     GLuint vbo, vao;
     std::vector<float> smoothedFFT;
-    GLint shaderProgram;
+    float largestStep;  // biggest change to smoothedFFT in the last render
+    std::vector<float> bands;
+    RadialGeometry geometry;
+    std::vector<GLint> ringFirsts;
+    std::vector<GLsizei> ringCounts;
 };
 
 #endif
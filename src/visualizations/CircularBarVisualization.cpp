@@ -1,153 +1,125 @@
-#define _USE_MATH_DEFINES
 #include "CircularBarVisualization.h"
 #include "ColorUtils.h"
+#include "RadialGeometry.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
-CircularBarVisualization::CircularBarVisualization() : window(nullptr), vbo(0), vao(0), smoothedFFT(128, 0.0f) {}
+CircularBarVisualization::CircularBarVisualization() : vbo(0), vao(0), ebo(0), indexedBars(0), smoothedFFT(128, 0.0f), largestStep(0.0f) {}
 
 CircularBarVisualization::~CircularBarVisualization() {
     cleanup();
 }
 
-static void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);  // ✅ Update OpenGL viewport when the window resizes
-}
-
-bool CircularBarVisualization::initialize(int windowWidth, int windowHeight) {
-    std::cerr << "DEBUG: Initializing Circular Bar Visualization..." << std::endl;
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW." << std::endl;
-        return false;
-    }
-
-    window = glfwCreateWindow(windowWidth, windowHeight, "Circular Bar Visualization", nullptr, nullptr);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window." << std::endl;
-        glfwTerminate();
-        return false;
-    }
-
-    glfwMakeContextCurrent(window);
-    glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "Failed to initialize GLEW." << std::endl;
-        return false;
-    }
-
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
+bool CircularBarVisualization::initialize() {
     glGenVertexArrays(1, &vao);
     glGenBuffers(1, &vbo);
 
     glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
-    // ✅ Define vertex attribute layout (Position: location 0)
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    // Position (location 0) and color (location 1); RadialGeometry::upload
+    // sets the pointers each frame.
     glEnableVertexAttribArray(0);
-
-    // ✅ Define vertex attribute layout (Color: location 1)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
-    std::cerr << "DEBUG: VAO and VBO configured successfully!" << std::endl;
-
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f); 
+    // The element buffer binding is VAO state, so it is made once here.
+    glGenBuffers(1, &ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 
-    shaderProgram = createShaderProgram("visualizations/vertexShader.glsl", "visualizations/fragmentShader.glsl");
-    if (shaderProgram == 0) {
-        std::cerr << "ERROR: Failed to create shader program!" << std::endl;
-        exit(1);
-    }
-    
+    std::cerr << "DEBUG: VAO and VBO configured successfully!" << std::endl;
 
     return true;
 }
 
 
 void CircularBarVisualization::render(const std::vector<float>& fftMagnitudes) {
-    glClear(GL_COLOR_BUFFER_BIT);
-    glUseProgram(shaderProgram);
-
     if (fftMagnitudes.empty()) {
         std::cerr << "ERROR: No FFT data received!\n";
         return;
     }
 
-    size_t numBars = fftMagnitudes.size() / 8; // Reduce number of bars for clarity
-    std::vector<float> vertices;
-    
+    groupBins(fftMagnitudes, quality.barCount, bands);
+    size_t numBars = bands.size();
+
     float innerRadius = 0.3f;  // Minimum radius for bars
     float maxHeight = 0.6f;    // Maximum extension
-    float angleStep = (2.0f * M_PI) / numBars;
-    
+    float barWidth = 0.4f;     // Fraction of the angle step each bar covers
+
+    if (smoothedFFT.size() != numBars) {
+        smoothedFFT.resize(numBars, 0.0f);
+    }
+
     // Smooth FFT values
     float decayFactor = 0.9f;
+    largestStep = 0.0f;
     for (size_t i = 0; i < numBars; ++i) {
-        smoothedFFT[i] = (smoothedFFT[i] * decayFactor) + (fftMagnitudes[i] * (1.0f - decayFactor));
+        float smoothed = (smoothedFFT[i] * decayFactor) + (bands[i] * (1.0f - decayFactor));
+        largestStep = std::max(largestStep, std::fabs(smoothed - smoothedFFT[i]));
+        smoothedFFT[i] = smoothed;
     }
 
+    size_t padded = RadialGeometry::paddedCount(numBars);
+    innerRadii.assign(padded, innerRadius);
+    outerRadii.assign(padded, innerRadius);
+    barColors.resize(numBars);
     for (size_t i = 0; i < numBars; ++i) {
-        float angle = i * angleStep;
-        float magnitude = smoothedFFT[i];
-        float barHeight = innerRadius + magnitude * maxHeight;
-        
-        // Compute bar endpoints
-        float x1 = innerRadius * cos(angle);
-        float y1 = innerRadius * sin(angle);
-        float x2 = barHeight * cos(angle);
-        float y2 = barHeight * sin(angle);
-
-        Color color = getColorFromMagnitude(magnitude, 0.0f, 1.0f); // Map to color
-
-        // Store triangle vertices (for bar width)
-        float barWidth = angleStep * 0.4f;  // Controls thickness
-        float x3 = innerRadius * cos(angle + barWidth);
-        float y3 = innerRadius * sin(angle + barWidth);
-        float x4 = barHeight * cos(angle + barWidth);
-        float y4 = barHeight * sin(angle + barWidth);
-
-        // Push triangle vertices to buffer
-        vertices.insert(vertices.end(), {
-            x1, y1, color.r, color.g, color.b,
-            x2, y2, color.r, color.g, color.b,
-            x3, y3, color.r, color.g, color.b,
-
-            x2, y2, color.r, color.g, color.b,
-            x3, y3, color.r, color.g, color.b,
-            x4, y4, color.r, color.g, color.b
-        });
+        outerRadii[i] = innerRadius + smoothedFFT[i] * maxHeight;
+        barColors[i] = paletteColor(smoothedFFT[i], 0.0f, 1.0f);
     }
 
-    // Send data to GPU
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+    // Four corner streams: leading inner, leading outer, trailing inner,
+    // trailing outer. The index buffer stitches them into two triangles
+    // per bar.
+    const UnitDirections& leading = RadialGeometry::directions(numBars);
+    const UnitDirections& trailing = RadialGeometry::directions(numBars, barWidth);
+    geometry.clear();
+    geometry.appendSpokes(leading, innerRadii.data());
+    geometry.appendSpokes(leading, outerRadii.data());
+    geometry.appendSpokes(trailing, innerRadii.data());
+    geometry.appendSpokes(trailing, outerRadii.data());
+    for (int corner = 0; corner < 4; ++corner) {
+        geometry.appendColors(barColors.data(), numBars);
+    }
 
-    glBindVertexArray(vao);
-    glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 5);
+    geometry.upload(vao, vbo);
+    if (indexedBars != numBars) {
+        updateIndices(numBars);
+    }
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(numBars * 6), GL_UNSIGNED_INT, (void*)0);
+}
+
+void CircularBarVisualization::updateIndices(size_t numBars) {
+    std::vector<GLuint> indices;
+    indices.reserve(numBars * 6);
+    GLuint n = static_cast<GLuint>(numBars);
+    for (GLuint i = 0; i < n; ++i) {
+        // Same winding the bars were drawn with as raw triangles.
+        indices.insert(indices.end(), {i, n + i, 2 * n + i, n + i, 2 * n + i, 3 * n + i});
+    }
 
-    glfwSwapBuffers(window);
-    glfwPollEvents();
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    indexedBars = numBars;
 }
 
 
 
-// bool CircleVisualization::shouldClose() {
-//     return glfwWindowShouldClose(window);
-// }
+bool CircularBarVisualization::isSettled() const {
+    return largestStep < SETTLED_STEP;
+}
 
-bool CircularBarVisualization::shouldClose() {
-    bool closed = glfwWindowShouldClose(window);
-    if (closed) {
-        std::cerr << "DEBUG: Window close detected!" << std::endl;
-    }
-    return closed;
+PostEffects CircularBarVisualization::postEffects() const {
+    return {0.2f, 0.6f, 0.5f};
 }
-    
+
 void CircularBarVisualization::cleanup() {
+    if (ebo != 0) glDeleteBuffers(1, &ebo);
     if (vbo != 0) glDeleteBuffers(1, &vbo);
     if (vao != 0) glDeleteVertexArrays(1, &vao);
-    if (window) glfwDestroyWindow(window);
-    glfwTerminate();
+    ebo = 0;
+    vbo = 0;
+    vao = 0;
+    indexedBars = 0;
 }
@@ -2,7 +2,8 @@
 #define CIRCULARBAR_H
 
 #include "BaseVisualization.h"
-#include "..\ShaderUtils.h"
+#include "ColorUtils.h"
+#include "RadialGeometry.h"
 #include <vector>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -12,16 +13,23 @@ public:
     CircularBarVisualization();
     ~CircularBarVisualization();
 
-    bool initialize(int windowWidth, int windowHeight) override;
+    bool initialize() override;
     void render(const std::vector<float>& fftMagnitudes) override;
-    bool shouldClose() override;
+    bool isSettled() const override;
+    PostEffects postEffects() const override;
     void cleanup() override;
 
 private:
-    GLFWwindow* window;
-    GLuint vbo, vao;
+    void updateIndices(size_t numBars);
+
+    GLuint vbo, vao, ebo;
+    size_t indexedBars;
     std::vector<float> smoothedFFT;
-    GLuint shaderProgram;
+    float largestStep;  // biggest change to smoothedFFT in the last render
+    std::vector<float> bands;
+    RadialGeometry geometry;
+    std::vector<float> innerRadii, outerRadii;
+    std::vector<Color> barColors;
 };
 
 #endif
\ No newline at end of file
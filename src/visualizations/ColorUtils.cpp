@@ -1,4 +1,5 @@
 #include "ColorUtils.h"
+#include <algorithm>
 #include <cmath>
 
 // HSV to RGB conversion
@@ -34,3 +35,27 @@ Color getColorFromMagnitude(float magnitude, float minMagnitude, float maxMagnit
     return hsvToRgb(hue, saturation, value);
 }
 
+
+// Full-value colours around the hue wheel. With saturation 1 every HSV
+// channel is value times a hue-only factor, so scaling an entry by the
+// value reproduces hsvToRgb exactly up to hue quantization.
+static const std::array<Color, PALETTE_SIZE>& huePalette() {
+    static const std::array<Color, PALETTE_SIZE> palette = [] {
+        std::array<Color, PALETTE_SIZE> table;
+        for (size_t i = 0; i < PALETTE_SIZE; ++i) {
+            table[i] = hsvToRgb(static_cast<float>(i) / PALETTE_SIZE, 1.0f, 1.0f);
+        }
+        return table;
+    }();
+    return palette;
+}
+
+Color paletteColor(float magnitude, float minMagnitude, float maxMagnitude) {
+    float normalized = std::max(0.0f, (magnitude - minMagnitude) / (maxMagnitude - minMagnitude));
+    float value = 0.7f + 0.3f * normalized;
+
+    float hue = normalized - std::floor(normalized);
+    size_t index = static_cast<size_t>(hue * PALETTE_SIZE) % PALETTE_SIZE;
+    const Color& base = huePalette()[index];
+    return {base.r * value, base.g * value, base.b * value};
+}
@@ -2,6 +2,7 @@
 #define COLOR_UTILS_H
 
 #include <array>  // ✅ Standard C++ header for fixed-size arrays
+#include <cstddef>
 
 struct Color {
     float r, g, b;
@@ -9,4 +10,10 @@ struct Color {
 
 Color getColorFromMagnitude(float magnitude, float minMagnitude, float maxMagnitude);
 
+// Same mapping as getColorFromMagnitude, but the hue comes from a table
+// built once, so per-vertex callers skip the HSV conversion. Hue is
+// quantized to PALETTE_SIZE steps.
+const size_t PALETTE_SIZE = 1024;
+Color paletteColor(float magnitude, float minMagnitude, float maxMagnitude);
+
 #endif  // COLOR_UTILS_H
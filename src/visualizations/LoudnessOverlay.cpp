@@ -0,0 +1,103 @@
+#include "LoudnessOverlay.h"
+#include <algorithm>
+
+static const float METER_MIN_DB = -60.0f;
+static const float TARGET_LUFS = -23.0f;
+
+// Maps a level in dB onto the strip's NDC height.
+static float levelToY(float db) {
+    float normalized = (std::max(db, METER_MIN_DB) - METER_MIN_DB) / -METER_MIN_DB;
+    return -1.0f + 2.0f * std::min(normalized, 1.0f);
+}
+
+LoudnessOverlay::LoudnessOverlay() : vbo(0), vao(0) {}
+
+LoudnessOverlay::~LoudnessOverlay() {
+    cleanup();
+}
+
+bool LoudnessOverlay::initialize() {
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    return true;
+}
+
+void LoudnessOverlay::addQuad(float x0, float y0, float x1, float y1, float r, float g, float b) {
+    vertices.insert(vertices.end(), {
+        x0, y0, r, g, b,
+        x1, y0, r, g, b,
+        x0, y1, r, g, b,
+
+        x1, y0, r, g, b,
+        x1, y1, r, g, b,
+        x0, y1, r, g, b
+    });
+}
+
+void LoudnessOverlay::addMeter(float x0, float x1, float level, float inner, float tick) {
+    addQuad(x0, -1.0f, x1, 1.0f, 0.12f, 0.12f, 0.12f);
+
+    float r = level > -6.0f ? 1.0f : (level > -18.0f ? 0.9f : 0.2f);
+    float g = level > -6.0f ? 0.2f : 0.8f;
+    addQuad(x0, -1.0f, x1, levelToY(level), r, g, 0.2f);
+
+    float inset = (x1 - x0) * 0.3f;
+    addQuad(x0 + inset, -1.0f, x1 - inset, levelToY(inner), 0.9f, 0.9f, 0.9f);
+
+    float y = levelToY(tick);
+    addQuad(x0, y - 0.01f, x1, y + 0.01f, 1.0f, 1.0f, 1.0f);
+}
+
+void LoudnessOverlay::build(const LoudnessReading& reading) {
+    vertices.clear();
+
+    // Four columns across the strip: L, R, momentary, short-term.
+    const float column = 2.0f / 4.0f;
+    const float gap = column * 0.15f;
+    for (int ch = 0; ch < 2; ++ch) {
+        float x0 = -1.0f + ch * column + gap;
+        addMeter(x0, x0 + column - 2.0f * gap, reading.peak[ch], reading.rms[ch], reading.truePeak[ch]);
+    }
+    for (int i = 0; i < 2; ++i) {
+        float x0 = -1.0f + (2 + i) * column + gap;
+        float level = i == 0 ? reading.momentary : reading.shortTerm;
+        addMeter(x0, x0 + column - 2.0f * gap, level, level, reading.integrated);
+    }
+
+    float target = levelToY(TARGET_LUFS);
+    addQuad(-1.0f + 2.0f * column, target - 0.005f, 1.0f, target + 0.005f, 0.3f, 0.5f, 1.0f);
+}
+
+// Compared as geometry rather than readings: levels keep falling through
+// silence long after the strip has clamped them at its floor.
+bool LoudnessOverlay::isSettled(const LoudnessReading& reading) {
+    build(reading);
+    return vertices == drawnVertices;
+}
+
+void LoudnessOverlay::render(const LoudnessReading& reading) {
+    build(reading);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 5);
+    drawnVertices.swap(vertices);
+}
+
+void LoudnessOverlay::cleanup() {
+    if (vbo != 0) glDeleteBuffers(1, &vbo);
+    if (vao != 0) glDeleteVertexArrays(1, &vao);
+    vbo = 0;
+    vao = 0;
+}
@@ -0,0 +1,32 @@
+#ifndef LOUDNESS_OVERLAY_H
+#define LOUDNESS_OVERLAY_H
+
+#include "../../audio/LoudnessMeter.h"
+#include <vector>
+#include <GL/glew.h>
+
+// Level meter strip drawn by the Renderer next to the scenes: sample peak
+// with an RMS core and true-peak tick for each channel, then momentary and
+// short-term loudness with the integrated value and -23 LUFS target marked.
+class LoudnessOverlay {
+public:
+    LoudnessOverlay();
+    ~LoudnessOverlay();
+
+    bool initialize();
+    void render(const LoudnessReading& reading);
+    // True when the reading would draw exactly what was drawn last time.
+    bool isSettled(const LoudnessReading& reading);
+    void cleanup();
+
+private:
+    void build(const LoudnessReading& reading);
+    void addQuad(float x0, float y0, float x1, float y1, float r, float g, float b);
+    void addMeter(float x0, float x1, float level, float inner, float tick);
+
+    GLuint vbo, vao;
+    std::vector<float> vertices;
+    std::vector<float> drawnVertices;
+};
+
+#endif
@@ -0,0 +1,97 @@
+#include "OscilloscopeVisualization.h"
+#include <algorithm>
+#include <cmath>
+
+static const double SWEEP_SECONDS = 0.02;
+static const double PERSISTENCE_SECONDS = 0.05;
+static const float HYSTERESIS = 0.05f;    // of the block's peak
+static const size_t MAX_SWEEPS = 64;      // per frame; after a stall only the latest are drawn
+static const float BEAM_INTENSITY = 0.5f;
+
+OscilloscopeVisualization::OscilloscopeVisualization()
+    : PhosphorScope(PERSISTENCE_SECONDS), armed(false), holdoffUntil(0), lastTrigger(0) {}
+
+size_t OscilloscopeVisualization::sweepFrames() const {
+    int rate = sampleRate > 0 ? sampleRate : 44100;
+    return static_cast<size_t>(SWEEP_SECONDS * rate);
+}
+
+size_t OscilloscopeVisualization::lookback() const {
+    // Enough to finish a sweep that started just before the new samples,
+    // including the pre-trigger part shown left of the trigger point.
+    return sweepFrames() + sweepFrames() / 4;
+}
+
+void OscilloscopeVisualization::consume(const float* samples, size_t history, size_t fresh, uint64_t start) {
+    size_t sweep = sweepFrames();
+    size_t pre = sweep / 4;
+    uint64_t first = start + history;
+    uint64_t end = first + fresh;
+    if (first < lastTrigger) {
+        // The feed started over.
+        pendingSweeps.clear();
+        armed = false;
+        holdoffUntil = lastTrigger = 0;
+    }
+
+    float peak = 0.0f;
+    for (size_t i = 0; i < fresh; ++i) {
+        const float* pair = samples + (history + i) * 2;
+        peak = std::max(peak, std::fabs(0.5f * (pair[0] + pair[1])));
+    }
+    float hysteresis = std::max(1e-4f, HYSTERESIS * peak);
+
+    for (size_t i = 0; i < fresh; ++i) {
+        const float* pair = samples + (history + i) * 2;
+        float mid = 0.5f * (pair[0] + pair[1]);
+        uint64_t t = first + i;
+        if (mid < -hysteresis) armed = true;
+
+        if (t < holdoffUntil) continue;
+        if (armed && mid >= 0.0f) {
+            pendingSweeps.push_back(t - std::min<uint64_t>(pre, t));
+            holdoffUntil = pendingSweeps.back() + sweep;
+            lastTrigger = t;
+            armed = false;
+        } else if (t >= lastTrigger + 2 * sweep) {
+            // Free run, back to back, until something triggers again.
+            pendingSweeps.push_back(t);
+            holdoffUntil = t + sweep;
+        }
+    }
+
+    sweepStarts.clear();
+    size_t kept = 0;
+    for (uint64_t sweepStart : pendingSweeps) {
+        if (sweepStart + sweep > end) {
+            pendingSweeps[kept++] = sweepStart;
+        } else if (sweepStart >= start) {
+            // Anything older fell out of the ring before it completed.
+            sweepStarts.push_back(static_cast<int>(sweepStart - start));
+        }
+    }
+    pendingSweeps.resize(kept);
+    if (sweepStarts.size() > MAX_SWEEPS) {
+        sweepStarts.erase(sweepStarts.begin(), sweepStarts.end() - MAX_SWEEPS);
+    }
+}
+
+void OscilloscopeVisualization::drawBeams(const ScopeUniforms& uniforms, int width, int height) {
+    GLsizei sweep = static_cast<GLsizei>(sweepFrames());
+    glUniform1i(uniforms.mode, 0);
+    glUniform1f(uniforms.span, static_cast<float>(sweep));
+    glUniform1f(uniforms.gain, 1.0f);
+
+    for (int channel = 0; channel < 2; ++channel) {
+        glUniform1i(uniforms.channel, channel);
+        if (channel == 0) {
+            glUniform3f(uniforms.color, 0.3f * BEAM_INTENSITY, 1.0f * BEAM_INTENSITY, 0.4f * BEAM_INTENSITY);
+        } else {
+            glUniform3f(uniforms.color, 0.3f * BEAM_INTENSITY, 0.7f * BEAM_INTENSITY, 1.0f * BEAM_INTENSITY);
+        }
+        for (int first : sweepStarts) {
+            glUniform1i(uniforms.first, first);
+            glDrawArrays(GL_LINE_STRIP, first, sweep);
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef OSCILLOSCOPE_VISUALIZATION_H
+#define OSCILLOSCOPE_VISUALIZATION_H
+
+#include "PhosphorScope.h"
+#include <cstdint>
+#include <vector>
+
+// Triggered oscilloscope: left channel in the upper lane, right in the
+// lower. Like an analog scope, every trigger (a rising zero crossing of
+// the mid signal, armed by a dip below a hysteresis band) starts one
+// 20 ms sweep, and the next can't fire until that sweep has ended, so
+// periodic material lands on the same spot sweep after sweep and every
+// sample is drawn about once. Without a trigger for two sweeps it free
+// runs, so silence and noise still show.
+class OscilloscopeVisualization : public PhosphorScope {
+public:
+    OscilloscopeVisualization();
+
+protected:
+    size_t lookback() const override;
+    void consume(const float* samples, size_t history, size_t fresh, uint64_t start) override;
+    void drawBeams(const ScopeUniforms& uniforms, int width, int height) override;
+
+private:
+    size_t sweepFrames() const;
+
+    bool armed;
+    uint64_t holdoffUntil;
+    uint64_t lastTrigger;
+    std::vector<uint64_t> pendingSweeps;  // absolute first sample of sweeps not yet complete
+    std::vector<int> sweepStarts;         // complete sweeps, as vertex indices into the upload
+};
+
+#endif
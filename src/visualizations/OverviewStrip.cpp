@@ -0,0 +1,112 @@
+#include "OverviewStrip.h"
+#include <algorithm>
+#include <cmath>
+
+// The lower lane spans this much either side of the playhead.
+static const double ZOOM_SECONDS = 4.0;
+static const float UNPLAYED_BRIGHTNESS = 0.45f;
+
+OverviewStrip::OverviewStrip() : vbo(0), vao(0) {}
+
+OverviewStrip::~OverviewStrip() {
+    cleanup();
+}
+
+bool OverviewStrip::initialize() {
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    return true;
+}
+
+void OverviewStrip::addQuad(float x0, float y0, float x1, float y1, float r, float g, float b) {
+    vertices.insert(vertices.end(), {
+        x0, y0, r, g, b,
+        x1, y0, r, g, b,
+        x0, y1, r, g, b,
+
+        x1, y0, r, g, b,
+        x1, y1, r, g, b,
+        x0, y1, r, g, b
+    });
+}
+
+void OverviewStrip::addLane(const WaveformPyramid& pyramid, double startFrame, double endFrame, double playhead,
+                            int width, float bottom, float top) {
+    addQuad(-1.0f, bottom, 1.0f, top, 0.08f, 0.08f, 0.08f);
+
+    pyramid.query(startFrame, endFrame, static_cast<size_t>(width), columns);
+    float centre = 0.5f * (bottom + top);
+    float half = 0.5f * (top - bottom);
+    float columnWidth = 2.0f / width;
+    double framesPerColumn = (endFrame - startFrame) / width;
+
+    for (int i = 0; i < width; ++i) {
+        const WaveformEntry& entry = columns[i];
+        if (entry.maximum <= entry.minimum) continue;
+
+        // Band amplitudes as the colour: red bass, green mids, blue highs.
+        float r = std::sqrt(entry.low), g = std::sqrt(entry.mid), b = std::sqrt(entry.high);
+        float strongest = std::max({r, g, b, 1e-6f});
+        float played = startFrame + (i + 0.5) * framesPerColumn <= playhead ? 1.0f : UNPLAYED_BRIGHTNESS;
+        r = (0.25f + 0.75f * r / strongest) * played;
+        g = (0.25f + 0.75f * g / strongest) * played;
+        b = (0.25f + 0.75f * b / strongest) * played;
+
+        float x0 = -1.0f + i * columnWidth;
+        float x1 = x0 + columnWidth;
+        float minimum = std::max(entry.minimum, -1.0f), maximum = std::min(entry.maximum, 1.0f);
+        addQuad(x0, centre + minimum * half, x1, centre + maximum * half, r, g, b);
+
+        float rms = std::min(std::sqrt(entry.power), 1.0f);
+        addQuad(x0, centre - rms * half, x1, centre + rms * half, 0.5f + 0.5f * r, 0.5f + 0.5f * g, 0.5f + 0.5f * b);
+    }
+
+    float x = -1.0f + 2.0f * static_cast<float>((playhead - startFrame) / (endFrame - startFrame));
+    addQuad(x - columnWidth, bottom, x + columnWidth, top, 1.0f, 1.0f, 1.0f);
+}
+
+void OverviewStrip::build(const WaveformPyramid& pyramid, size_t playhead, int width) {
+    vertices.clear();
+    if (width <= 0) return;
+
+    double total = static_cast<double>(pyramid.getFrameCount());
+    double position = static_cast<double>(std::min<size_t>(playhead, pyramid.getFrameCount()));
+    double zoom = ZOOM_SECONDS * pyramid.getSampleRate();
+
+    // Whole track on top, the zoomed window below, a hairline between.
+    addLane(pyramid, 0.0, total, position, width, 0.1f, 1.0f);
+    addLane(pyramid, position - zoom, position + zoom, position, width, -1.0f, 0.05f);
+}
+
+bool OverviewStrip::isSettled(const WaveformPyramid& pyramid, size_t playhead, int width) {
+    build(pyramid, playhead, width);
+    return vertices == drawnVertices;
+}
+
+void OverviewStrip::render(const WaveformPyramid& pyramid, size_t playhead, int width) {
+    build(pyramid, playhead, width);
+    if (vertices.empty()) return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 5);
+    drawnVertices.swap(vertices);
+}
+
+void OverviewStrip::cleanup() {
+    if (vbo != 0) glDeleteBuffers(1, &vbo);
+    if (vao != 0) glDeleteVertexArrays(1, &vao);
+    vbo = 0;
+    vao = 0;
+}
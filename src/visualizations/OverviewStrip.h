@@ -0,0 +1,38 @@
+#ifndef OVERVIEW_STRIP_H
+#define OVERVIEW_STRIP_H
+
+#include "../../audio/WaveformPyramid.h"
+#include <vector>
+#include <GL/glew.h>
+
+// Track overview drawn by the Renderer under the scenes. The upper lane is
+// the whole track, the lower one a few seconds either side of the playhead;
+// each pixel column is a min/max bar with an RMS core, tinted by its
+// low/mid/high energy and dimmed where it hasn't played yet. Both lanes are
+// pyramid queries, so a frame reads one or two entries per column.
+class OverviewStrip {
+public:
+    OverviewStrip();
+    ~OverviewStrip();
+
+    bool initialize();
+    // width is the strip's viewport width in pixels: one column each.
+    void render(const WaveformPyramid& pyramid, size_t playhead, int width);
+    // True when these arguments would draw exactly what was drawn last
+    // time; the zoomed lane scrolls, so only while the playhead stands.
+    bool isSettled(const WaveformPyramid& pyramid, size_t playhead, int width);
+    void cleanup();
+
+private:
+    void build(const WaveformPyramid& pyramid, size_t playhead, int width);
+    void addQuad(float x0, float y0, float x1, float y1, float r, float g, float b);
+    void addLane(const WaveformPyramid& pyramid, double startFrame, double endFrame, double playhead, int width,
+                 float bottom, float top);
+
+    GLuint vbo, vao;
+    std::vector<float> vertices;
+    std::vector<float> drawnVertices;
+    std::vector<WaveformEntry> columns;
+};
+
+#endif
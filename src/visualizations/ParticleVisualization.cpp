@@ -0,0 +1,181 @@
+#include "ParticleVisualization.h"
+#include "../../audio/AnalysisFrame.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// position (2), velocity (2), life in seconds and band (2)
+static const size_t PARTICLE_FLOATS = 6;
+
+static const float PEAK_DECAY = 0.995f;     // per frame, auto gain for quiet tracks
+static const float BEAT_DECAY = 0.85f;      // per frame
+static const float MAX_STEP = 0.05f;        // seconds; longer gaps are clamped
+
+ParticleVisualization::ParticleVisualization()
+    : updateShader(INVALID_SHADER), drawShader(INVALID_SHADER), updateProgram(0), drawProgram(0),
+      updateUniforms{-1, -1, -1, -1, -1}, drawUniforms{-1, -1}, vbo{0, 0}, vao{0, 0}, current(0),
+      particleCount(0), reset(true), bandLevels(PARTICLE_BANDS, 0.0f), bandPeak(1e-6f), beatPulse(0.0f),
+      lastSequence(0), frameIndex(0), lastTime(0.0) {}
+
+ParticleVisualization::~ParticleVisualization() {
+    cleanup();
+}
+
+bool ParticleVisualization::initialize() {
+    if (!shaders) {
+        std::cerr << "ERROR: Particle scene needs the Renderer's shader manager." << std::endl;
+        return false;
+    }
+    updateShader = shaders->load("particleUpdateShader.glsl", "",
+                                 {"outPosition", "outVelocity", "outLife"});
+    drawShader = shaders->load("particleVertexShader.glsl", "particleFragmentShader.glsl");
+    if (updateShader == INVALID_SHADER || drawShader == INVALID_SHADER) {
+        std::cerr << "ERROR: Failed to create particle shader programs!" << std::endl;
+        return false;
+    }
+
+    glGenVertexArrays(2, vao);
+    glGenBuffers(2, vbo);
+    for (size_t i = 0; i < 2; ++i) {
+        glBindVertexArray(vao[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo[i]);
+        GLsizei stride = PARTICLE_FLOATS * sizeof(float);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*)0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(2 * sizeof(float)));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(4 * sizeof(float)));
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+    }
+    glBindVertexArray(0);
+
+    allocateBuffers();
+    lastTime = glfwGetTime();
+    return true;
+}
+
+void ParticleVisualization::allocateBuffers() {
+    particleCount = quality.particleCount;
+    // Contents are left undefined: the first update step ignores its input
+    // and seeds every particle dead.
+    for (size_t i = 0; i < 2; ++i) {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo[i]);
+        glBufferData(GL_ARRAY_BUFFER, particleCount * PARTICLE_FLOATS * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+    }
+    reset = true;
+}
+
+void ParticleVisualization::lookUpUniforms() {
+    // Hot reload relinks into a new program, which invalidates locations.
+    GLuint program = shaders->program(updateShader);
+    if (program != updateProgram) {
+        updateProgram = program;
+        updateUniforms.bands = glGetUniformLocation(program, "uBands");
+        updateUniforms.beat = glGetUniformLocation(program, "uBeat");
+        updateUniforms.delta = glGetUniformLocation(program, "uDelta");
+        updateUniforms.frame = glGetUniformLocation(program, "uFrame");
+        updateUniforms.reset = glGetUniformLocation(program, "uReset");
+    }
+    program = shaders->program(drawShader);
+    if (program != drawProgram) {
+        drawProgram = program;
+        drawUniforms.scale = glGetUniformLocation(program, "uScale");
+        drawUniforms.pointSize = glGetUniformLocation(program, "uPointSize");
+    }
+}
+
+void ParticleVisualization::update(const AnalysisFrame& frame) {
+    // The display usually runs faster than the analysis hop; only a new
+    // frame moves the levels or fires a beat.
+    if (frame.sequence == lastSequence || frame.bands.empty()) return;
+    lastSequence = frame.sequence;
+
+    size_t perBand = std::max<size_t>(1, frame.bands.size() / PARTICLE_BANDS);
+    float loudest = 0.0f;
+    for (size_t b = 0; b < PARTICLE_BANDS; ++b) {
+        size_t start = std::min(b * perBand, frame.bands.size() - 1);
+        size_t end = std::min(start + perBand, frame.bands.size());
+        bandLevels[b] = *std::max_element(frame.bands.begin() + start, frame.bands.begin() + end);
+        loudest = std::max(loudest, bandLevels[b]);
+    }
+    bandPeak = std::max(loudest, bandPeak * PEAK_DECAY);
+    for (float& level : bandLevels) {
+        level = std::min(1.0f, level / bandPeak);
+    }
+
+    if (frame.beat) {
+        // Strength is in standard deviations of spectral flux.
+        beatPulse = std::max(beatPulse, std::min(1.0f, 0.3f + frame.beatStrength / 8.0f));
+    }
+}
+
+void ParticleVisualization::render(const std::vector<float>& fftMagnitudes) {
+    if (updateShader == INVALID_SHADER) return;
+    // The governor resizes the field by changing particleCount.
+    if (particleCount != quality.particleCount) {
+        allocateBuffers();
+    }
+    lookUpUniforms();
+
+    double now = glfwGetTime();
+    float delta = std::min(MAX_STEP, static_cast<float>(now - lastTime));
+    lastTime = now;
+
+    // Simulation step: read `current`, capture into the other buffer.
+    size_t next = 1 - current;
+    glUseProgram(updateProgram);
+    glUniform1fv(updateUniforms.bands, PARTICLE_BANDS, bandLevels.data());
+    glUniform1f(updateUniforms.beat, beatPulse);
+    glUniform1f(updateUniforms.delta, delta);
+    glUniform1ui(updateUniforms.frame, frameIndex++);
+    glUniform1i(updateUniforms.reset, reset ? 1 : 0);
+    reset = false;
+
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(vao[current]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, vbo[next]);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(particleCount));
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    current = next;
+
+    // Draw pass: keep the field round whatever the viewport's shape.
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    float aspect = viewport[3] > 0 ? static_cast<float>(viewport[2]) / viewport[3] : 1.0f;
+    float scaleX = aspect > 1.0f ? 1.0f / aspect : 1.0f;
+    float scaleY = aspect > 1.0f ? 1.0f : aspect;
+
+    glUseProgram(drawProgram);
+    glUniform2f(drawUniforms.scale, scaleX, scaleY);
+    // Fewer, larger points when the governor thins the field.
+    glUniform1f(drawUniforms.pointSize, particleCount > 300000 ? 1.5f : 2.5f);
+
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glBindVertexArray(vao[current]);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(particleCount));
+    glDisable(GL_BLEND);
+    glDisable(GL_PROGRAM_POINT_SIZE);
+    glBindVertexArray(0);
+
+    beatPulse *= BEAT_DECAY;
+}
+
+PostEffects ParticleVisualization::postEffects() const {
+    return {0.0f, 0.8f, 0.4f};
+}
+
+void ParticleVisualization::cleanup() {
+    if (vbo[0] != 0) glDeleteBuffers(2, vbo);
+    if (vao[0] != 0) glDeleteVertexArrays(2, vao);
+    vbo[0] = vbo[1] = 0;
+    vao[0] = vao[1] = 0;
+    // The programs belong to the shader manager.
+    updateShader = drawShader = INVALID_SHADER;
+    updateProgram = drawProgram = 0;
+    particleCount = 0;
+}
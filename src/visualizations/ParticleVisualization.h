@@ -0,0 +1,63 @@
+#ifndef PARTICLE_VISUALIZATION_H
+#define PARTICLE_VISUALIZATION_H
+
+#include "BaseVisualization.h"
+#include "../ShaderUtils.h"
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+// Bands the particle field reacts to, folded down from the analysis bands.
+const size_t PARTICLE_BANDS = 32;
+
+// A field of QualitySettings::particleCount particles that lives entirely on
+// the GPU. Each frame a vertex-only program steps every particle from one
+// buffer into the other by transform feedback, then the result is drawn as
+// additive points; the CPU only uploads the band levels, a beat pulse and
+// the clock.
+//
+// Every particle belongs to one band. A dead particle respawns near the
+// centre with a chance that follows its band's level, so the emission
+// pattern is the spectrum; beats kick everything outwards.
+class ParticleVisualization : public BaseVisualization {
+public:
+    ParticleVisualization();
+    ~ParticleVisualization();
+
+    bool initialize() override;
+    void update(const AnalysisFrame& frame) override;
+    void render(const std::vector<float>& fftMagnitudes) override;
+    PostEffects postEffects() const override;
+    void cleanup() override;
+
+private:
+    struct UpdateUniforms {
+        GLint bands, beat, delta, frame, reset;
+    };
+    struct DrawUniforms {
+        GLint scale, pointSize;
+    };
+
+    void allocateBuffers();
+    void lookUpUniforms();
+
+    ShaderHandle updateShader, drawShader;
+    GLuint updateProgram, drawProgram;  // programs the uniform locations belong to
+    UpdateUniforms updateUniforms;
+    DrawUniforms drawUniforms;
+
+    GLuint vbo[2], vao[2];
+    size_t current;         // buffer holding the latest state
+    size_t particleCount;   // what the buffers were allocated for
+    bool reset;
+
+    std::vector<float> bandLevels;
+    float bandPeak;
+    float beatPulse;
+    uint64_t lastSequence;
+    uint32_t frameIndex;
+    double lastTime;
+};
+
+#endif
@@ -0,0 +1,208 @@
+#include "PhosphorScope.h"
+#include "../../audio/AnalysisFrame.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+static const double MAX_STEP = 0.25;  // seconds; longer gaps fade as if this long
+static const double SETTLE_PERSISTENCES = 12.0;  // exp(-12): what is left is below one 8-bit step
+
+PhosphorScope::PhosphorScope(double persistenceSeconds)
+    : sampleRate(0), persistence(persistenceSeconds), scopeShader(INVALID_SHADER), phosphorShader(INVALID_SHADER),
+      scopeProgram(0), phosphorProgram(0), scopeUniforms{-1, -1, -1, -1, -1, -1, -1}, phosphorMode(-1),
+      phosphorDecay(-1), phosphorTexture(-1), sampleVbo(0), sampleVao(0), emptyVao(0), uploadedFrames(0),
+      framebuffer(0), texture(0), targetWidth(0), targetHeight(0), ring(nullptr), lastEnd(0), lastTime(0.0),
+      lastSignal(0.0) {}
+
+PhosphorScope::~PhosphorScope() {
+    cleanup();
+}
+
+bool PhosphorScope::initialize() {
+    if (!shaders) {
+        std::cerr << "ERROR: Scope scenes need the Renderer's shader manager." << std::endl;
+        return false;
+    }
+    scopeShader = shaders->load("scopeVertexShader.glsl", "scopeFragmentShader.glsl");
+    phosphorShader = shaders->load("phosphorVertexShader.glsl", "phosphorFragmentShader.glsl");
+    if (scopeShader == INVALID_SHADER || phosphorShader == INVALID_SHADER) {
+        std::cerr << "ERROR: Failed to create scope shader programs!" << std::endl;
+        return false;
+    }
+
+    glGenVertexArrays(1, &sampleVao);
+    glGenBuffers(1, &sampleVbo);
+    glBindVertexArray(sampleVao);
+    glBindBuffer(GL_ARRAY_BUFFER, sampleVbo);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    // The full-viewport passes make their vertices from gl_VertexID, but a
+    // core profile still wants a vertex array bound.
+    glGenVertexArrays(1, &emptyVao);
+    glBindVertexArray(0);
+
+    glGenFramebuffers(1, &framebuffer);
+    glGenTextures(1, &texture);
+    lastTime = glfwGetTime();
+    return true;
+}
+
+void PhosphorScope::lookUpUniforms() {
+    // Hot reload relinks into a new program, which invalidates locations.
+    GLuint program = shaders->program(scopeShader);
+    if (program != scopeProgram) {
+        scopeProgram = program;
+        scopeUniforms.mode = glGetUniformLocation(program, "uMode");
+        scopeUniforms.channel = glGetUniformLocation(program, "uChannel");
+        scopeUniforms.first = glGetUniformLocation(program, "uFirst");
+        scopeUniforms.span = glGetUniformLocation(program, "uSpan");
+        scopeUniforms.scale = glGetUniformLocation(program, "uScale");
+        scopeUniforms.gain = glGetUniformLocation(program, "uGain");
+        scopeUniforms.color = glGetUniformLocation(program, "uColor");
+    }
+    program = shaders->program(phosphorShader);
+    if (program != phosphorProgram) {
+        phosphorProgram = program;
+        phosphorMode = glGetUniformLocation(program, "uMode");
+        phosphorDecay = glGetUniformLocation(program, "uDecay");
+        phosphorTexture = glGetUniformLocation(program, "uPhosphor");
+    }
+}
+
+bool PhosphorScope::resizeTarget(int width, int height) {
+    // Half float so faint, heavily overlapped beams keep building up
+    // instead of rounding away in 8 bits.
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (complete) {
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    if (!complete) {
+        std::cerr << "ERROR: Scope accumulation buffer is incomplete." << std::endl;
+        return false;
+    }
+    targetWidth = width;
+    targetHeight = height;
+    return true;
+}
+
+void PhosphorScope::update(const AnalysisFrame& frame) {
+    // Frames arrive once per hop but the display usually runs faster; the
+    // counter tells which samples this scene has not drawn yet.
+    if (!frame.samples) return;
+    if (frame.samples != ring || frame.samplesEnd < lastEnd) {
+        ring = frame.samples;
+        lastEnd = frame.samplesEnd;
+    }
+    sampleRate = ring->getSampleRate();
+    if (frame.samplesEnd == lastEnd) return;
+    if (!frame.silent) lastSignal = glfwGetTime();
+
+    uint64_t end = frame.samplesEnd;
+    size_t readable = ring->capacity() / 2;
+    size_t fresh = static_cast<size_t>(std::min<uint64_t>(end - lastEnd, readable - lookback()));
+    size_t wanted = fresh + lookback();
+    samples.resize(wanted * 2);
+    size_t got = ring->read(end, wanted, samples.data());
+    samples.resize(got * 2);
+    lastEnd = end;
+
+    consume(samples.data(), got - fresh, fresh, end - got);
+    uploadedFrames = got;
+}
+
+void PhosphorScope::render(const std::vector<float>& fftMagnitudes) {
+    if (scopeShader == INVALID_SHADER) return;
+    lookUpUniforms();
+
+    // The Renderer may have bound a post-processing target; the present
+    // pass goes back to whatever that was.
+    GLint viewport[4], output = 0;
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &output);
+    int width = viewport[2], height = viewport[3];
+    if (width <= 0 || height <= 0) return;
+    if ((width != targetWidth || height != targetHeight) && !resizeTarget(width, height)) return;
+
+    double now = glfwGetTime();
+    double elapsed = std::min(MAX_STEP, now - lastTime);
+    lastTime = now;
+
+    // Orphan and refill: the driver hands back fresh storage instead of
+    // waiting for last frame's draws to finish with the old.
+    bool fresh = uploadedFrames > 0;
+    if (fresh) {
+        glBindBuffer(GL_ARRAY_BUFFER, sampleVbo);
+        glBufferData(GL_ARRAY_BUFFER, uploadedFrames * 2 * sizeof(float), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, uploadedFrames * 2 * sizeof(float), samples.data());
+        uploadedFrames = 0;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+    glEnable(GL_BLEND);
+
+    // Afterglow: scale what is there by the decay, then add the new beams.
+    glUseProgram(phosphorProgram);
+    glUniform1i(phosphorMode, 0);
+    glUniform1f(phosphorDecay, static_cast<float>(std::exp(-elapsed / persistence)));
+    glBlendFunc(GL_ZERO, GL_SRC_COLOR);
+    glBindVertexArray(emptyVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    if (fresh) {
+        glUseProgram(scopeProgram);
+        glBlendFunc(GL_ONE, GL_ONE);
+        glBindVertexArray(sampleVao);
+        drawBeams(scopeUniforms, width, height);
+    }
+
+    glDisable(GL_BLEND);
+    glBindFramebuffer(GL_FRAMEBUFFER, output);
+    glViewport(viewport[0], viewport[1], width, height);
+
+    glUseProgram(phosphorProgram);
+    glUniform1i(phosphorMode, 1);
+    glUniform1i(phosphorTexture, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindVertexArray(emptyVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+}
+
+// After a while without signal the afterglow has faded, or with a silent
+// feed has built up to the same flat trace every frame.
+bool PhosphorScope::isSettled() const {
+    return glfwGetTime() - lastSignal > SETTLE_PERSISTENCES * persistence;
+}
+
+// The phosphor already has its afterglow; only the glow is added.
+PostEffects PhosphorScope::postEffects() const {
+    return {0.0f, 0.6f, 0.5f};
+}
+
+void PhosphorScope::cleanup() {
+    if (sampleVbo != 0) glDeleteBuffers(1, &sampleVbo);
+    if (sampleVao != 0) glDeleteVertexArrays(1, &sampleVao);
+    if (emptyVao != 0) glDeleteVertexArrays(1, &emptyVao);
+    if (framebuffer != 0) glDeleteFramebuffers(1, &framebuffer);
+    if (texture != 0) glDeleteTextures(1, &texture);
+    sampleVbo = sampleVao = emptyVao = framebuffer = texture = 0;
+    targetWidth = targetHeight = 0;
+    // The programs belong to the shader manager.
+    scopeShader = phosphorShader = INVALID_SHADER;
+    scopeProgram = phosphorProgram = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef PHOSPHOR_SCOPE_H
+#define PHOSPHOR_SCOPE_H
+
+#include "BaseVisualization.h"
+#include "../ShaderUtils.h"
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+class SampleRing;
+
+// Common ground for the time-domain scenes. Each frame they take the raw
+// samples that arrived since the last one from the frame's SampleRing and
+// upload them as one vec2 (left, right) per sample, then beam them into a
+// half-float accumulation texture with additive blending. The texture is
+// faded by exp(-elapsed / persistence) first, which is the phosphor
+// afterglow, and tone-mapped onto the viewport last.
+class PhosphorScope : public BaseVisualization {
+public:
+    PhosphorScope(double persistenceSeconds);
+    ~PhosphorScope();
+
+    bool initialize() override;
+    void update(const AnalysisFrame& frame) override;
+    void render(const std::vector<float>& fftMagnitudes) override;
+    bool isSettled() const override;
+    PostEffects postEffects() const override;
+    void cleanup() override;
+
+protected:
+    struct ScopeUniforms {
+        GLint mode, channel, first, span, scale, gain, color;
+    };
+
+    // How many samples before the new ones the scene wants with them.
+    virtual size_t lookback() const = 0;
+    // Called from update() with `history` samples already seen followed by
+    // `fresh` new ones, interleaved, starting at absolute sample `start`.
+    virtual void consume(const float* samples, size_t history, size_t fresh, uint64_t start) = 0;
+    // Draws with the scope program bound, the samples passed to consume()
+    // in the bound vertex array and additive blending on.
+    virtual void drawBeams(const ScopeUniforms& uniforms, int width, int height) = 0;
+
+    std::vector<float> samples;  // what consume() last saw, as uploaded
+    int sampleRate;              // of the feed; 0 before the first frame
+
+private:
+    void lookUpUniforms();
+    bool resizeTarget(int width, int height);
+
+    double persistence;
+    ShaderHandle scopeShader, phosphorShader;
+    GLuint scopeProgram, phosphorProgram;
+    ScopeUniforms scopeUniforms;
+    GLint phosphorMode, phosphorDecay, phosphorTexture;
+
+    GLuint sampleVbo, sampleVao, emptyVao;
+    size_t uploadedFrames;     // frames in samples not yet sent to the GPU
+    GLuint framebuffer, texture;
+    int targetWidth, targetHeight;
+
+    const SampleRing* ring;
+    uint64_t lastEnd;
+    double lastTime;
+    double lastSignal;  // when samples above the silence level last arrived
+};
+
+#endif
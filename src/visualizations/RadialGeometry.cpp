@@ -0,0 +1,128 @@
+#define _USE_MATH_DEFINES
+#include "RadialGeometry.h"
+#include <cmath>
+#include <map>
+#include <utility>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static_assert(sizeof(Color) == 3 * sizeof(float), "Colors are uploaded as packed float triples");
+
+RadialGeometry::RadialGeometry() : vertices(0) {}
+
+size_t RadialGeometry::paddedCount(size_t count) {
+    return (count + 3) & ~static_cast<size_t>(3);
+}
+
+const UnitDirections& RadialGeometry::directions(size_t count, float phase) {
+    static std::map<std::pair<size_t, float>, UnitDirections> cache;
+
+    auto found = cache.find(std::make_pair(count, phase));
+    if (found != cache.end()) {
+        return found->second;
+    }
+
+    UnitDirections& dirs = cache[std::make_pair(count, phase)];
+    dirs.count = count;
+    dirs.cosines.assign(paddedCount(count), 0.0f);
+    dirs.sines.assign(paddedCount(count), 0.0f);
+    for (size_t i = 0; i < count; ++i) {
+        double angle = 2.0 * M_PI * (i + phase) / count;
+        dirs.cosines[i] = static_cast<float>(std::cos(angle));
+        dirs.sines[i] = static_cast<float>(std::sin(angle));
+    }
+    return dirs;
+}
+
+void RadialGeometry::clear() {
+    vertices = 0;
+    colors.clear();
+}
+
+float* RadialGeometry::reservePositions(size_t count) {
+    // Room for the padded tail the SIMD loops write; the next append
+    // overwrites it. Capacity only ever grows, so steady frames don't
+    // allocate.
+    size_t needed = (vertices + paddedCount(count)) * 2;
+    if (positions.size() < needed) {
+        positions.resize(needed);
+    }
+    float* out = positions.data() + vertices * 2;
+    vertices += count;
+    return out;
+}
+
+void RadialGeometry::appendCircle(const UnitDirections& dirs, float radius, float rotationCos, float rotationSin) {
+    float* out = reservePositions(dirs.count);
+    const float* cosines = dirs.cosines.data();
+    const float* sines = dirs.sines.data();
+    float scaledCos = radius * rotationCos;
+    float scaledSin = radius * rotationSin;
+
+#ifdef __SSE2__
+    __m128 rc = _mm_set1_ps(scaledCos);
+    __m128 rs = _mm_set1_ps(scaledSin);
+    for (size_t i = 0; i < dirs.count; i += 4) {
+        __m128 c = _mm_load_ps(cosines + i);
+        __m128 s = _mm_load_ps(sines + i);
+        __m128 x = _mm_sub_ps(_mm_mul_ps(c, rc), _mm_mul_ps(s, rs));
+        __m128 y = _mm_add_ps(_mm_mul_ps(s, rc), _mm_mul_ps(c, rs));
+        _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(x, y));
+        _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(x, y));
+    }
+#else
+    for (size_t i = 0; i < dirs.count; ++i) {
+        out[2 * i] = cosines[i] * scaledCos - sines[i] * scaledSin;
+        out[2 * i + 1] = sines[i] * scaledCos + cosines[i] * scaledSin;
+    }
+#endif
+}
+
+void RadialGeometry::appendSpokes(const UnitDirections& dirs, const float* radii) {
+    float* out = reservePositions(dirs.count);
+    const float* cosines = dirs.cosines.data();
+    const float* sines = dirs.sines.data();
+
+#ifdef __SSE2__
+    for (size_t i = 0; i < dirs.count; i += 4) {
+        __m128 r = _mm_loadu_ps(radii + i);
+        __m128 x = _mm_mul_ps(_mm_load_ps(cosines + i), r);
+        __m128 y = _mm_mul_ps(_mm_load_ps(sines + i), r);
+        _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(x, y));
+        _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(x, y));
+    }
+#else
+    for (size_t i = 0; i < dirs.count; ++i) {
+        out[2 * i] = cosines[i] * radii[i];
+        out[2 * i + 1] = sines[i] * radii[i];
+    }
+#endif
+}
+
+void RadialGeometry::appendColors(const Color* source, size_t count) {
+    colors.insert(colors.end(), source, source + count);
+}
+
+void RadialGeometry::appendColor(const Color& color, size_t count) {
+    colors.insert(colors.end(), count, color);
+}
+
+size_t RadialGeometry::vertexCount() const {
+    return vertices;
+}
+
+void RadialGeometry::upload(GLuint vao, GLuint vbo) {
+    size_t positionBytes = vertices * 2 * sizeof(float);
+    size_t colorBytes = vertices * sizeof(Color);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, positionBytes + colorBytes, nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, positionBytes, positions.data());
+    glBufferSubData(GL_ARRAY_BUFFER, positionBytes, colorBytes, colors.data());
+
+    // The colour block starts after however many positions this frame has.
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void*)positionBytes);
+}
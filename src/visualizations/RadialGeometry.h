@@ -0,0 +1,82 @@
+#ifndef RADIAL_GEOMETRY_H
+#define RADIAL_GEOMETRY_H
+
+#include "ColorUtils.h"
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <GL/glew.h>
+
+// 16-byte aligned storage so SIMD loops can use aligned loads.
+template <typename T>
+struct AlignedAllocator {
+    using value_type = T;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(16)));
+    }
+    void deallocate(T* pointer, size_t) {
+        ::operator delete(pointer, std::align_val_t(16));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+using AlignedFloats = std::vector<float, AlignedAllocator<float>>;
+
+// cos/sin of 2*pi*(i + phase)/count. The arrays are zero-padded to a
+// multiple of four so SIMD loops always read whole vectors.
+struct UnitDirections {
+    size_t count;
+    AlignedFloats cosines;
+    AlignedFloats sines;
+};
+
+// Vertex builder shared by the radial scenes. Directions come from tables
+// cached per (count, phase), so a frame costs multiply-adds rather than
+// trig calls, and the vertex storage is reused between frames.
+//
+// Positions and colours are kept in separate blocks and uploaded into one
+// buffer; callers append both in step.
+class RadialGeometry {
+public:
+    RadialGeometry();
+
+    // Built on first use and kept for the life of the program. Render
+    // thread only.
+    static const UnitDirections& directions(size_t count, float phase = 0.0f);
+    static size_t paddedCount(size_t count);
+
+    void clear();
+
+    // One vertex per direction at `radius`, with the whole set rotated by
+    // the angle whose cosine and sine are given.
+    void appendCircle(const UnitDirections& dirs, float radius, float rotationCos, float rotationSin);
+    // One vertex per direction at radii[i]; radii must hold
+    // paddedCount(dirs.count) entries.
+    void appendSpokes(const UnitDirections& dirs, const float* radii);
+    void appendColors(const Color* colors, size_t count);
+    void appendColor(const Color& color, size_t count);
+
+    size_t vertexCount() const;
+
+    // Uploads into vbo and points attributes 0 (position) and 1 (colour)
+    // of vao at it.
+    void upload(GLuint vao, GLuint vbo);
+
+private:
+    float* reservePositions(size_t count);
+
+    AlignedFloats positions;  // x, y pairs; may run past vertices by padding
+    std::vector<Color> colors;
+    size_t vertices;
+};
+
+#endif
@@ -0,0 +1,279 @@
+#include "TerrainVisualization.h"
+#include "../../audio/AnalysisFrame.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+static const float PEAK_DECAY = 0.995f;   // per spectrum, auto gain for quiet tracks
+static const float HEIGHT_SCALE = 0.6f;
+static const float DEPTH = 3.0f;
+
+// Camera above the newest row, looking down the valley of older ones.
+static const float EYE[3] = {0.0f, 0.9f, 0.8f};
+static const float TARGET[3] = {0.0f, 0.0f, -1.2f};
+static const float FIELD_OF_VIEW = 50.0f;  // degrees, vertical
+static const float NEAR_PLANE = 0.05f;
+static const float FAR_PLANE = 10.0f;
+
+// Vertices across the nearest rows. Bigger grids are max-filtered down to
+// this, so past it the cost stays flat and only the data gets finer.
+static const size_t NEAR_DETAIL = 256;
+
+// Vertex spacing in texels for a row `age` rows back: the near detail for
+// the nearest eighth, then doubling as the distance does.
+static size_t lodStep(size_t age, size_t rows) {
+    size_t base = std::max<size_t>(1, rows / NEAR_DETAIL);
+    if (age < rows / 8) return base;
+    if (age < rows / 4) return base * 2;
+    if (age < rows / 2) return base * 4;
+    return base * 8;
+}
+
+// 0, step, 2 step, ... and always the last index, so every row reaches
+// both edges and a coarse row's positions are a subset of a finer one's.
+static std::vector<size_t> samplePositions(size_t count, size_t step) {
+    std::vector<size_t> positions;
+    for (size_t i = 0; i + 1 < count; i += step) {
+        positions.push_back(i);
+    }
+    positions.push_back(count - 1);
+    return positions;
+}
+
+// Column-major perspective * look-at, as glUniformMatrix4fv takes it.
+static void viewProjection(float aspect, float* out) {
+    float forward[3] = {TARGET[0] - EYE[0], TARGET[1] - EYE[1], TARGET[2] - EYE[2]};
+    float length = std::sqrt(forward[0] * forward[0] + forward[1] * forward[1] + forward[2] * forward[2]);
+    for (float& f : forward) f /= length;
+    // side = forward x up(0, 1, 0), then up = side x forward.
+    float side[3] = {-forward[2], 0.0f, forward[0]};
+    length = std::sqrt(side[0] * side[0] + side[2] * side[2]);
+    side[0] /= length;
+    side[2] /= length;
+    float up[3] = {side[1] * forward[2] - side[2] * forward[1], side[2] * forward[0] - side[0] * forward[2],
+                   side[0] * forward[1] - side[1] * forward[0]};
+
+    float view[16] = {side[0], up[0], -forward[0], 0.0f,
+                      side[1], up[1], -forward[1], 0.0f,
+                      side[2], up[2], -forward[2], 0.0f,
+                      0.0f, 0.0f, 0.0f, 1.0f};
+    for (int i = 0; i < 3; ++i) {
+        view[12 + i] = -(view[i] * EYE[0] + view[4 + i] * EYE[1] + view[8 + i] * EYE[2]);
+    }
+
+    float focal = 1.0f / std::tan(FIELD_OF_VIEW * 3.14159265f / 360.0f);
+    float projection[16] = {focal / aspect, 0.0f, 0.0f, 0.0f,
+                            0.0f, focal, 0.0f, 0.0f,
+                            0.0f, 0.0f, (FAR_PLANE + NEAR_PLANE) / (NEAR_PLANE - FAR_PLANE), -1.0f,
+                            0.0f, 0.0f, 2.0f * FAR_PLANE * NEAR_PLANE / (NEAR_PLANE - FAR_PLANE), 0.0f};
+
+    for (int column = 0; column < 4; ++column) {
+        for (int r = 0; r < 4; ++r) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; ++k) {
+                sum += projection[k * 4 + r] * view[column * 4 + k];
+            }
+            out[column * 4 + r] = sum;
+        }
+    }
+}
+
+TerrainVisualization::TerrainVisualization()
+    : shader(INVALID_SHADER), program(0), uniforms{-1, -1, -1, -1, -1}, vbo(0), ibo(0), vao(0), texture(0),
+      gridSize(0), indexCount(0), newestRow(0), rowPending(false), quietRows(0), peak(1e-6f), lastSequence(0) {}
+
+TerrainVisualization::~TerrainVisualization() {
+    cleanup();
+}
+
+bool TerrainVisualization::initialize() {
+    if (!shaders) {
+        std::cerr << "ERROR: Terrain scene needs the Renderer's shader manager." << std::endl;
+        return false;
+    }
+    shader = shaders->load("terrainVertexShader.glsl", "fragmentShader.glsl");
+    if (shader == INVALID_SHADER) {
+        std::cerr << "ERROR: Failed to create terrain shader program!" << std::endl;
+        return false;
+    }
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ibo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    glGenTextures(1, &texture);
+    buildGrid();
+    return true;
+}
+
+void TerrainVisualization::buildGrid() {
+    gridSize = std::max<size_t>(quality.terrainSize, 16);
+    size_t columns = gridSize, rows = gridSize;
+
+    // Rows by distance, each with its own column spacing.
+    std::vector<size_t> ages = samplePositions(rows, 1);
+    ages.erase(std::remove_if(ages.begin(), ages.end(),
+                              [rows](size_t age) { return age + 1 < rows && age % lodStep(age, rows) != 0; }),
+               ages.end());
+
+    std::vector<float> vertices;
+    std::vector<size_t> rowStart;
+    std::vector<std::vector<size_t>> rowColumns;
+    for (size_t age : ages) {
+        // The footprint reaches to the next row, so no spectrum is skipped.
+        size_t step = lodStep(age, rows);
+        rowStart.push_back(vertices.size() / 3);
+        rowColumns.push_back(samplePositions(columns, step));
+        for (size_t column : rowColumns.back()) {
+            vertices.insert(vertices.end(), {static_cast<float>(column), static_cast<float>(age),
+                                             static_cast<float>(step)});
+        }
+    }
+
+    // Zip each pair of neighbouring rows into triangles, advancing along
+    // whichever row's next vertex is further left. Equal rows give quads;
+    // a row and its half-resolution neighbour share every coarse vertex,
+    // so there are no T-junctions. Nearest pair first, so the depth test
+    // rejects what ridges hide before it is shaded.
+    std::vector<GLuint> indices;
+    for (size_t r = 0; r + 1 < ages.size(); ++r) {
+        const std::vector<size_t>& nearRow = rowColumns[r];
+        const std::vector<size_t>& farRow = rowColumns[r + 1];
+        size_t i = 0, j = 0;
+        while (i + 1 < nearRow.size() || j + 1 < farRow.size()) {
+            GLuint a = static_cast<GLuint>(rowStart[r] + i);
+            GLuint b = static_cast<GLuint>(rowStart[r + 1] + j);
+            if (j + 1 >= farRow.size() || (i + 1 < nearRow.size() && nearRow[i + 1] <= farRow[j + 1])) {
+                indices.insert(indices.end(), {a, b, a + 1});
+                ++i;
+            } else {
+                indices.insert(indices.end(), {a, b, b + 1});
+                ++j;
+            }
+        }
+    }
+    indexCount = static_cast<GLsizei>(indices.size());
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    std::vector<float> flat(columns * rows, 0.0f);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, static_cast<GLsizei>(columns), static_cast<GLsizei>(rows), 0, GL_RED,
+                 GL_FLOAT, flat.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    newestRow = 0;
+    row.assign(columns, 0.0f);
+    rowPending = false;
+    quietRows = rows;
+}
+
+void TerrainVisualization::lookUpUniforms() {
+    // Hot reload relinks into a new program, which invalidates locations.
+    GLuint current = shaders->program(shader);
+    if (current != program) {
+        program = current;
+        uniforms.heights = glGetUniformLocation(program, "uHeights");
+        uniforms.newest = glGetUniformLocation(program, "uNewest");
+        uniforms.viewProjection = glGetUniformLocation(program, "uViewProjection");
+        uniforms.heightScale = glGetUniformLocation(program, "uHeightScale");
+        uniforms.depth = glGetUniformLocation(program, "uDepth");
+    }
+}
+
+void TerrainVisualization::update(const AnalysisFrame& frame) {
+    // One row per analysis frame; the display usually runs faster.
+    if (frame.sequence == lastSequence || frame.bands.empty() || row.empty()) return;
+    lastSequence = frame.sequence;
+    quietRows = frame.silent ? quietRows + 1 : 0;
+
+    const std::vector<float>& bands = frame.bands;
+    peak = std::max(*std::max_element(bands.begin(), bands.end()), peak * PEAK_DECAY);
+
+    // The bands are already log-spaced; stretch them across the columns.
+    float scale = static_cast<float>(bands.size() - 1) / (row.size() - 1);
+    for (size_t c = 0; c < row.size(); ++c) {
+        float position = c * scale;
+        size_t low = std::min(static_cast<size_t>(position), bands.size() - 1);
+        size_t high = std::min(low + 1, bands.size() - 1);
+        float level = bands[low] + (bands[high] - bands[low]) * (position - low);
+        row[c] = std::sqrt(std::min(1.0f, level / peak));
+    }
+    rowPending = true;
+}
+
+void TerrainVisualization::render(const std::vector<float>& fftMagnitudes) {
+    if (shader == INVALID_SHADER) return;
+    // The governor changes the grid through terrainSize.
+    if (gridSize != std::max<size_t>(quality.terrainSize, 16)) {
+        buildGrid();
+    }
+    lookUpUniforms();
+
+    if (rowPending) {
+        newestRow = (newestRow + 1) % static_cast<int>(gridSize);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, newestRow, static_cast<GLsizei>(gridSize), 1, GL_RED, GL_FLOAT,
+                        row.data());
+        rowPending = false;
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    float aspect = viewport[3] > 0 ? static_cast<float>(viewport[2]) / viewport[3] : 1.0f;
+    float matrix[16];
+    viewProjection(aspect, matrix);
+
+    glUseProgram(program);
+    glUniform1i(uniforms.heights, 0);
+    glUniform1i(uniforms.newest, newestRow);
+    glUniformMatrix4fv(uniforms.viewProjection, 1, GL_FALSE, matrix);
+    glUniform1f(uniforms.heightScale, HEIGHT_SCALE);
+    glUniform1f(uniforms.depth, DEPTH);
+
+    // Depth is cleared for this scene's viewport only; the others share
+    // the buffer.
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+    glEnable(GL_DEPTH_TEST);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_DEPTH_TEST);
+}
+
+// Silent rows are flat, so once they fill the grid, scrolling more in
+// changes nothing.
+bool TerrainVisualization::isSettled() const {
+    return gridSize > 0 && quietRows >= gridSize;
+}
+
+void TerrainVisualization::cleanup() {
+    if (vbo != 0) glDeleteBuffers(1, &vbo);
+    if (ibo != 0) glDeleteBuffers(1, &ibo);
+    if (vao != 0) glDeleteVertexArrays(1, &vao);
+    if (texture != 0) glDeleteTextures(1, &texture);
+    vbo = ibo = vao = texture = 0;
+    // The program belongs to the shader manager.
+    shader = INVALID_SHADER;
+    program = 0;
+    gridSize = 0;
+}
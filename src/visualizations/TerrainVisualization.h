@@ -0,0 +1,58 @@
+#ifndef TERRAIN_VISUALIZATION_H
+#define TERRAIN_VISUALIZATION_H
+
+#include "BaseVisualization.h"
+#include "../ShaderUtils.h"
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+// The mountain line carried back in time: the last terrainSize spectra
+// laid out as a heightfield, seen in perspective and scrolling away from
+// the viewer as new ones arrive.
+//
+// The grid and its index buffer are built once per size. Heights live in
+// a circular one-channel texture, one spectrum per row, that the vertex
+// shader reads, so a new spectrum costs a single row upload. Rows further
+// away use coarser vertices, each standing for the tallest texel it
+// covers, and rows of different resolution are zipped together so the
+// surface has no cracks. Triangles go front to back under a depth test
+// cleared for this viewport alone, so hidden slopes are rejected before
+// shading instead of painted over.
+class TerrainVisualization : public BaseVisualization {
+public:
+    TerrainVisualization();
+    ~TerrainVisualization();
+
+    bool initialize() override;
+    void update(const AnalysisFrame& frame) override;
+    void render(const std::vector<float>& fftMagnitudes) override;
+    bool isSettled() const override;
+    void cleanup() override;
+
+private:
+    struct Uniforms {
+        GLint heights, newest, viewProjection, heightScale, depth;
+    };
+
+    void buildGrid();
+    void lookUpUniforms();
+
+    ShaderHandle shader;
+    GLuint program;  // the program the uniform locations belong to
+    Uniforms uniforms;
+
+    GLuint vbo, ibo, vao, texture;
+    size_t gridSize;     // what the mesh and texture were built for
+    GLsizei indexCount;
+    int newestRow;
+
+    std::vector<float> row;  // the next spectrum, resampled to the grid
+    bool rowPending;
+    size_t quietRows;  // newest rows in a row from silent frames
+    float peak;
+    uint64_t lastSequence;
+};
+
+#endif
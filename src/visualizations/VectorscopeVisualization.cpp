@@ -0,0 +1,30 @@
+#include "VectorscopeVisualization.h"
+
+static const double PERSISTENCE_SECONDS = 0.1;
+// Per sample at 44.1 kHz; a frame overlaps hundreds of them, so it stays
+// faint and dense regions glow instead of saturating.
+static const float BEAM_INTENSITY = 0.1f;
+
+VectorscopeVisualization::VectorscopeVisualization() : PhosphorScope(PERSISTENCE_SECONDS), vertexCount(0) {}
+
+size_t VectorscopeVisualization::lookback() const {
+    // The last sample of the previous frame, so the line doesn't break.
+    return 1;
+}
+
+void VectorscopeVisualization::consume(const float* samples, size_t history, size_t fresh, uint64_t start) {
+    vertexCount = history + fresh;
+}
+
+void VectorscopeVisualization::drawBeams(const ScopeUniforms& uniforms, int width, int height) {
+    float aspect = static_cast<float>(width) / height;
+    float scaleX = aspect > 1.0f ? 1.0f / aspect : 1.0f;
+    float scaleY = aspect > 1.0f ? 1.0f : aspect;
+    float intensity = BEAM_INTENSITY * 44100.0f / (sampleRate > 0 ? sampleRate : 44100);
+
+    glUniform1i(uniforms.mode, 1);
+    glUniform2f(uniforms.scale, scaleX, scaleY);
+    glUniform1f(uniforms.gain, 1.0f);
+    glUniform3f(uniforms.color, 0.4f * intensity, 1.0f * intensity, 0.6f * intensity);
+    glDrawArrays(GL_LINE_STRIP, 0, static_cast<GLsizei>(vertexCount));
+}
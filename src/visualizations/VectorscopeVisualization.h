@@ -0,0 +1,23 @@
+#ifndef VECTORSCOPE_VISUALIZATION_H
+#define VECTORSCOPE_VISUALIZATION_H
+
+#include "PhosphorScope.h"
+
+// Goniometer: every sample since the last frame as one continuous line,
+// left against right rotated so mono is vertical and anti-phase is
+// horizontal. Wide stereo fills the square, narrow stereo is a thin
+// upright stroke.
+class VectorscopeVisualization : public PhosphorScope {
+public:
+    VectorscopeVisualization();
+
+protected:
+    size_t lookback() const override;
+    void consume(const float* samples, size_t history, size_t fresh, uint64_t start) override;
+    void drawBeams(const ScopeUniforms& uniforms, int width, int height) override;
+
+private:
+    size_t vertexCount;
+};
+
+#endif
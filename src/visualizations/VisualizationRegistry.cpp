@@ -0,0 +1,45 @@
+#include "VisualizationRegistry.h"
+#include "BarVisualization.h"
+#include "CircleVisualization.h"
+#include "CircularBarVisualization.h"
+#include "MountainVisualization.h"
+#include "OscilloscopeVisualization.h"
+#include "ParticleVisualization.h"
+#include "TerrainVisualization.h"
+#include "VectorscopeVisualization.h"
+#include <cstdlib>
+
+template <typename T>
+static std::unique_ptr<BaseVisualization> make() {
+    return std::make_unique<T>();
+}
+
+const std::vector<VisualizationEntry>& visualizationRegistry() {
+    static const std::vector<VisualizationEntry> registry = {
+        {"circle", "Circle Visualization", make<CircleVisualization>},
+        {"bar", "Bar Visualization", make<BarVisualization>},
+        {"circular-bar", "Circular Bar Visualization", make<CircularBarVisualization>},
+        {"mountain", "Mountain Visualization", make<MountainVisualization>},
+        {"particles", "Particle Field Visualization", make<ParticleVisualization>},
+        {"oscilloscope", "Oscilloscope Visualization", make<OscilloscopeVisualization>},
+        {"vectorscope", "Vectorscope Visualization", make<VectorscopeVisualization>},
+        {"terrain", "Spectral Terrain Visualization", make<TerrainVisualization>},
+    };
+    return registry;
+}
+
+std::unique_ptr<BaseVisualization> createVisualization(const std::string& key) {
+    const auto& registry = visualizationRegistry();
+    for (const auto& entry : registry) {
+        if (key == entry.name) {
+            return entry.create();
+        }
+    }
+
+    char* end = nullptr;
+    long number = std::strtol(key.c_str(), &end, 10);
+    if (!key.empty() && *end == '\0' && number >= 1 && static_cast<size_t>(number) <= registry.size()) {
+        return registry[number - 1].create();
+    }
+    return nullptr;
+}
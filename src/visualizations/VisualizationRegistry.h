@@ -0,0 +1,23 @@
+#ifndef VISUALIZATION_REGISTRY_H
+#define VISUALIZATION_REGISTRY_H
+
+#include "BaseVisualization.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+struct VisualizationEntry {
+    const char* name;   // used in configs and on the command line
+    const char* label;  // shown in the interactive menu
+    std::unique_ptr<BaseVisualization> (*create)();
+};
+
+// Every scene the app can build, in menu order. Adding a visualization
+// means adding a row here.
+const std::vector<VisualizationEntry>& visualizationRegistry();
+
+// Accepts a registry name or its 1-based menu number. Returns null for
+// anything else.
+std::unique_ptr<BaseVisualization> createVisualization(const std::string& key);
+
+#endif
@@ -0,0 +1,10 @@
+#version 330 core
+in vec3 vertexColor;
+out vec4 FragColor;
+
+void main() {
+    // Soft round points.
+    float falloff = 1.0 - length(gl_PointCoord * 2.0 - 1.0);
+    if (falloff <= 0.0) discard;
+    FragColor = vec4(vertexColor * falloff, 1.0);
+}
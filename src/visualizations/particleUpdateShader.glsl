@@ -0,0 +1,77 @@
+#version 330 core
+// One simulation step per particle, captured by transform feedback.
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inVelocity;
+layout(location = 2) in vec2 inLife;  // x: seconds left, y: band in [0, 1)
+
+out vec2 outPosition;
+out vec2 outVelocity;
+out vec2 outLife;
+
+uniform float uBands[32];  // 0..1, bass first
+uniform float uBeat;       // decaying pulse, 0..1
+uniform float uDelta;      // seconds since the last step
+uniform uint uFrame;
+uniform bool uReset;       // inputs are undefined; seed everything dead
+
+float random(uint seed) {
+    seed ^= seed >> 16;
+    seed *= 0x7feb352dU;
+    seed ^= seed >> 15;
+    seed *= 0x846ca68bU;
+    seed ^= seed >> 16;
+    return float(seed) / 4294967295.0;
+}
+
+void main() {
+    uint id = uint(gl_VertexID);
+    uint seed = id * 1664525U + uFrame * 1013904223U;
+
+    if (uReset) {
+        outPosition = vec2(0.0);
+        outVelocity = vec2(0.0);
+        outLife = vec2(-random(seed), random(id * 747796405U + 2891336453U));
+        return;
+    }
+
+    float band = inLife.y;
+    float level = uBands[min(int(band * 32.0), 31)];
+    vec2 position = inPosition;
+    vec2 velocity = inVelocity;
+    float life = inLife.x - uDelta;
+
+    if (life <= 0.0) {
+        // Respawn odds follow the band's level, so louder bands emit more;
+        // a beat opens every band at once.
+        float chance = (level * level * 6.0 + uBeat * 3.0) * uDelta;
+        if (random(seed) < chance) {
+            // Bass leaves from the bottom, treble from the top, mirrored
+            // left and right.
+            float side = random(seed + 1U) < 0.5 ? -1.0 : 1.0;
+            float angle = -1.5707963 + side * band * 3.1415927 + (random(seed + 2U) - 0.5) * 0.1;
+            vec2 direction = vec2(cos(angle), sin(angle));
+            float speed = 0.15 + level * 0.9 + uBeat * 0.6;
+            position = direction * (0.05 + 0.05 * random(seed + 3U));
+            velocity = direction * speed * (0.6 + 0.8 * random(seed + 4U));
+            life = 1.0 + 2.5 * random(seed + 5U);
+        }
+        outPosition = position;
+        outVelocity = velocity;
+        outLife = vec2(life, band);
+        return;
+    }
+
+    float radius = max(length(position), 1e-4);
+    vec2 outward = position / radius;
+    // Swirl, a beat kick outwards, the band's own push, a pull back towards
+    // the ring and drag.
+    velocity += vec2(-outward.y, outward.x) * 0.25 * uDelta;
+    velocity += outward * (uBeat * 2.0 + level * 0.3) * uDelta;
+    velocity -= outward * max(radius - 0.6, 0.0) * 1.5 * uDelta;
+    velocity *= exp(-0.9 * uDelta);
+    position += velocity * uDelta;
+
+    outPosition = position;
+    outVelocity = velocity;
+    outLife = vec2(life, band);
+}
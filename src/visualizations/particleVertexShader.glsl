@@ -0,0 +1,31 @@
+#version 330 core
+layout(location = 0) in vec2 aPosition;
+layout(location = 1) in vec2 aVelocity;
+layout(location = 2) in vec2 aLife;  // x: seconds left, y: band
+
+uniform vec2 uScale;       // keeps the field round in wide viewports
+uniform float uPointSize;
+
+out vec3 vertexColor;
+
+vec3 hueToRgb(float hue) {
+    vec3 rgb = clamp(abs(mod(hue * 6.0 + vec3(0.0, 4.0, 2.0), 6.0) - 3.0) - 1.0, 0.0, 1.0);
+    return rgb;
+}
+
+void main() {
+    if (aLife.x <= 0.0) {
+        // Dead: outside the clip volume.
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+        gl_PointSize = 1.0;
+        vertexColor = vec3(0.0);
+        return;
+    }
+
+    gl_Position = vec4(aPosition * uScale, 0.0, 1.0);
+    float speed = length(aVelocity);
+    gl_PointSize = uPointSize * (1.0 + min(speed, 1.0));
+    // Fade in the last second; additive blending does the rest.
+    float fade = min(aLife.x, 1.0) * 0.35;
+    vertexColor = hueToRgb(0.7 * (1.0 - aLife.y)) * fade;
+}
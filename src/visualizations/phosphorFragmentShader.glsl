@@ -0,0 +1,18 @@
+#version 330 core
+in vec2 texCoord;
+
+uniform sampler2D uPhosphor;
+uniform int uMode;      // 0: fade (multiplied in by blending), 1: present
+uniform float uDecay;
+
+out vec4 FragColor;
+
+void main() {
+    if (uMode == 0) {
+        FragColor = vec4(uDecay);
+    } else {
+        // Additive beams can pile up well past 1; compress instead of clip.
+        vec3 energy = texture(uPhosphor, texCoord).rgb;
+        FragColor = vec4(1.0 - exp(-energy), 1.0);
+    }
+}
@@ -0,0 +1,9 @@
+#version 330 core
+out vec2 texCoord;
+
+// One triangle covering the viewport, no vertex buffer needed.
+void main() {
+    vec2 corner = vec2(float((gl_VertexID & 1) << 2), float((gl_VertexID & 2) << 1)) - 1.0;
+    texCoord = corner * 0.5 + 0.5;
+    gl_Position = vec4(corner, 0.0, 1.0);
+}
@@ -0,0 +1,17 @@
+#version 330 core
+in vec2 texCoord;
+
+uniform sampler2D uSource;   // the scene
+uniform sampler2D uHistory;  // this frame's trail
+uniform sampler2D uBloom;    // the top of the bloom chain
+uniform bool uTrails;
+uniform float uBloomStrength;
+
+out vec4 FragColor;
+
+void main() {
+    vec3 color = texture(uSource, texCoord).rgb;
+    if (uTrails) color = max(color, texture(uHistory, texCoord).rgb);
+    if (uBloomStrength > 0.0) color += texture(uBloom, texCoord).rgb * uBloomStrength;
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,24 @@
+#version 330 core
+in vec2 texCoord;
+
+uniform sampler2D uSource;
+uniform vec2 uTexel;       // one uSource texel in texture coordinates
+uniform float uThreshold;  // 0 past the first level
+
+out vec4 FragColor;
+
+void main() {
+    // Dual filter: the diagonal taps land on texel corners, so each
+    // bilinear fetch already averages four texels.
+    vec3 color = texture(uSource, texCoord).rgb * 4.0;
+    color += texture(uSource, texCoord + vec2(-uTexel.x, -uTexel.y)).rgb;
+    color += texture(uSource, texCoord + vec2(uTexel.x, -uTexel.y)).rgb;
+    color += texture(uSource, texCoord + vec2(-uTexel.x, uTexel.y)).rgb;
+    color += texture(uSource, texCoord + vec2(uTexel.x, uTexel.y)).rgb;
+    color /= 8.0;
+
+    // Keep what is over the threshold, scaled down rather than cut so the
+    // glow fades in with brightness.
+    float brightness = max(color.r, max(color.g, color.b));
+    FragColor = vec4(color * max(brightness - uThreshold, 0.0) / max(brightness, 1e-4), 1.0);
+}
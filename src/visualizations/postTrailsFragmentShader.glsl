@@ -0,0 +1,21 @@
+#version 330 core
+in vec2 texCoord;
+
+uniform sampler2D uSource;   // the scene, full size
+uniform sampler2D uHistory;  // last frame's trail
+uniform vec2 uTexel;         // one scene pixel in texture coordinates
+uniform float uDecay;
+
+out vec4 FragColor;
+
+void main() {
+    // A trail pixel covers 2x2 or 4x4 scene pixels and sits on their
+    // corners; four bilinear fetches box the 4x4 around it, so thin lines
+    // can't fall between samples.
+    vec3 fresh = texture(uSource, texCoord + vec2(-uTexel.x, -uTexel.y)).rgb;
+    fresh += texture(uSource, texCoord + vec2(uTexel.x, -uTexel.y)).rgb;
+    fresh += texture(uSource, texCoord + vec2(-uTexel.x, uTexel.y)).rgb;
+    fresh += texture(uSource, texCoord + vec2(uTexel.x, uTexel.y)).rgb;
+    fresh *= 0.25;
+    FragColor = vec4(max(fresh, texture(uHistory, texCoord).rgb * uDecay), 1.0);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+in vec2 texCoord;
+
+uniform sampler2D uSource;  // the smaller level
+uniform vec2 uTexel;
+
+out vec4 FragColor;
+
+void main() {
+    // Dual filter: a tent of eight taps, added into the larger level by
+    // blending.
+    vec3 color = texture(uSource, texCoord + vec2(-uTexel.x, 0.0)).rgb;
+    color += texture(uSource, texCoord + vec2(uTexel.x, 0.0)).rgb;
+    color += texture(uSource, texCoord + vec2(0.0, -uTexel.y)).rgb;
+    color += texture(uSource, texCoord + vec2(0.0, uTexel.y)).rgb;
+    color += texture(uSource, texCoord + vec2(-uTexel.x, -uTexel.y) * 0.5).rgb * 2.0;
+    color += texture(uSource, texCoord + vec2(uTexel.x, -uTexel.y) * 0.5).rgb * 2.0;
+    color += texture(uSource, texCoord + vec2(-uTexel.x, uTexel.y) * 0.5).rgb * 2.0;
+    color += texture(uSource, texCoord + vec2(uTexel.x, uTexel.y) * 0.5).rgb * 2.0;
+    FragColor = vec4(color / 12.0, 1.0);
+}
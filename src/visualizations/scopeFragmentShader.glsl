@@ -0,0 +1,7 @@
+#version 330 core
+uniform vec3 uColor;  // already scaled by the beam intensity
+out vec4 FragColor;
+
+void main() {
+    FragColor = vec4(uColor, 1.0);
+}
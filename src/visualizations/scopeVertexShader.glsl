@@ -0,0 +1,23 @@
+#version 330 core
+layout(location = 0) in vec2 aSample;  // left, right
+
+uniform int uMode;       // 0: oscilloscope sweep, 1: goniometer
+uniform int uChannel;    // sweep: 0 left (upper lane), 1 right (lower lane)
+uniform int uFirst;      // sweep: vertex at the left edge
+uniform float uSpan;     // sweep: samples across the lane
+uniform vec2 uScale;     // goniometer: keeps it square in wide viewports
+uniform float uGain;
+
+void main() {
+    if (uMode == 0) {
+        float x = float(gl_VertexID - uFirst) / (uSpan - 1.0) * 2.0 - 1.0;
+        float sampleValue = uChannel == 0 ? aSample.x : aSample.y;
+        float lane = uChannel == 0 ? 0.5 : -0.5;
+        gl_Position = vec4(x, lane + clamp(sampleValue * uGain, -1.0, 1.0) * 0.45, 0.0, 1.0);
+    } else {
+        // Rotated 45 degrees: mono lies on the vertical, out of phase on
+        // the horizontal.
+        vec2 point = vec2(aSample.y - aSample.x, aSample.x + aSample.y) * 0.70710678 * uGain;
+        gl_Position = vec4(clamp(point, -1.0, 1.0) * uScale, 0.0, 1.0);
+    }
+}
@@ -0,0 +1,43 @@
+#version 330 core
+layout(location = 0) in vec3 aGrid;  // column, age in rows (0 newest), LOD step
+
+uniform sampler2D uHeights;  // one spectrum per row, written circularly
+uniform int uNewest;         // texture row holding age 0
+uniform mat4 uViewProjection;
+uniform float uHeightScale;
+uniform float uDepth;        // world distance from the newest row to the oldest
+
+out vec3 vertexColor;
+
+vec3 hueToRgb(float hue) {
+    vec3 rgb = clamp(abs(mod(hue * 6.0 + vec3(0.0, 4.0, 2.0), 6.0) - 3.0) - 1.0, 0.0, 1.0);
+    return rgb;
+}
+
+void main() {
+    ivec2 size = textureSize(uHeights, 0);
+    int column = int(aGrid.x);
+    int age = int(aGrid.y);
+    int lodStep = int(aGrid.z);
+
+    // A coarse vertex stands for the step x step texels around it. The
+    // tallest keeps distant peaks from flickering in and out as they
+    // scroll between vertices.
+    float height = 0.0;
+    for (int dy = -lodStep / 2; dy < (lodStep + 1) / 2; ++dy) {
+        int rowAge = clamp(age + dy, 0, size.y - 1);
+        int row = (uNewest - rowAge + size.y) % size.y;
+        for (int dx = -lodStep / 2; dx < (lodStep + 1) / 2; ++dx) {
+            int texelColumn = clamp(column + dx, 0, size.x - 1);
+            height = max(height, texelFetch(uHeights, ivec2(texelColumn, row), 0).r);
+        }
+    }
+
+    float x = aGrid.x / float(size.x - 1) * 2.0 - 1.0;
+    float distance = aGrid.y / float(size.y - 1);
+    gl_Position = uViewProjection * vec4(x, height * uHeightScale, -distance * uDepth, 1.0);
+
+    // Low ground is dim blue, peaks are bright red; the far end fades out.
+    float fade = 1.0 - 0.85 * distance;
+    vertexColor = hueToRgb(0.7 * (1.0 - height)) * (0.2 + 0.8 * height) * fade;
+}